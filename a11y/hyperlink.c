@@ -104,7 +104,7 @@ html_a11y_hyper_link_get_start_index (AtkHyperlink *link)
 {
 	HTMLA11YHyperLink *hl = HTML_A11Y_HYPER_LINK (link);
 	HTMLText *text = HTML_TEXT (HTML_A11Y_HTML (hl->a11y.object));
-	Link *a = (Link *) g_slist_nth_data (text->links, hl->num);
+	Link *a = text->links && (guint) hl->num < text->links->len ? (Link *) g_ptr_array_index (text->links, hl->num) : NULL;
 	return a ? a->start_offset : -1;
 }
 
@@ -112,7 +112,8 @@ static gint
 html_a11y_hyper_link_get_end_index (AtkHyperlink *link)
 {
 	HTMLA11YHyperLink *hl = HTML_A11Y_HYPER_LINK (link);
-	Link *a = (Link *) g_slist_nth_data (HTML_TEXT (HTML_A11Y_HTML (hl->a11y.object))->links, hl->num);
+	HTMLText *text = HTML_TEXT (HTML_A11Y_HTML (hl->a11y.object));
+	Link *a = text->links && (guint) hl->num < text->links->len ? (Link *) g_ptr_array_index (text->links, hl->num) : NULL;
 	return a ? a->end_offset : -1;
 }
 
@@ -145,7 +146,7 @@ html_a11y_hyper_link_new (HTMLA11Y *a11y, gint link_index)
 
 	hl->a11y.object = a11y;
 	hl->num = link_index;
-	hl->offset = ((Link *) g_slist_nth_data (HTML_TEXT (HTML_A11Y_HTML (a11y))->links, link_index))->start_offset;
+	hl->offset = ((Link *) g_ptr_array_index (HTML_TEXT (HTML_A11Y_HTML (a11y))->links, link_index))->start_offset;
 	g_object_add_weak_pointer (G_OBJECT (hl->a11y.object), &hl->a11y.weakref);
 
 	return ATK_HYPERLINK (hl);
@@ -270,6 +270,35 @@ editor_method_check_word (GtkHTML *html,
 	return correct;
 }
 
+static void
+editor_method_check_words (GtkHTML *html,
+                           gchar **words,
+                           GtkHTMLSpellCheckedFunc done,
+                           gpointer done_data,
+                           gpointer user_data)
+{
+	GtkhtmlEditor *editor = user_data;
+	GList *list;
+
+	list = editor->priv->active_spell_checkers;
+
+	/* If no spell checkers are active, assume the words are correct. */
+	if (list == NULL) {
+		gboolean *correct;
+		guint ii, length = g_strv_length (words);
+
+		correct = g_new (gboolean, length + 1);
+		for (ii = 0; ii < length; ii++)
+			correct[ii] = TRUE;
+		done (words, correct, done_data);
+		g_free (correct);
+		return;
+	}
+
+	gtkhtml_spell_checker_check_words_async (
+		list, words, (GtkhtmlSpellCheckerWordsFunc) done, done_data);
+}
+
 static void
 editor_method_suggestion_request (GtkHTML *html,
                                   gpointer user_data)
@@ -434,7 +463,8 @@ static GtkHTMLEditorAPI editor_api = {
 	editor_method_command,
 	editor_method_event,
 	editor_method_create_input_line,
-	editor_method_set_language
+	editor_method_set_language,
+	editor_method_check_words
 };
 
 static void
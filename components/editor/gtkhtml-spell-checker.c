@@ -26,6 +26,14 @@
 
 #include "gtkhtml-spell-marshal.h"
 
+/* Words checked with enchant are remembered, the cache is dropped
+ * when it grows past this or the dictionary changes. */
+#define MAX_CACHED_WORDS 16384
+
+/* Threads checking the words of gtkhtml_spell_checker_check_words_async,
+ * each of them loads its own dictionaries. */
+#define MAX_CHECK_THREADS 2
+
 #define GTKHTML_SPELL_CHECKER_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), GTKHTML_TYPE_SPELL_CHECKER, GtkhtmlSpellCheckerPrivate))
@@ -46,8 +54,41 @@ struct _GtkhtmlSpellCheckerPrivate {
 	EnchantDict *dict;
 	EnchantBroker *broker;
 	const GtkhtmlSpellLanguage *language;
+
+	/* word -> GINT_TO_POINTER (correct + 1) */
+	GHashTable *verdicts;
+
+	/* Words added in this process, the worker threads do not see
+	 * the session of our dictionary.  The generation changes with
+	 * the dictionary, the workers reload theirs then. */
+	GHashTable *added_words;
+	guint generation;
 };
 
+typedef struct {
+	GPtrArray *checkers;
+	gchar **codes;
+	guint *generations;
+	gchar **words;
+	guint n_words;
+	gint8 *verdicts;	/* checker * n_words + word, -1 unknown */
+	GtkhtmlSpellCheckerWordsFunc callback;
+	gpointer user_data;
+} CheckWordsJob;
+
+typedef struct {
+	EnchantDict *dict;
+	guint generation;
+} WorkerDict;
+
+typedef struct {
+	EnchantBroker *broker;
+	GHashTable *dicts;	/* language code -> WorkerDict */
+} Worker;
+
+static GThreadPool *check_words_pool;
+static GPrivate *worker_private;
+
 static gpointer parent_class;
 static guint signals[LAST_SIGNAL];
 
@@ -80,6 +121,44 @@ spell_checker_is_digit (const gchar *text,
 	return TRUE;
 }
 
+/* Returns the length of the word to look up, 0 when it is always
+ * correct. */
+static gssize
+spell_checker_word_length (const gchar *word,
+                           gssize length)
+{
+	if (length < 0)
+		length = strlen (word);
+
+	if (spell_checker_is_digit (word, length))
+		return 0;
+
+	/* Exclude apostrophies from the end of words. */
+	while (length > 0 && word[length - 1] == '\'')
+		length--;
+
+	return length;
+}
+
+static void
+spell_checker_cache (GtkhtmlSpellChecker *checker,
+                     gchar *key,
+                     gboolean correct)
+{
+	GHashTable *verdicts = checker->priv->verdicts;
+
+	if (g_hash_table_size (verdicts) >= MAX_CACHED_WORDS)
+		g_hash_table_remove_all (verdicts);
+	g_hash_table_insert (verdicts, key, GINT_TO_POINTER (correct + 1));
+}
+
+static void
+spell_checker_changed (GtkhtmlSpellChecker *checker)
+{
+	g_hash_table_remove_all (checker->priv->verdicts);
+	checker->priv->generation++;
+}
+
 static EnchantDict *
 spell_checker_request_dict (GtkhtmlSpellChecker *checker)
 {
@@ -173,6 +252,8 @@ spell_checker_finalize (GObject *object)
 	if (priv->dict != NULL)
 		enchant_broker_free_dict (priv->broker, priv->dict);
 	enchant_broker_free (priv->broker);
+	g_hash_table_destroy (priv->verdicts);
+	g_hash_table_destroy (priv->added_words);
 
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -243,6 +324,10 @@ spell_checker_init (GtkhtmlSpellChecker *checker)
 {
 	checker->priv = GTKHTML_SPELL_CHECKER_GET_PRIVATE (checker);
 	checker->priv->broker = enchant_broker_init ();
+	checker->priv->verdicts = g_hash_table_new_full (
+		g_str_hash, g_str_equal, g_free, NULL);
+	checker->priv->added_words = g_hash_table_new_full (
+		g_str_hash, g_str_equal, g_free, NULL);
 }
 
 GType
@@ -292,6 +377,8 @@ gtkhtml_spell_checker_check_word (GtkhtmlSpellChecker *checker,
                                   gssize length)
 {
 	EnchantDict *dict;
+	gchar *key;
+	gpointer verdict;
 	gint result;
 
 	g_return_val_if_fail (GTKHTML_IS_SPELL_CHECKER (checker), FALSE);
@@ -300,22 +387,28 @@ gtkhtml_spell_checker_check_word (GtkhtmlSpellChecker *checker,
 	if ((dict = spell_checker_request_dict (checker)) == NULL)
 		return FALSE;
 
-	if (length < 0)
-		length = strlen (word);
-
-	if (spell_checker_is_digit (word, length))
+	if ((length = spell_checker_word_length (word, length)) == 0)
 		return TRUE;
 
-	/* Exclude apostrophies from the end of words. */
-	while (word[length - 1] == '\'')
-		length--;
+	key = g_strndup (word, length);
+
+	verdict = g_hash_table_lookup (checker->priv->verdicts, key);
+	if (verdict != NULL) {
+		g_free (key);
+		return GPOINTER_TO_INT (verdict) - 1;
+	}
 
 	result = enchant_dict_check (dict, word, length);
 
-	if (result < 0)
+	if (result < 0) {
 		g_warning (
 			"Error checking word '%s' (%s)",
 			word, enchant_dict_get_error (dict));
+		g_free (key);
+		return FALSE;
+	}
+
+	spell_checker_cache (checker, key, result == 0);
 
 	return (result == 0);
 }
@@ -377,6 +470,11 @@ gtkhtml_spell_checker_add_word (GtkhtmlSpellChecker *checker,
 		return;
 
 	enchant_dict_add_to_pwl (dict, word, length);
+	spell_checker_changed (checker);
+	g_hash_table_insert (
+		checker->priv->added_words,
+		length < 0 ? g_strdup (word) : g_strndup (word, length),
+		GINT_TO_POINTER (TRUE));
 	g_signal_emit (G_OBJECT (checker), signals[ADDED], 0, word, length);
 }
 
@@ -393,6 +491,11 @@ gtkhtml_spell_checker_add_word_to_session (GtkhtmlSpellChecker *checker,
 		return;
 
 	enchant_dict_add_to_session (dict, word, length);
+	spell_checker_changed (checker);
+	g_hash_table_insert (
+		checker->priv->added_words,
+		length < 0 ? g_strdup (word) : g_strndup (word, length),
+		GINT_TO_POINTER (TRUE));
 	g_signal_emit (G_OBJECT (checker), signals[ADDED_TO_SESSION], 0, word, length);
 }
 
@@ -409,6 +512,8 @@ gtkhtml_spell_checker_clear_session (GtkhtmlSpellChecker *checker)
 		enchant_broker_free_dict (priv->broker, priv->dict);
 		priv->dict = NULL;
 	}
+	spell_checker_changed (checker);
+	g_hash_table_remove_all (priv->added_words);
 
 	if (priv->language == NULL)
 		priv->language = gtkhtml_spell_language_lookup (NULL);
@@ -428,3 +533,245 @@ gtkhtml_spell_checker_compare (GtkhtmlSpellChecker *checker_a,
 
 	return gtkhtml_spell_language_compare (language_a, language_b);
 }
+
+static void
+worker_dict_free (WorkerDict *worker_dict,
+                  EnchantBroker *broker)
+{
+	if (worker_dict->dict != NULL)
+		enchant_broker_free_dict (broker, worker_dict->dict);
+	g_free (worker_dict);
+}
+
+static void
+worker_free (Worker *worker)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init (&iter, worker->dicts);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		worker_dict_free (value, worker->broker);
+	g_hash_table_destroy (worker->dicts);
+	enchant_broker_free (worker->broker);
+	g_free (worker);
+}
+
+static EnchantDict *
+worker_request_dict (const gchar *code,
+                     guint generation)
+{
+	Worker *worker;
+	WorkerDict *worker_dict;
+
+	worker = g_private_get (worker_private);
+	if (worker == NULL) {
+		worker = g_new (Worker, 1);
+		worker->broker = enchant_broker_init ();
+		worker->dicts = g_hash_table_new_full (
+			g_str_hash, g_str_equal, g_free, NULL);
+		g_private_set (worker_private, worker);
+	}
+
+	worker_dict = g_hash_table_lookup (worker->dicts, code);
+	if (worker_dict != NULL && worker_dict->generation != generation) {
+		/* Pick up the words added to the personal dictionary. */
+		g_hash_table_remove (worker->dicts, code);
+		worker_dict_free (worker_dict, worker->broker);
+		worker_dict = NULL;
+	}
+
+	if (worker_dict == NULL) {
+		worker_dict = g_new (WorkerDict, 1);
+		worker_dict->dict = enchant_broker_request_dict (
+			worker->broker, code);
+		worker_dict->generation = generation;
+		g_hash_table_insert (
+			worker->dicts, g_strdup (code), worker_dict);
+	}
+
+	return worker_dict->dict;
+}
+
+static void
+check_words_job_free (CheckWordsJob *job)
+{
+	g_ptr_array_foreach (job->checkers, (GFunc) g_object_unref, NULL);
+	g_ptr_array_free (job->checkers, TRUE);
+	g_free (job->codes);
+	g_free (job->generations);
+	g_strfreev (job->words);
+	g_free (job->verdicts);
+	g_free (job);
+}
+
+/* Runs on the main loop when the words are checked. */
+static gboolean
+check_words_done (CheckWordsJob *job)
+{
+	gboolean *correct;
+	guint ii, jj;
+
+	correct = g_new0 (gboolean, job->n_words + 1);
+
+	for (ii = 0; ii < job->checkers->len; ii++) {
+		GtkhtmlSpellChecker *checker;
+		GtkhtmlSpellCheckerPrivate *priv;
+
+		checker = g_ptr_array_index (job->checkers, ii);
+		priv = checker->priv;
+
+		for (jj = 0; jj < job->n_words; jj++) {
+			const gchar *word = job->words[jj];
+			gint8 verdict = job->verdicts[ii * job->n_words + jj];
+			gssize length;
+
+			length = spell_checker_word_length (word, -1);
+			if (length == 0) {
+				correct[jj] = TRUE;
+				continue;
+			}
+
+			if (verdict == 1)
+				correct[jj] = TRUE;
+
+			if (verdict >= 0 && job->generations[ii] == priv->generation)
+				spell_checker_cache (
+					checker, g_strndup (word, length),
+					verdict == 1);
+
+			if (g_hash_table_lookup (priv->added_words, word))
+				correct[jj] = TRUE;
+		}
+	}
+
+	job->callback (job->words, correct, job->user_data);
+
+	g_free (correct);
+	check_words_job_free (job);
+
+	return FALSE;
+}
+
+static void
+check_words_thread (CheckWordsJob *job,
+                    gpointer unused)
+{
+	guint ii, jj;
+
+	for (ii = 0; ii < job->checkers->len; ii++) {
+		EnchantDict *dict;
+
+		dict = worker_request_dict (
+			job->codes[ii], job->generations[ii]);
+		if (dict == NULL)
+			continue;
+
+		for (jj = 0; jj < job->n_words; jj++) {
+			const gchar *word = job->words[jj];
+			gint8 *verdict = &job->verdicts[ii * job->n_words + jj];
+			gssize length;
+
+			if (*verdict >= 0)
+				continue;
+
+			length = spell_checker_word_length (word, -1);
+			if (length > 0)
+				*verdict = (enchant_dict_check (
+					dict, word, length) == 0);
+		}
+	}
+
+	g_idle_add ((GSourceFunc) check_words_done, job);
+}
+
+/* Checks the words in worker threads and calls back on the main loop.
+ * A word is correct when any of the checkers knows it, like a loop over
+ * gtkhtml_spell_checker_check_word().  Cached words are not looked up
+ * again. */
+void
+gtkhtml_spell_checker_check_words_async (GList *checkers,
+                                         gchar **words,
+                                         GtkhtmlSpellCheckerWordsFunc callback,
+                                         gpointer user_data)
+{
+	CheckWordsJob *job;
+	gboolean unknown = FALSE;
+	guint ii, jj;
+
+	g_return_if_fail (words != NULL);
+	g_return_if_fail (callback != NULL);
+
+	job = g_new0 (CheckWordsJob, 1);
+	job->checkers = g_ptr_array_new ();
+	job->words = g_strdupv (words);
+	job->n_words = g_strv_length (words);
+	job->callback = callback;
+	job->user_data = user_data;
+
+	for (; checkers != NULL; checkers = g_list_next (checkers)) {
+		GtkhtmlSpellChecker *checker = checkers->data;
+
+		/* Same as the synchronous check without a dictionary. */
+		if (checker->priv->language == NULL)
+			continue;
+		g_ptr_array_add (job->checkers, g_object_ref (checker));
+	}
+
+	job->codes = g_new (gchar *, job->checkers->len);
+	job->generations = g_new (guint, job->checkers->len);
+	job->verdicts = g_new (gint8, job->checkers->len * job->n_words);
+	memset (job->verdicts, -1, job->checkers->len * job->n_words);
+
+	for (ii = 0; ii < job->checkers->len; ii++) {
+		GtkhtmlSpellChecker *checker;
+
+		checker = g_ptr_array_index (job->checkers, ii);
+		job->codes[ii] = (gchar *) gtkhtml_spell_language_get_code (
+			checker->priv->language);
+		job->generations[ii] = checker->priv->generation;
+
+		for (jj = 0; jj < job->n_words; jj++) {
+			const gchar *word = job->words[jj];
+			gssize length;
+			gchar *key;
+			gpointer verdict;
+
+			length = spell_checker_word_length (word, -1);
+			if (length == 0)
+				continue;
+
+			key = g_strndup (word, length);
+			verdict = g_hash_table_lookup (
+				checker->priv->verdicts, key);
+			g_free (key);
+
+			if (verdict != NULL)
+				job->verdicts[ii * job->n_words + jj] =
+					GPOINTER_TO_INT (verdict) - 1;
+			else
+				unknown = TRUE;
+		}
+	}
+
+	if (!unknown) {
+		g_idle_add ((GSourceFunc) check_words_done, job);
+		return;
+	}
+
+	if (check_words_pool == NULL && g_thread_supported ()) {
+		worker_private = g_private_new ((GDestroyNotify) worker_free);
+		check_words_pool = g_thread_pool_new (
+			(GFunc) check_words_thread, NULL,
+			MAX_CHECK_THREADS, FALSE, NULL);
+	}
+
+	if (check_words_pool != NULL)
+		g_thread_pool_push (check_words_pool, job, NULL);
+	else {
+		if (worker_private == NULL)
+			worker_private = g_private_new (
+				(GDestroyNotify) worker_free);
+		check_words_thread (job, NULL);
+	}
+}
@@ -51,6 +51,11 @@ typedef struct _GtkhtmlSpellChecker GtkhtmlSpellChecker;
 typedef struct _GtkhtmlSpellCheckerClass GtkhtmlSpellCheckerClass;
 typedef struct _GtkhtmlSpellCheckerPrivate GtkhtmlSpellCheckerPrivate;
 
+typedef void	(*GtkhtmlSpellCheckerWordsFunc)
+					(gchar **words,
+					 const gboolean *correct,
+					 gpointer user_data);
+
 struct _GtkhtmlSpellChecker {
 	GObject parent;
 	GtkhtmlSpellCheckerPrivate *priv;
@@ -102,6 +107,11 @@ void		gtkhtml_spell_checker_clear_session
 gint		gtkhtml_spell_checker_compare
 					(GtkhtmlSpellChecker *checker_a,
 					 GtkhtmlSpellChecker *checker_b);
+void		gtkhtml_spell_checker_check_words_async
+					(GList *checkers,
+					 gchar **words,
+					 GtkhtmlSpellCheckerWordsFunc callback,
+					 gpointer user_data);
 
 G_END_DECLS
 
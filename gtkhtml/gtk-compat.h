@@ -20,6 +20,21 @@
 			cairo_region_union_rectangle ((region), (rect)); \
 	} G_STMT_END
 
+#define gdk_region_empty(region)	cairo_region_is_empty (region)
+
+static inline void
+gdk_region_get_rectangles (cairo_region_t *region,
+                           GdkRectangle **rectangles,
+                           gint *n_rectangles)
+{
+	gint i, n = cairo_region_num_rectangles (region);
+
+	*rectangles = g_new (GdkRectangle, n);
+	for (i = 0; i < n; i++)
+		cairo_region_get_rectangle (region, i, &(*rectangles)[i]);
+	*n_rectangles = n;
+}
+
 #endif
 
 #endif /* __GTK_COMPAT_H__ */
@@ -182,3 +182,33 @@ gtk_html_engine_search_incremental (GtkHTML *html, const gchar *text, gboolean f
 {
 	return html_engine_search_incremental (html->engine, text, forward);
 }
+
+void
+gtk_html_search_all (GtkHTML *html, const gchar *text, gboolean case_sensitive, gboolean regular, gboolean highlight)
+{
+	html_engine_search_all (html->engine, text, case_sensitive, regular, highlight);
+}
+
+gboolean
+gtk_html_search_all_done (GtkHTML *html)
+{
+	return html_engine_search_all_done (html->engine);
+}
+
+guint
+gtk_html_search_all_get_count (GtkHTML *html)
+{
+	return html_engine_search_all_get_count (html->engine);
+}
+
+gboolean
+gtk_html_search_all_select (GtkHTML *html, guint n)
+{
+	return html_engine_search_all_select (html->engine, n);
+}
+
+void
+gtk_html_search_all_clear (GtkHTML *html)
+{
+	html_engine_search_all_clear (html->engine);
+}
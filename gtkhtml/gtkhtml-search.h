@@ -41,4 +41,16 @@ gboolean  gtk_html_engine_search_incremental  (GtkHTML     *html,
 					       const gchar *text,
 					       gboolean     forward);
 
+/* find all, the matches are counted in the background */
+void      gtk_html_search_all                 (GtkHTML     *html,
+					       const gchar *text,
+					       gboolean     case_sensitive,
+					       gboolean     regular,
+					       gboolean     highlight);
+gboolean  gtk_html_search_all_done            (GtkHTML     *html);
+guint     gtk_html_search_all_get_count       (GtkHTML     *html);
+gboolean  gtk_html_search_all_select          (GtkHTML     *html,
+					       guint        n);
+void      gtk_html_search_all_clear           (GtkHTML     *html);
+
 #endif
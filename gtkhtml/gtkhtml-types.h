@@ -52,6 +52,11 @@ typedef void   (* GtkHTMLStreamWriteFunc) (GtkHTMLStream *stream,
 					   gsize size,
 					   gpointer user_data);
 
+/* correct holds a verdict for each of the words */
+typedef void   (* GtkHTMLSpellCheckedFunc) (gchar **words,
+					    const gboolean *correct,
+					    gpointer user_data);
+
 /* FIXME 1st param should be Engine */
 typedef gboolean (* GtkHTMLSaveReceiverFn)   (gpointer     engine,
 					      const gchar *data,
@@ -834,6 +834,8 @@ destroy (GtkObject *object)
 	}
 
 	if (html->engine) {
+		/* the engine may outlive the widget its spell checking uses */
+		html_engine_spell_check_cancel (html->engine);
 		g_object_unref (G_OBJECT (html->engine));
 		html->engine = NULL;
 	}
@@ -4316,6 +4318,35 @@ gtk_html_get_caret_mode(const GtkHTML *html)
 	return html->engine->caret_mode;
 }
 
+/**
+ * gtk_html_set_tile_cache:
+ * @html: a GtkHTML widget
+ * @enable: whether to cache the rendered document
+ *
+ * When enabled and @html is not editable, the rendered document is kept
+ * in offscreen tiles and exposes are painted from them instead of drawing
+ * the document again. Tiles are rendered on demand, prefetched around the
+ * visible area when idle and dropped when their part of the document
+ * changes.
+ **/
+void
+gtk_html_set_tile_cache (GtkHTML *html, gboolean enable)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+	g_return_if_fail (HTML_IS_ENGINE (html->engine));
+
+	html_engine_set_tile_cache (html->engine, enable);
+}
+
+gboolean
+gtk_html_get_tile_cache (const GtkHTML *html)
+{
+	g_return_val_if_fail (GTK_IS_HTML (html), FALSE);
+	g_return_val_if_fail (HTML_IS_ENGINE (html->engine), FALSE);
+
+	return html->engine->tile_cache != NULL;
+}
+
 /**
  * gtk_html_set_caret_first_focus_anchor:
  * When setting focus to the GtkHTML first time and is in caret mode,
@@ -6518,6 +6549,81 @@ gtk_html_set_images_blocking (GtkHTML *html, gboolean block)
 	html->engine->block_images = block;
 }
 
+/**
+ * gtk_html_set_progressive:
+ * @html: the GtkHTML widget
+ * @progressive: whether to build the document while it is loading
+ *
+ * When set, complete top level blocks are turned into objects and laid
+ * out while the stream is still open, instead of after its end.
+ **/
+void
+gtk_html_set_progressive (GtkHTML *html, gboolean progressive)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+
+	html_engine_set_progressive (html->engine, progressive);
+}
+
+gboolean
+gtk_html_get_progressive (GtkHTML *html)
+{
+	g_return_val_if_fail (GTK_IS_HTML (html), FALSE);
+
+	return html_engine_get_progressive (html->engine);
+}
+
+/**
+ * gtk_html_set_streaming:
+ * @html: the GtkHTML widget
+ * @streaming: whether to drop the parse tree while it is built
+ *
+ * When set, the document is built progressively as the parser closes
+ * its elements, and the parsed nodes are freed once they have been
+ * turned into objects, so that the whole parse tree never has to be
+ * kept in memory next to the objects.
+ **/
+void
+gtk_html_set_streaming (GtkHTML *html, gboolean streaming)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+
+	html_engine_set_streaming (html->engine, streaming);
+}
+
+gboolean
+gtk_html_get_streaming (GtkHTML *html)
+{
+	g_return_val_if_fail (GTK_IS_HTML (html), FALSE);
+
+	return html_engine_get_streaming (html->engine);
+}
+
+/**
+ * gtk_html_set_threaded_parsing:
+ * @html: the GtkHTML widget
+ * @threaded: whether to parse in a worker thread
+ *
+ * When set, the document is parsed and styled in a worker thread and
+ * built progressively from the main loop, so that loading a large
+ * document doesn't block the user interface.
+ **/
+void
+gtk_html_set_threaded_parsing (GtkHTML *html, gboolean threaded)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+
+	html_engine_set_threaded (html->engine, threaded);
+}
+
+gboolean
+gtk_html_get_threaded_parsing (GtkHTML *html)
+{
+	g_return_val_if_fail (GTK_IS_HTML (html), FALSE);
+
+	return html_engine_get_threaded (html->engine);
+}
+
 gint
 gtk_html_print_page_get_pages_num (GtkHTML *html,
 				   GtkPrintContext *context,
@@ -128,6 +128,10 @@ struct _GtkHTMLEditorAPI
 
 	/* spell checking methods */
 	void      (* set_language)            (GtkHTML *html, const gchar *language, gpointer data);
+
+	/* optional, checks the words off the main loop and calls done there */
+	void      (* check_words)             (GtkHTML *html, gchar **words,
+					       GtkHTMLSpellCheckedFunc done, gpointer done_data, gpointer data);
 };
 
 /* Creation.  */
@@ -215,6 +219,11 @@ void                       gtk_html_set_caret_mode                (GtkHTML
 								   gboolean                   caret_mode);
 gboolean                   gtk_html_get_caret_mode                (const GtkHTML             *html);
 
+/* Render cache for read-only views */
+void                       gtk_html_set_tile_cache                (GtkHTML                   *html,
+								   gboolean                   enable);
+gboolean                   gtk_html_get_tile_cache                (const GtkHTML             *html);
+
 void			   gtk_html_set_caret_first_focus_anchor  (GtkHTML		     *html,
 								   const gchar                *name);
 
@@ -329,6 +338,15 @@ void                       gtk_html_set_blocking                  (GtkHTML
 								   gboolean                   block);
 void                       gtk_html_set_images_blocking           (GtkHTML                   *html,
 								   gboolean                   block);
+void                       gtk_html_set_progressive               (GtkHTML                   *html,
+								   gboolean                   progressive);
+gboolean                   gtk_html_get_progressive               (GtkHTML                   *html);
+void                       gtk_html_set_streaming                 (GtkHTML                   *html,
+								   gboolean                   streaming);
+gboolean                   gtk_html_get_streaming                 (GtkHTML                   *html);
+void                       gtk_html_set_threaded_parsing          (GtkHTML                   *html,
+								   gboolean                   threaded);
+gboolean                   gtk_html_get_threaded_parsing          (GtkHTML                   *html);
 gboolean                   gtk_html_has_undo                      (GtkHTML                   *html);
 void                       gtk_html_drop_undo                     (GtkHTML                   *html);
 gchar *                     gtk_html_get_url_at                    (GtkHTML                   *html,
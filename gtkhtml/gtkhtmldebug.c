@@ -461,11 +461,11 @@ gtk_html_debug_list_text_attrs (HTMLText *text)
 void
 gtk_html_debug_list_links (HTMLText *text)
 {
-	GSList *l;
+	guint i;
 
-	for (l = text->links; l; l = l->next)
-		if (l->data) {
-			Link *link = (Link *) l->data;
+	for (i = 0; text->links && i < text->links->len; i ++)
+		if (g_ptr_array_index (text->links, i)) {
+			Link *link = (Link *) g_ptr_array_index (text->links, i);
 
 			g_print ("%d-%d(%d-%d): %s#%s\n", link->start_offset, link->end_offset, link->start_index, link->end_index, link->url, link->target);
 		}
@@ -45,6 +45,8 @@ destroy (HTMLObject *o)
 	HTMLObject *p;
 	HTMLObject *next;
 
+	html_clue_index_invalidate (HTML_CLUE (o));
+
 	for (p = HTML_CLUE (o)->head; p != NULL; p = next) {
 		next = p->next;
 		html_object_destroy (p);
@@ -125,6 +127,7 @@ copy (HTMLObject *self,
 	HTML_CLUE (dest)->head = NULL;
 	HTML_CLUE (dest)->tail = NULL;
 	HTML_CLUE (dest)->curr = NULL;
+	HTML_CLUE (dest)->index = NULL;
 
 	HTML_CLUE (dest)->valign = HTML_CLUE (self)->valign;
 	HTML_CLUE (dest)->halign = HTML_CLUE (self)->halign;
@@ -203,6 +206,7 @@ merge (HTMLObject *self, HTMLObject *with, HTMLEngine *e, GList **left, GList **
 	clue2 = HTML_CLUE (with);
 
 	html_clue_append (clue1, clue2->head);
+	html_clue_index_invalidate (clue2);
 	clue2->head = NULL;
 	clue2->tail = NULL;
 
@@ -223,6 +227,7 @@ split (HTMLObject *self, HTMLEngine *e, HTMLObject *child, gint offset, gint lev
 
 	dup  = html_object_dup (self);
 
+	html_clue_index_invalidate (HTML_CLUE (self));
 	HTML_CLUE (dup)->tail  = HTML_CLUE (self)->tail;
 	HTML_CLUE (self)->tail = child->prev;
 	if (child->prev)
@@ -254,7 +259,9 @@ draw (HTMLObject *o,
       gint width, gint height,
       gint tx, gint ty)
 {
+	HTMLClue *clue = HTML_CLUE (o);
 	HTMLObject *obj;
+	guint i, n;
 
 	if (y + height < o->y - o->ascent || y > o->y + o->descent)
 		return;
@@ -262,7 +269,11 @@ draw (HTMLObject *o,
 	tx += o->x;
 	ty += o->y - o->ascent;
 
-	for (obj = HTML_CLUE (o)->head; obj != 0; obj = obj->next) {
+	/* skip the indexed children above the area and stop at the first one below it */
+	n = clue->index ? clue->index->len : 0;
+	for (obj = html_clue_index_lookup (clue, y - (o->y - o->ascent), &i); obj != 0; obj = obj->next, i++) {
+		if (i < n && obj->y - obj->ascent > y - (o->y - o->ascent) + height)
+			break;
 		if (!(obj->flags & HTML_OBJECT_FLAG_ALIGNED)) {
 			html_object_draw (obj,
 					  p,
@@ -398,8 +409,10 @@ check_point (HTMLObject *o,
 	     guint *offset_return,
 	     gboolean for_cursor)
 {
+	HTMLClue *clue = HTML_CLUE (o);
 	HTMLObject *obj;
 	HTMLObject *obj2;
+	guint i, n;
 
 	if (x < o->x || x >= o->x + o->width
 	    || y >= o->y + o->descent || y < o->y - o->ascent)
@@ -408,7 +421,10 @@ check_point (HTMLObject *o,
 	x = x - o->x;
 	y = y - o->y + o->ascent;
 
-	for (obj = HTML_CLUE (o)->head; obj != 0; obj = obj->next) {
+	n = clue->index ? clue->index->len : 0;
+	for (obj = html_clue_index_lookup (clue, y, &i); obj != 0; obj = obj->next, i++) {
+		if (i < n && obj->y - obj->ascent > y)
+			break;
 		obj2 = html_object_check_point (obj, painter,
 						x, y, offset_return,
 						for_cursor);
@@ -670,6 +686,7 @@ html_clue_init (HTMLClue *clue,
 	clue->head = NULL;
 	clue->tail = NULL;
 	clue->curr = NULL;
+	clue->index = NULL;
 
 	clue->valign = HTML_VALIGN_TOP;
 	clue->halign = HTML_HALIGN_LEFT;
@@ -780,6 +797,9 @@ html_clue_append_after (HTMLClue *clue,
 	}
 	g_return_if_fail (where->parent == HTML_OBJECT (clue));
 
+	if (where != clue->tail)
+		html_clue_index_invalidate (clue);
+
 	html_object_change_set (HTML_OBJECT (clue), o->change);
 
 	tail = get_tail (o);
@@ -851,6 +871,7 @@ html_clue_prepend (HTMLClue *clue,
 	g_return_if_fail (o != NULL);
 
 	html_object_change_set (HTML_OBJECT (clue), o->change);
+	html_clue_index_invalidate (clue);
 
 	tail = get_tail (o);
 
@@ -884,6 +905,8 @@ html_clue_remove (HTMLClue *clue,
 	g_return_if_fail (o != NULL);
 	g_return_if_fail (clue == HTML_CLUE (o->parent));
 
+	html_clue_index_invalidate (clue);
+
 	if (o == clue->head)
 		clue->head = o->next;
 	if (o == clue->tail)
@@ -927,3 +950,86 @@ html_clue_is_empty (HTMLClue *clue)
 		return TRUE;
 	return FALSE;
 }
+
+/* Layouts which stack the children vertically keep the tops and the
+   bottoms of the children growing with their position, so the children
+   in a band of the clue are found by binary search.  Appending keeps
+   the index valid, the children after it are walked as before. */
+#define HTML_CLUE_INDEX_MIN 64
+
+void
+html_clue_index_update (HTMLClue *clue)
+{
+	HTMLObject *o;
+	guint n = 0;
+
+	g_return_if_fail (clue != NULL);
+
+	if (clue->index && clue->index->len) {
+		o = g_ptr_array_index (clue->index, clue->index->len - 1);
+		o = o->next;
+	} else {
+		for (o = clue->head; o && n < HTML_CLUE_INDEX_MIN; o = o->next)
+			n++;
+		if (n < HTML_CLUE_INDEX_MIN)
+			return;
+		o = clue->head;
+	}
+
+	if (!clue->index)
+		clue->index = g_ptr_array_sized_new (n);
+
+	for (; o; o = o->next)
+		g_ptr_array_add (clue->index, o);
+}
+
+void
+html_clue_index_invalidate (HTMLClue *clue)
+{
+	g_return_if_fail (clue != NULL);
+
+	if (clue->index) {
+		g_ptr_array_free (clue->index, TRUE);
+		clue->index = NULL;
+	}
+}
+
+/**
+ * html_clue_index_lookup:
+ * @clue: An HTMLClue.
+ * @y: A y coordinate relative to the top of @clue.
+ * @pos: Return location for the position of the result in the index.
+ *
+ * Return value: the first child which may reach down to @y, the first
+ * child which is not indexed yet if the indexed ones are all above it.
+ **/
+HTMLObject *
+html_clue_index_lookup (HTMLClue *clue, gint y, guint *pos)
+{
+	GPtrArray *index = clue->index;
+	HTMLObject *o;
+	guint lo, hi;
+
+	*pos = 0;
+	if (!index || !index->len)
+		return clue->head;
+
+	lo = 0;
+	hi = index->len;
+	while (lo < hi) {
+		guint mid = (lo + hi) / 2;
+
+		o = g_ptr_array_index (index, mid);
+		if (o->y + o->descent < y)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	*pos = lo;
+	if (lo < index->len)
+		return g_ptr_array_index (index, lo);
+
+	o = g_ptr_array_index (index, index->len - 1);
+	return o->next;
+}
@@ -33,6 +33,9 @@ struct _HTMLClue {
 	HTMLObject *tail;
 	HTMLObject *curr;
 
+	/* children in list order, a prefix of the list, see html_clue_index_update */
+	GPtrArray *index;
+
 	HTMLVAlignType valign;
 	HTMLHAlignType halign;
 };
@@ -99,5 +102,10 @@ void      html_clue_remove                (HTMLClue      *clue,
 					   HTMLObject    *o);
 void      html_clue_remove_text_slaves    (HTMLClue      *clue);
 gboolean  html_clue_is_empty              (HTMLClue      *clue);
+void      html_clue_index_update          (HTMLClue      *clue);
+void      html_clue_index_invalidate      (HTMLClue      *clue);
+HTMLObject *html_clue_index_lookup        (HTMLClue      *clue,
+					   gint           y,
+					   guint         *pos);
 
 #endif /* HTMLCLUE_H */
@@ -122,6 +122,7 @@ copy (HTMLObject *self,
 	HTML_CLUEFLOW (dest)->item_color = HTML_CLUEFLOW (self)->item_color;
 	HTML_CLUEFLOW (dest)->indent_width = HTML_CLUEFLOW (self)->indent_width;
 	HTML_CLUEFLOW (dest)->dir = HTML_CLUEFLOW (self)->dir;
+	HTML_CLUEFLOW (dest)->spell_dirty = HTML_CLUEFLOW (self)->spell_dirty;
 
 	if (HTML_CLUEFLOW (dest)->item_color)
 		html_color_ref (HTML_CLUEFLOW (dest)->item_color);
@@ -2238,157 +2239,63 @@ static gboolean
 search_text (HTMLObject **beg, HTMLSearch *info)
 {
 	HTMLObject *cur = *beg;
-	HTMLObject *end = cur;
 	HTMLObject *head;
-	guchar *par, *pp;
-	guint text_bytes;
-	guint eq_bytes;
+	GPtrArray *texts;
+	const gchar *par;
+	guint text_bytes, limit, match_index, match_bytes;
 	gint index;
 	gboolean retval = FALSE;
 
 	/* printf ("search flow look for \"text\" %s\n", info->text); */
 
-	/* first get flow text_bytes */
-	text_bytes = 0;
+	/* collect the text objects of the run */
+	texts = g_ptr_array_new ();
 	while (cur) {
-		if (html_object_is_text (cur)) {
-			text_bytes += HTML_TEXT (cur)->text_bytes;
-			end = cur;
-		} else if (HTML_OBJECT_TYPE (cur) != HTML_TYPE_TEXTSLAVE) {
+		if (html_object_is_text (cur))
+			g_ptr_array_add (texts, cur);
+		else if (HTML_OBJECT_TYPE (cur) != HTML_TYPE_TEXTSLAVE)
 			break;
-		}
 		cur = (info->forward) ? cur->next : cur->prev;
 	}
 
-	if (text_bytes > 0) {
-		par = (guchar *) g_new (gchar, text_bytes + 1);
-		par [text_bytes] = 0;
+	if (texts->len > 0) {
+		if (!info->forward) {
+			guint i;
 
-		pp = (info->forward) ? par : par + text_bytes;
+			/* the run text is in document order */
+			for (i = 0; i < texts->len / 2; i ++) {
+				gpointer tmp = texts->pdata [i];
 
-		/* now fill par with text */
-		head = (info->forward) ? *beg : end;
-		cur = *beg;
-		while (cur) {
-			if (html_object_is_text (cur)) {
-				if (!info->forward) {
-					pp -= HTML_TEXT (cur)->text_bytes;
-				}
-				strncpy ((gchar *) pp, HTML_TEXT (cur)->text, HTML_TEXT (cur)->text_bytes);
-				if (info->forward) {
-					pp += HTML_TEXT (cur)->text_bytes;
-				}
-			} else if (HTML_OBJECT_TYPE (cur) != HTML_TYPE_TEXTSLAVE) {
-				break;
+				texts->pdata [i] = texts->pdata [texts->len - 1 - i];
+				texts->pdata [texts->len - 1 - i] = tmp;
 			}
-			cur = (info->forward) ? cur->next : cur->prev;
 		}
 
-		/* set eq_bytes and pos counters */
-		eq_bytes = 0;
+		head = (info->forward) ? *beg : HTML_OBJECT (g_ptr_array_index (texts, 0));
+		par = html_search_get_run_text (info, texts, &text_bytes);
+
+		/* set pos counter */
 		if (info->found) {
 			if (info->start_pos > 0)
-				index = ((guchar *)g_utf8_offset_to_pointer ((gchar *) par, info->start_pos + ((info->forward) ? 0 : -1))) - par;
+				index = g_utf8_offset_to_pointer (par, info->start_pos + ((info->forward) ? 0 : -1)) - par;
 			else
-				index = info->forward ? ((guchar *)g_utf8_offset_to_pointer ((gchar *) par, info->start_pos) - par) : -1;
+				index = info->forward ? g_utf8_offset_to_pointer (par, info->start_pos) - par : -1;
 		} else {
 			index = (info->forward) ? 0 : text_bytes;
 		}
 
-		/* make shorter text instead */
-		if (!info->forward && index + info->text_bytes < text_bytes) {
-			guchar * tmp = (guchar *)(par + index + info->text_bytes);
-			*tmp = '\0';
-		}
-
-		if ((info->forward && index < text_bytes)
-		    || (!info->forward && index >= 0)) {
-			if (info->reb) {
-				/* regex search */
-				gint rv;
-#ifndef HAVE_GNU_REGEX
-				regmatch_t match;
-				/* guchar *p=par+pos; */
-
-				/* FIXME UTF8
-				   replace &nbsp;'s with spaces
-				while (*p) {
-					if (*p == ENTITY_NBSP) {
-						*p = ' ';
-					}
-					p += (info->forward) ? 1 : -1;
-					} */
-
-				while ((info->forward && index < text_bytes)
-				       || (!info->forward && index >= 0)) {
-					rv = regexec (info->reb,
-						      (gchar *) par + index,
-						      1, &match, 0);
-					if (rv == 0) {
-						search_set_info (head, info, par,
-								 index + match.rm_so, match.rm_eo - match.rm_so);
-						retval = TRUE;
-						break;
-					}
-					index += (info->forward)
-						? (((guchar *) g_utf8_next_char ((gchar *) par + index)) - par - index)
-						: (((guchar *) g_utf8_prev_char ((gchar *) par + index)) - par - index);
-				}
-#else
-				rv = re_search (info->reb, par, text_bytes, index,
-						(info->forward) ? text_bytes - index : -index, NULL);
-				if (rv >= 0) {
-					guint found_index = rv;
-					rv = re_match (info->reb, par, text_bytes, found_index, NULL);
-					if (rv < 0) {
-						g_warning ("re_match (...) error");
-					}
-					search_set_info (head, info, par, found_index, rv);
-					retval = TRUE;
-				} else {
-					if (rv < -1) {
-						g_warning ("re_search (...) error");
-					}
-				}
-#endif
-			} else {
-				/* substring search - simple one - could be improved
-				   go thru par and look for info->text */
-				while ((info->forward && par[index])
-				       || (!info->forward && index >= 0)) {
-					gunichar unicode_info, unicode_par;
-
-					unicode_info = g_utf8_get_char (info->text + eq_bytes);
-					unicode_par = g_utf8_get_char ((gchar *) par + index);
-					if (!info->case_sensitive) {
-                                             unicode_info = g_unichar_toupper (unicode_info);
-					     unicode_par  = g_unichar_toupper (unicode_par);
-					}
-
-					if (unicode_info == unicode_par) {
-						eq_bytes += (guchar *)g_utf8_next_char (par + index) - par - index;
+		/* backward matches have to start before index */
+		limit = text_bytes;
+		if (!info->forward && index + info->text_bytes < text_bytes)
+			limit = index + info->text_bytes;
 
-						if (eq_bytes == info->text_bytes) {
-							/* The above par + index is always at the beginning of the last character matched */
-							index = (guchar *) g_utf8_next_char ((gchar *) par + index) - par - eq_bytes;
-							search_set_info (head, info, par, index, info->text_bytes);
-							retval=TRUE;
-							break;
-						}
-					} else {
-						index -= eq_bytes;
-						eq_bytes = 0;
-					}
-					index += (info->forward || unicode_info == unicode_par)
-						? (((guchar *) g_utf8_next_char (par + index)) - par - index)
-						: (index
-							? (((guchar *) g_utf8_prev_char ((gchar *) par + index)) - par - index)
-							: -1);
-				}
-			}
+		if (((info->forward && index < text_bytes) || (!info->forward && index >= 0))
+		    && html_search_match (info, index, limit, &match_index, &match_bytes)) {
+			search_set_info (head, info, (guchar *) par, match_index, match_bytes);
+			retval = TRUE;
 		}
-		g_free (par);
 	}
+	g_ptr_array_free (texts, TRUE);
 
 	*beg = cur;
 
@@ -2578,6 +2485,7 @@ html_clueflow_init (HTMLClueFlow *clueflow, HTMLClueFlowClass *klass,
 	clueflow->item_color = NULL;
 
 	clueflow->clear = clear;
+	clueflow->spell_dirty = FALSE;
 }
 
 HTMLObject *
@@ -3060,8 +2968,81 @@ queue_draw (HTMLObject *o, HTMLEngine *e, HTMLInterval *i)
 		html_text_queue_draw (HTML_TEXT (o), e, html_interval_get_start (i, o), html_interval_get_length (i, o));
 }
 
+static gint
+check_word (HTMLEngine *e, const gchar *word, GHashTable *verdicts)
+{
+	gpointer verdict;
+
+	if (verdicts && (verdict = g_hash_table_lookup (verdicts, word)))
+		return GPOINTER_TO_INT (verdict) - 1;
+
+	return (*e->widget->editor_api->check_word) (e->widget, word, e->widget->editor_data);
+}
+
+/* the distinct words html_clueflow_spell_check would look up, NULL if none */
+gchar **
+html_clueflow_get_spell_words (HTMLClueFlow *flow)
+{
+	HTMLClue *clue = HTML_CLUE (flow);
+	HTMLInterval *interval;
+	GHashTable *seen;
+	GPtrArray *words;
+	gchar *text, *ct, *word;
+
+	g_return_val_if_fail (HTML_IS_CLUEFLOW (flow), NULL);
+
+	if (!clue->tail)
+		return NULL;
+
+	interval = html_interval_new (clue->head, clue->tail, 0, html_object_get_length (clue->tail));
+	text = get_text (clue, interval);
+	html_interval_destroy (interval);
+
+	seen = g_hash_table_new (g_str_hash, g_str_equal);
+	words = g_ptr_array_new ();
+	ct = text;
+	while (*ct) {
+		gboolean cited;
+
+		word = ct = begin_of_word (text, ct, &cited);
+		ct        =   end_of_word (ct, cited);
+
+		if (word != ct) {
+			gchar *w = g_strndup (word, ct - word);
+
+			if (g_hash_table_lookup (seen, w))
+				g_free (w);
+			else {
+				g_hash_table_insert (seen, w, w);
+				g_ptr_array_add (words, w);
+			}
+			if (*ct)
+				ct = g_utf8_next_char (ct);
+		}
+	}
+	g_hash_table_destroy (seen);
+	g_free (text);
+
+	if (!words->len) {
+		g_ptr_array_free (words, TRUE);
+		return NULL;
+	}
+	g_ptr_array_add (words, NULL);
+
+	return (gchar **) g_ptr_array_free (words, FALSE);
+}
+
 void
 html_clueflow_spell_check (HTMLClueFlow *flow, HTMLEngine *e, HTMLInterval *interval)
+{
+	html_clueflow_spell_check_with_verdicts (flow, e, interval, NULL);
+}
+
+/* verdicts maps words to GINT_TO_POINTER (correct + 1), the editor is
+   asked about the other words */
+void
+html_clueflow_spell_check_with_verdicts (HTMLClueFlow *flow, HTMLEngine *e, HTMLInterval *interval,
+					 GHashTable *verdicts)
 {
 	HTMLObject *obj;
 	HTMLClue *clue;
@@ -3086,6 +3067,9 @@ html_clueflow_spell_check (HTMLClueFlow *flow, HTMLEngine *e, HTMLInterval *inte
 		interval = new_interval;
 	}
 
+	if (new_interval)
+		flow->spell_dirty = FALSE;
+
 	text = get_text (clue, interval);
 	obj  = html_interval_get_head (interval, HTML_OBJECT (flow));
 	if (obj && html_object_is_text (obj))
@@ -3107,7 +3091,7 @@ html_clueflow_spell_check (HTMLClueFlow *flow, HTMLEngine *e, HTMLInterval *inte
 				bak = *ct;
 				*ct = 0;
 				/* printf ("off %d going to test word: \"%s\"\n", off, word); */
-				result = (*e->widget->editor_api->check_word) (e->widget, word, e->widget->editor_data);
+				result = check_word (e, word, verdicts);
 
 				if (result == 1) {
 					gboolean is_text = (obj) ? html_object_is_text (obj) : FALSE;
@@ -50,6 +50,9 @@ struct _HTMLClueFlow {
 	HTMLColor   *item_color;
 
 	HTMLDirection dir;
+
+	/* waits for html_engine_spell_check */
+	gboolean spell_dirty;
 };
 
 struct _HTMLClueFlowClass {
@@ -121,6 +124,11 @@ void               html_clueflow_get_properties               (HTMLClueFlow
 void               html_clueflow_spell_check                  (HTMLClueFlow       *flow,
 							       HTMLEngine         *e,
 							       HTMLInterval       *i);
+void               html_clueflow_spell_check_with_verdicts    (HTMLClueFlow       *flow,
+							       HTMLEngine         *e,
+							       HTMLInterval       *i,
+							       GHashTable         *verdicts);
+gchar            **html_clueflow_get_spell_words              (HTMLClueFlow       *flow);
 gboolean           html_clueflow_is_empty                     (HTMLClueFlow       *flow);
 gboolean           html_clueflow_contains_table               (HTMLClueFlow       *flow);
 gint               html_clueflow_get_line_offset              (HTMLClueFlow       *flow,
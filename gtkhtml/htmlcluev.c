@@ -205,7 +205,11 @@ html_cluev_do_layout (HTMLObject *o, HTMLPainter *painter, gboolean calc_size, G
 		o->ascent = clue->curr->y;
 		lmargin = get_lmargin (o, painter);
 
-		if (calc_size)
+		/* children untouched since the last layout are only moved,
+		   unless an aligned object may flow around them */
+		if (calc_size
+		    && (clue->curr->change & HTML_CHANGE_SIZE
+			|| cluev->align_left_list || cluev->align_right_list))
 			changed |= html_object_calc_size (clue->curr, painter, changed_objs);
 
 		if (o->width < clue->curr->width + padding2)
@@ -237,6 +241,7 @@ html_cluev_do_layout (HTMLObject *o, HTMLPainter *painter, gboolean calc_size, G
 	/* Remember the last object so that we can start from here next time
 	   we are called. */
 	clue->curr = clue->tail;
+	html_clue_index_update (clue);
 
 	if (o->max_width != 0 && o->width < o->max_width)
 		o->width = o->max_width;
@@ -457,6 +462,7 @@ check_point (HTMLObject *self,
 	HTMLObject *obj;
 	HTMLClueAligned *clue;
 	gint padding = HTML_CLUEV (self)->padding;
+	guint i, n;
 
 	if (x < self->x || x >= self->x + self->width
 	    || y < self->y - self->ascent || y >= self->y + self->descent)
@@ -512,9 +518,21 @@ check_point (HTMLObject *self,
 		}
 	}
 
-	for (p = HTML_CLUE (self)->head; p != 0; p = p->next) {
+	/* start at the first child reaching down to y, the cursor sticks
+	   to the last child when y is below all of them */
+	n = HTML_CLUE (self)->index ? HTML_CLUE (self)->index->len : 0;
+	p = html_clue_index_lookup (HTML_CLUE (self), y, &i);
+	if (p == NULL && n) {
+		p = HTML_CLUE (self)->tail;
+		i = n - 1;
+	}
+
+	for (; p != 0; p = p->next, i++) {
 		gint x1, y1;
 
+		if (i < n && p->y - p->ascent > y && !(for_cursor && p->prev == NULL))
+			break;
+
 		if (!for_cursor) {
 			x1 = x;
 			y1 = y;
@@ -0,0 +1,536 @@
+/* "a -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  This file is part of the GtkHTML library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <libcroco/libcroco.h>
+
+#include "htmlcss.h"
+
+/* number of compiled style sheets kept around for later documents */
+#define CSS_CACHE_SIZE 16
+
+typedef struct {
+	gchar *name;    /* lower case */
+	gchar *value;
+} HTMLCssDeclaration;
+
+/* one selector of a rule set with either its normal or its !important
+   declarations */
+typedef struct {
+	CRSimpleSel *selector;
+	gulong specificity;
+	guint order;
+	gboolean important;
+	GArray *declarations;   /* HTMLCssDeclaration, shared by the selectors of a rule set */
+} HTMLCssRule;
+
+struct _HTMLCss {
+	gint ref_count;
+	gchar *text;
+	CRStyleSheet *sheet;    /* the selectors point into it */
+
+	/* rules by the rightmost simple selector */
+	GHashTable *by_id;
+	GHashTable *by_class;
+	GHashTable *by_tag;
+	GPtrArray *universal;
+
+	GPtrArray *rules;
+	GPtrArray *declarations;
+};
+
+typedef struct {
+	const HTMLCssRule *rule;
+	guint64 key;            /* cascade order */
+} HTMLCssMatch;
+
+typedef struct {
+	guint n_matches;
+	HTMLCssMatch matches [1];
+} HTMLCssMatches;
+
+struct _HTMLCssContext {
+	GPtrArray *sheets;      /* HTMLCss in document order */
+	CRSelEng *selector;
+	GPtrArray *matches;     /* HTMLCssMatches referenced from the nodes */
+};
+
+G_LOCK_DEFINE_STATIC (css_cache);
+static GHashTable *css_cache = NULL;
+static GQueue css_cache_lru = G_QUEUE_INIT;
+
+static void
+bucket_add (GHashTable *buckets, const gchar *key, HTMLCssRule *rule)
+{
+	GPtrArray *bucket = g_hash_table_lookup (buckets, key);
+
+	if (!bucket) {
+		bucket = g_ptr_array_new ();
+		g_hash_table_insert (buckets, g_strdup (key), bucket);
+	}
+	g_ptr_array_add (bucket, rule);
+}
+
+static void
+bucket_free (gpointer bucket)
+{
+	g_ptr_array_free (bucket, TRUE);
+}
+
+/* files the rule under the id, the first class or the tag of its
+   rightmost simple selector, the only candidates an element is tested with */
+static void
+html_css_add_rule (HTMLCss *css, HTMLCssRule *rule)
+{
+	CRSimpleSel *sel;
+	CRAdditionalSel *add;
+	const gchar *class_name = NULL;
+
+	g_ptr_array_add (css->rules, rule);
+
+	for (sel = rule->selector; sel->next; sel = sel->next)
+		;
+
+	for (add = sel->add_sel; add; add = add->next) {
+		if (add->type == ID_ADD_SELECTOR && add->content.id_name && add->content.id_name->stryng) {
+			bucket_add (css->by_id, add->content.id_name->stryng->str, rule);
+			return;
+		}
+		if (add->type == CLASS_ADD_SELECTOR && !class_name
+		    && add->content.class_name && add->content.class_name->stryng)
+			class_name = add->content.class_name->stryng->str;
+	}
+
+	if (class_name)
+		bucket_add (css->by_class, class_name, rule);
+	else if ((sel->type_mask & TYPE_SELECTOR) && sel->name && sel->name->stryng
+		 && strcmp (sel->name->stryng->str, "*")) {
+		gchar *tag = g_ascii_strdown (sel->name->stryng->str, -1);
+
+		bucket_add (css->by_tag, tag, rule);
+		g_free (tag);
+	} else
+		g_ptr_array_add (css->universal, rule);
+}
+
+static void
+html_css_add_ruleset (HTMLCss *css, CRStatement *stmt, guint *order)
+{
+	CRDeclaration *decl;
+	CRSelector *sel;
+	GArray *declarations [2];
+	gint important;
+
+	declarations [0] = g_array_new (FALSE, FALSE, sizeof (HTMLCssDeclaration));
+	declarations [1] = g_array_new (FALSE, FALSE, sizeof (HTMLCssDeclaration));
+	g_ptr_array_add (css->declarations, declarations [0]);
+	g_ptr_array_add (css->declarations, declarations [1]);
+
+	for (decl = stmt->kind.ruleset->decl_list; decl; decl = decl->next) {
+		HTMLCssDeclaration declaration;
+
+		if (!decl->property || !decl->property->stryng || !decl->value)
+			continue;
+
+		declaration.name = g_ascii_strdown (decl->property->stryng->str, -1);
+		declaration.value = (gchar *) cr_term_to_string (decl->value);
+		if (!declaration.value) {
+			g_free (declaration.name);
+			continue;
+		}
+		g_array_append_val (declarations [decl->important ? 1 : 0], declaration);
+	}
+
+	for (sel = stmt->kind.ruleset->sel_list; sel; sel = sel->next) {
+		if (!sel->simple_sel)
+			continue;
+
+		cr_simple_sel_compute_specificity (sel->simple_sel);
+
+		for (important = 0; important < 2; important ++) {
+			HTMLCssRule *rule;
+
+			if (!declarations [important]->len)
+				continue;
+
+			rule = g_new (HTMLCssRule, 1);
+			rule->selector = sel->simple_sel;
+			rule->specificity = sel->simple_sel->specificity;
+			rule->order = (*order) ++;
+			rule->important = important;
+			rule->declarations = declarations [important];
+			html_css_add_rule (css, rule);
+		}
+	}
+}
+
+static HTMLCss *
+html_css_new (const gchar *text)
+{
+	HTMLCss *css;
+	CRStyleSheet *sheet = NULL;
+	CRStatement *stmt;
+	guint order = 0;
+
+	if (cr_om_parser_simply_parse_buf ((const guchar *) text, strlen (text), CR_UTF_8, &sheet) != CR_OK) {
+		if (sheet)
+			cr_stylesheet_destroy (sheet);
+		return NULL;
+	}
+	if (!sheet)
+		return NULL;
+
+	css = g_new0 (HTMLCss, 1);
+	css->ref_count = 1;
+	css->text = g_strdup (text);
+	css->sheet = sheet;
+	css->by_id = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, bucket_free);
+	css->by_class = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, bucket_free);
+	css->by_tag = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, bucket_free);
+	css->universal = g_ptr_array_new ();
+	css->rules = g_ptr_array_new ();
+	css->declarations = g_ptr_array_new ();
+
+	/* as the selection engine, only the rule sets at top level */
+	for (stmt = sheet->statements; stmt; stmt = stmt->next)
+		if (stmt->type == RULESET_STMT && stmt->kind.ruleset)
+			html_css_add_ruleset (css, stmt, &order);
+
+	return css;
+}
+
+static void
+html_css_unref (HTMLCss *css)
+{
+	guint i, j;
+
+	if (!g_atomic_int_dec_and_test (&css->ref_count))
+		return;
+
+	g_hash_table_destroy (css->by_id);
+	g_hash_table_destroy (css->by_class);
+	g_hash_table_destroy (css->by_tag);
+	g_ptr_array_free (css->universal, TRUE);
+
+	for (i = 0; i < css->rules->len; i ++)
+		g_free (g_ptr_array_index (css->rules, i));
+	g_ptr_array_free (css->rules, TRUE);
+
+	for (i = 0; i < css->declarations->len; i ++) {
+		GArray *declarations = g_ptr_array_index (css->declarations, i);
+
+		for (j = 0; j < declarations->len; j ++) {
+			g_free (g_array_index (declarations, HTMLCssDeclaration, j).name);
+			g_free (g_array_index (declarations, HTMLCssDeclaration, j).value);
+		}
+		g_array_free (declarations, TRUE);
+	}
+	g_ptr_array_free (css->declarations, TRUE);
+
+	cr_stylesheet_destroy (css->sheet);
+	g_free (css->text);
+	g_free (css);
+}
+
+/* compiled style sheets are shared by the documents using the same
+   text, the last CSS_CACHE_SIZE of them stay cached */
+static HTMLCss *
+html_css_lookup (const gchar *text)
+{
+	HTMLCss *css, *cached;
+
+	G_LOCK (css_cache);
+	if (!css_cache)
+		css_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+	css = g_hash_table_lookup (css_cache, text);
+	if (css) {
+		g_queue_remove (&css_cache_lru, css);
+		g_queue_push_head (&css_cache_lru, css);
+		g_atomic_int_inc (&css->ref_count);
+	}
+	G_UNLOCK (css_cache);
+
+	if (css)
+		return css;
+
+	css = html_css_new (text);
+	if (!css)
+		return NULL;
+
+	G_LOCK (css_cache);
+	cached = g_hash_table_lookup (css_cache, text);
+	if (cached) {
+		/* somebody else was faster */
+		g_atomic_int_inc (&cached->ref_count);
+	} else {
+		g_atomic_int_inc (&css->ref_count);
+		g_hash_table_insert (css_cache, css->text, css);
+		g_queue_push_head (&css_cache_lru, css);
+
+		if (g_queue_get_length (&css_cache_lru) > CSS_CACHE_SIZE) {
+			HTMLCss *old = g_queue_pop_tail (&css_cache_lru);
+
+			g_hash_table_remove (css_cache, old->text);
+			html_css_unref (old);
+		}
+	}
+	G_UNLOCK (css_cache);
+
+	if (cached) {
+		html_css_unref (css);
+		css = cached;
+	}
+
+	return css;
+}
+
+HTMLCssContext *
+html_css_context_new (void)
+{
+	HTMLCssContext *context;
+
+	context = g_new0 (HTMLCssContext, 1);
+	context->sheets = g_ptr_array_new ();
+	context->matches = g_ptr_array_new ();
+
+	return context;
+}
+
+void
+html_css_context_free (HTMLCssContext *context)
+{
+	guint i;
+
+	if (!context)
+		return;
+
+	for (i = 0; i < context->matches->len; i ++)
+		g_free (g_ptr_array_index (context->matches, i));
+	g_ptr_array_free (context->matches, TRUE);
+
+	for (i = 0; i < context->sheets->len; i ++)
+		html_css_unref (g_ptr_array_index (context->sheets, i));
+	g_ptr_array_free (context->sheets, TRUE);
+
+	if (context->selector)
+		cr_sel_eng_destroy (context->selector);
+
+	g_free (context);
+}
+
+/* returns the index of the new sheet, -1 if it can't be parsed */
+gint
+html_css_context_add_sheet (HTMLCssContext *context, const gchar *text)
+{
+	HTMLCss *css;
+
+	g_return_val_if_fail (context != NULL, -1);
+	g_return_val_if_fail (text != NULL, -1);
+
+	css = html_css_lookup (text);
+	if (!css)
+		return -1;
+
+	if (!context->selector)
+		context->selector = cr_sel_eng_new ();
+
+	g_ptr_array_add (context->sheets, css);
+
+	return context->sheets->len - 1;
+}
+
+static const gchar *
+node_get_attr (const xmlNode *node, const gchar *name)
+{
+	xmlAttr *attr;
+
+	for (attr = node->properties; attr; attr = attr->next)
+		if (attr->name && !g_ascii_strcasecmp ((const gchar *) attr->name, name))
+			return attr->children && attr->children->content
+				? (const gchar *) attr->children->content : NULL;
+
+	return NULL;
+}
+
+/* !important first, then specificity, then document order */
+static guint64
+match_key (const HTMLCssRule *rule, guint sheet)
+{
+	return ((guint64) (rule->important ? 1 : 0) << 63)
+		| ((guint64) MIN (rule->specificity, 0x7fffff) << 40)
+		| ((guint64) MIN (sheet, 0xffff) << 24)
+		| (guint64) MIN (rule->order, 0xffffff);
+}
+
+static void
+match_rules (HTMLCssContext *context, GPtrArray *rules, xmlNode *node, guint sheet, GArray *found)
+{
+	guint i;
+
+	if (!rules)
+		return;
+
+	for (i = 0; i < rules->len; i ++) {
+		HTMLCssRule *rule = g_ptr_array_index (rules, i);
+		gboolean result = FALSE;
+
+		if (cr_sel_eng_matches_node (context->selector, rule->selector, node, &result) == CR_OK && result) {
+			HTMLCssMatch match;
+
+			match.rule = rule;
+			match.key = match_key (rule, sheet);
+			g_array_append_val (found, match);
+		}
+	}
+}
+
+static gint
+match_compare (gconstpointer a, gconstpointer b)
+{
+	guint64 ka = ((const HTMLCssMatch *) a)->key;
+	guint64 kb = ((const HTMLCssMatch *) b)->key;
+
+	return ka < kb ? -1 : ka > kb ? 1 : 0;
+}
+
+static void
+html_css_context_match_node (HTMLCssContext *context, xmlNode *node, gint first_sheet, GArray *found)
+{
+	HTMLCssMatches *old, *matches;
+	const gchar *id, *classes;
+	guint sheet;
+
+	g_array_set_size (found, 0);
+
+	id = node_get_attr (node, "id");
+	classes = node_get_attr (node, "class");
+
+	for (sheet = first_sheet; sheet < context->sheets->len; sheet ++) {
+		HTMLCss *css = g_ptr_array_index (context->sheets, sheet);
+
+		match_rules (context, css->universal, node, sheet, found);
+		match_rules (context, g_hash_table_lookup (css->by_tag, (const gchar *) node->name), node, sheet, found);
+		if (id)
+			match_rules (context, g_hash_table_lookup (css->by_id, id), node, sheet, found);
+		if (classes) {
+			gchar **names = g_strsplit_set (classes, " \t\r\n", -1);
+			gint i, j;
+
+			for (i = 0; names [i]; i ++) {
+				if (!*names [i])
+					continue;
+				for (j = 0; j < i; j ++)
+					if (!strcmp (names [i], names [j]))
+						break;
+				if (j == i)
+					match_rules (context, g_hash_table_lookup (css->by_class, names [i]), node, sheet, found);
+			}
+			g_strfreev (names);
+		}
+	}
+
+	if (!found->len)
+		return;
+
+	old = node->_private;
+	if (old)
+		g_array_append_vals (found, old->matches, old->n_matches);
+	g_array_sort (found, match_compare);
+
+	matches = g_malloc (sizeof (HTMLCssMatches) + (found->len - 1) * sizeof (HTMLCssMatch));
+	matches->n_matches = found->len;
+	memcpy (matches->matches, found->data, found->len * sizeof (HTMLCssMatch));
+	g_ptr_array_add (context->matches, matches);
+	node->_private = matches;
+}
+
+static void
+html_css_context_match_tree (HTMLCssContext *context, xmlNode *node, gint first_sheet, GArray *found)
+{
+	xmlNode *child;
+
+	if (node->type != XML_ELEMENT_NODE)
+		return;
+
+	html_css_context_match_node (context, node, first_sheet, found);
+	for (child = node->children; child; child = child->next)
+		html_css_context_match_tree (context, child, first_sheet, found);
+}
+
+/* matches the element (and its descendants when recursive) against the
+   sheets starting with first_sheet */
+void
+html_css_context_match (HTMLCssContext *context, xmlNode *node, gint first_sheet, gboolean recursive)
+{
+	GArray *found;
+
+	g_return_if_fail (context != NULL);
+	g_return_if_fail (node != NULL);
+
+	if (first_sheet < 0 || (guint) first_sheet >= context->sheets->len || node->type != XML_ELEMENT_NODE)
+		return;
+
+	found = g_array_new (FALSE, FALSE, sizeof (HTMLCssMatch));
+	if (recursive)
+		html_css_context_match_tree (context, node, first_sheet, found);
+	else
+		html_css_context_match_node (context, node, first_sheet, found);
+	g_array_free (found, TRUE);
+}
+
+/* carries the matches over to a copy made by xmlDocCopyNode */
+void
+html_css_copy_matches (const xmlNode *from, xmlNode *to)
+{
+	const xmlNode *child;
+	xmlNode *copy;
+
+	if (from->type != XML_ELEMENT_NODE)
+		return;
+
+	to->_private = from->_private;
+	for (child = from->children, copy = to->children; child && copy; child = child->next, copy = copy->next)
+		html_css_copy_matches (child, copy);
+}
+
+/* calls func for the matched declarations in cascade order, the later
+   ones win */
+void
+html_css_foreach_property (const xmlNode *node, HTMLCssPropertyFunc func, gpointer data)
+{
+	const HTMLCssMatches *matches;
+	guint i, j;
+
+	g_return_if_fail (node != NULL);
+
+	if (node->type != XML_ELEMENT_NODE || !node->_private)
+		return;
+
+	matches = node->_private;
+	for (i = 0; i < matches->n_matches; i ++) {
+		GArray *declarations = matches->matches [i].rule->declarations;
+
+		for (j = 0; j < declarations->len; j ++)
+			func (g_array_index (declarations, HTMLCssDeclaration, j).name,
+			      g_array_index (declarations, HTMLCssDeclaration, j).value, data);
+	}
+}
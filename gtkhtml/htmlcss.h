@@ -0,0 +1,44 @@
+/* "a -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  This file is part of the GtkHTML library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef __HTML_CSS_H__
+#define __HTML_CSS_H__
+
+#include <libxml/tree.h>
+#include "htmltypes.h"
+
+typedef void (* HTMLCssPropertyFunc) (const gchar *name, const gchar *value, gpointer data);
+
+/* style sheets of one document, the matched rules are kept in the
+   _private field of the element nodes until the context is freed */
+HTMLCssContext *html_css_context_new          (void);
+void            html_css_context_free         (HTMLCssContext      *context);
+gint            html_css_context_add_sheet    (HTMLCssContext      *context,
+					       const gchar         *text);
+void            html_css_context_match        (HTMLCssContext      *context,
+					       xmlNode             *node,
+					       gint                 first_sheet,
+					       gboolean             recursive);
+void            html_css_copy_matches         (const xmlNode       *from,
+					       xmlNode             *to);
+void            html_css_foreach_property     (const xmlNode       *node,
+					       HTMLCssPropertyFunc  func,
+					       gpointer             data);
+
+#endif /* __HTML_CSS_H__ */
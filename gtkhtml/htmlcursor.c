@@ -30,6 +30,7 @@
 
 #include "gtkhtml-private.h"
 #include "htmlclue.h"
+#include "htmlclueflow.h"
 #include "htmlengine.h"
 #include "htmlengine-edit.h"
 #include "htmltext.h"
@@ -694,18 +695,88 @@ html_cursor_get_position (HTMLCursor *cursor)
 	return cursor->position;
 }
 
+static gboolean
+position_anchor_descends (HTMLObject *o)
+{
+	switch (HTML_OBJECT_TYPE (o)) {
+	case HTML_TYPE_CLUEV:
+	case HTML_TYPE_CLUEFLOW:
+	case HTML_TYPE_TABLE:
+	case HTML_TYPE_TABLECELL:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/* Finds the start of the last leaf object at or before position inside o,
+   which starts at pos.  Siblings are skipped by their recursive length, so
+   only the blocks and table cells on the way to position are visited.
+   Other containers stop the search, the positions behind them are not
+   known without walking them. */
+static void
+find_position_anchor_in (HTMLObject *o, gint pos, gint position, HTMLObject **anchor, gint *anchor_position)
+{
+	HTMLObject *child, *next;
+	gint len, sep = 0;
+
+	/* a table has one position before its cells and one after each cell */
+	if (HTML_OBJECT_TYPE (o) == HTML_TYPE_TABLE) {
+		pos++;
+		sep = 1;
+	}
+
+	for (child = html_object_head (o); child && pos <= position; child = next) {
+		next = html_object_next (o, child);
+		len = html_object_get_recursive_length (child) + sep;
+		if (position_anchor_descends (child)) {
+			if (pos + len > position || !next) {
+				find_position_anchor_in (child, pos, position, anchor, anchor_position);
+				return;
+			}
+		} else if (html_object_is_container (child))
+			return;
+		else if (html_object_accepts_cursor (child)) {
+			*anchor = child;
+			*anchor_position = pos;
+		}
+		pos += len;
+	}
+}
+
+static gboolean
+find_position_anchor (HTMLEngine *engine, gint position, HTMLObject **anchor, gint *anchor_position)
+{
+	*anchor = NULL;
+	if (engine->clue && position_anchor_descends (engine->clue))
+		find_position_anchor_in (engine->clue, 0, position, anchor, anchor_position);
+
+	return *anchor != NULL;
+}
+
 static void
 html_cursor_real_jump_to_position (HTMLCursor *cursor,
 				   HTMLEngine *engine,
 				   gint        position,
 				   gboolean    exact_position)
 {
+	HTMLObject *anchor;
+	gint anchor_position;
+
 	g_return_if_fail (cursor != NULL);
 	g_return_if_fail (position >= 0);
 
 	if (engine->need_spell_check)
 		html_engine_spell_check_range (engine, engine->cursor, engine->cursor);
 
+	/* start from the nearest object start when it is closer than the cursor */
+	if (find_position_anchor (engine, position, &anchor, &anchor_position)
+	    && (cursor->position > position || position - anchor_position < position - cursor->position)) {
+		cursor->object = anchor;
+		cursor->offset = 0;
+		cursor->position = anchor_position;
+	}
+
 	if (cursor->position < position) {
 		while (cursor->position < position) {
 			if (!forward (cursor, engine, exact_position))
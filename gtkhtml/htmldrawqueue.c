@@ -20,6 +20,7 @@
 */
 
 #include <config.h>
+#include "gtk-compat.h"
 #include "htmlengine-edit-cursor.h"
 #include "htmlcolor.h"
 #include "htmldrawqueue.h"
@@ -29,6 +30,7 @@
 #include "htmlpainter.h"
 #include "htmlobject.h"
 #include "htmltextslave.h"
+#include "htmltilecache.h"
 #include "htmlsettings.h"
 #include "gtkhtml.h"
 
@@ -87,11 +89,12 @@ html_draw_queue_new (HTMLEngine *engine)
 
 	new->engine = engine;
 
-	new->elems = NULL;
-	new->last = NULL;
+	new->elems = g_ptr_array_new ();
+	new->clear_elems = g_ptr_array_new ();
 
-	new->clear_elems = NULL;
-	new->clear_last = NULL;
+	new->flushes = 0;
+	new->flushed_elems = 0;
+	new->damage_area = 0;
 
 	return new;
 }
@@ -99,22 +102,61 @@ html_draw_queue_new (HTMLEngine *engine)
 void
 html_draw_queue_destroy (HTMLDrawQueue *queue)
 {
-	GList *p;
+	guint i;
 
 	g_return_if_fail (queue != NULL);
 
-	for (p = queue->elems; p != NULL; p = p->next) {
+	for (i = 0; i < queue->elems->len; i++) {
 		HTMLObject *obj;
 
-		obj = p->data;
+		obj = g_ptr_array_index (queue->elems, i);
 		obj->redraw_pending = FALSE;
 	}
 
-	g_list_free (queue->elems);
+	for (i = 0; i < queue->clear_elems->len; i++)
+		clear_element_destroy (g_ptr_array_index (queue->clear_elems, i));
+
+	g_ptr_array_free (queue->elems, TRUE);
+	g_ptr_array_free (queue->clear_elems, TRUE);
 
 	g_free (queue);
 }
 
+guint
+html_draw_queue_get_length (HTMLDrawQueue *queue)
+{
+	g_return_val_if_fail (queue != NULL, 0);
+
+	return queue->elems->len + queue->clear_elems->len;
+}
+
+/* Returns the number of pixels invalidated by all flushes so far.  */
+guint64
+html_draw_queue_get_damage_area (HTMLDrawQueue *queue)
+{
+	g_return_val_if_fail (queue != NULL, 0);
+
+	return queue->damage_area;
+}
+
+/* Returns the number of flushes which found elements queued.  */
+guint
+html_draw_queue_get_flushes (HTMLDrawQueue *queue)
+{
+	g_return_val_if_fail (queue != NULL, 0);
+
+	return queue->flushes;
+}
+
+/* Returns the number of queued elements all flushes so far handled.  */
+guint
+html_draw_queue_get_flushed_elems (HTMLDrawQueue *queue)
+{
+	g_return_val_if_fail (queue != NULL, 0);
+
+	return queue->flushed_elems;
+}
+
 void
 html_draw_queue_add (HTMLDrawQueue *queue, HTMLObject *object)
 {
@@ -126,30 +168,21 @@ html_draw_queue_add (HTMLDrawQueue *queue, HTMLObject *object)
 
 	object->redraw_pending = TRUE;
 
-	queue->last = g_list_append (queue->last, object);
-
-	if (queue->elems == NULL && queue->clear_elems == NULL)
+	if (queue->elems->len == 0 && queue->clear_elems->len == 0)
 		g_signal_emit_by_name (queue->engine, "draw_pending");
 
-	if (queue->elems == NULL)
-		queue->elems = queue->last;
-	else
-		queue->last = queue->last->next;
+	g_ptr_array_add (queue->elems, object);
 }
 
-
+
 static void
 add_clear (HTMLDrawQueue *queue,
 	   HTMLDrawQueueClearElement *elem)
 {
-	queue->clear_last = g_list_append (queue->clear_last, elem);
-	if (queue->elems == NULL && queue->clear_elems == NULL)
+	if (queue->elems->len == 0 && queue->clear_elems->len == 0)
 		g_signal_emit_by_name (queue->engine, "draw_pending");
 
-	if (queue->clear_elems == NULL)
-		queue->clear_elems = queue->clear_last;
-	else
-		queue->clear_last = queue->clear_last->next;
+	g_ptr_array_add (queue->clear_elems, elem);
 }
 
 void
@@ -169,9 +202,25 @@ html_draw_queue_add_clear (HTMLDrawQueue *queue,
 	add_clear (queue, new);
 }
 
+static void
+damage_rect (GdkRegion *damage, gint x1, gint y1, gint x2, gint y2)
+{
+	GdkRectangle paint;
+
+	paint.x = x1;
+	paint.y = y1;
+	paint.width = x2 - x1;
+	paint.height = y2 - y1;
+	gdk_region_union_with_rect (damage, &paint);
+}
+
+/* damage is what is visible and gets repainted, changed is the whole
+   changed area for the tile cache, NULL when there is none */
 static void
 draw_obj (HTMLDrawQueue *queue,
-	  HTMLObject *obj)
+	  HTMLObject *obj,
+	  GdkRegion *damage,
+	  GdkRegion *changed)
 {
 	HTMLEngine *e;
 	gint x1, y1, x2, y2;
@@ -181,31 +230,25 @@ draw_obj (HTMLDrawQueue *queue,
 		return;
 
 	e = queue->engine;
-	e->clue->x = html_engine_get_left_border (e);
-	e->clue->y = html_engine_get_top_border (e) + e->clue->ascent;
 
 	html_object_engine_translation (obj, e, &tx, &ty);
-	if (html_object_engine_intersection (obj, e, tx, ty, &x1, &y1, &x2, &y2)) {
-		GdkRectangle paint;
-
-		paint.x = x1;
-		paint.y = y1;
-		paint.width = x2 - x1;
-		paint.height = y2 - y1;
-		gdk_window_invalidate_rect (HTML_GDK_PAINTER (e->painter)->window, &paint, FALSE);
-	}
+	if (changed)
+		damage_rect (changed, obj->x + tx, obj->y - obj->ascent + ty,
+			     obj->x + obj->width + tx, obj->y + obj->descent + ty);
+	if (html_object_engine_intersection (obj, e, tx, ty, &x1, &y1, &x2, &y2))
+		damage_rect (damage, x1, y1, x2, y2);
 }
 
 static void
 clear (HTMLDrawQueue *queue,
-       HTMLDrawQueueClearElement *elem)
+       HTMLDrawQueueClearElement *elem,
+       GdkRegion *damage,
+       GdkRegion *changed)
 {
 	HTMLEngine *e;
 	gint x1, y1, x2, y2;
 
 	e = queue->engine;
-	e->clue->x = html_engine_get_left_border (e);
-	e->clue->y = html_engine_get_top_border (e) + e->clue->ascent;
 
 	x1 = elem->x;
 	y1 = elem->y;
@@ -213,74 +256,134 @@ clear (HTMLDrawQueue *queue,
 	x2 = x1 + elem->width;
 	y2 = y1 + elem->height;
 
-	if (html_engine_intersection (e, &x1, &y1, &x2, &y2)) {
-		GdkRectangle paint;
+	if (changed)
+		damage_rect (changed, x1, y1, x2, y2);
+	if (html_engine_intersection (e, &x1, &y1, &x2, &y2))
+		damage_rect (damage, x1, y1, x2, y2);
+}
+
+/* Merges the region's rectangles, which come in y-x band order, into at
+   most max_rects bounding boxes of neighbours.  Invalidating a little more
+   is cheaper than exposing many small slivers one by one.  */
+static GdkRegion *
+simplify_damage (GdkRegion *damage, gint max_rects)
+{
+	GdkRegion *simple;
+	GdkRectangle *rects, box;
+	gint i, n, group;
+
+	gdk_region_get_rectangles (damage, &rects, &n);
+	if (n <= max_rects) {
+		g_free (rects);
+		return damage;
+	}
 
-		paint.x = x1;
-		paint.y = y1;
-		paint.width = x2 - x1;
-		paint.height = y2 - y1;
-		gdk_window_invalidate_rect (HTML_GDK_PAINTER (e->painter)->window, &paint, FALSE);
+	group = (n + max_rects - 1) / max_rects;
+	simple = gdk_region_new ();
+	for (i = 0; i < n; i++) {
+		if (i % group == 0)
+			box = rects [i];
+		else
+			gdk_rectangle_union (&box, &rects [i], &box);
+		if (i % group == group - 1 || i == n - 1)
+			gdk_region_union_with_rect (simple, &box);
 	}
+
+	g_free (rects);
+	gdk_region_destroy (damage);
+
+	return simple;
+}
+
+static guint64
+region_area (GdkRegion *region)
+{
+	GdkRectangle *rects;
+	guint64 area = 0;
+	gint i, n;
+
+	gdk_region_get_rectangles (region, &rects, &n);
+	for (i = 0; i < n; i++)
+		area += (guint64) rects [i].width * rects [i].height;
+	g_free (rects);
+
+	return area;
 }
 
 void
 html_draw_queue_clear (HTMLDrawQueue *queue)
 {
-	GList *p;
+	guint i;
 
-	for (p = queue->elems; p != NULL; p = p->next) {
-		HTMLObject *obj = HTML_OBJECT (p->data);
+	for (i = 0; i < queue->elems->len; i++) {
+		HTMLObject *obj = HTML_OBJECT (g_ptr_array_index (queue->elems, i));
 
 		obj->redraw_pending = FALSE;
 		if (obj->free_pending) {
 			g_free (obj);
-			p->data = (gpointer)0xdeadbeef;
+			queue->elems->pdata [i] = (gpointer)0xdeadbeef;
 		}
 	}
 
-	g_list_free (queue->clear_elems);
-	g_list_free (queue->elems);
+	for (i = 0; i < queue->clear_elems->len; i++)
+		clear_element_destroy (g_ptr_array_index (queue->clear_elems, i));
 
-	queue->clear_elems = NULL;
-	queue->clear_last = NULL;
-	queue->elems = NULL;
-	queue->last = NULL;
+	g_ptr_array_set_size (queue->clear_elems, 0);
+	g_ptr_array_set_size (queue->elems, 0);
 }
 
 void
 html_draw_queue_flush (HTMLDrawQueue *queue)
 {
-	GList *p;
 	GdkVisual *vis;
+	GdkRegion *damage, *changed;
+	HTMLEngine *e = queue->engine;
+	guint i;
 
 	/* check to make sure we have something to draw on */
 
-	vis = queue->engine->window ? gdk_drawable_get_visual (queue->engine->window): NULL;
+	vis = e->window ? gdk_drawable_get_visual (e->window): NULL;
 
-	/* Draw clear areas.  */
+	if (vis && (queue->elems->len || queue->clear_elems->len)) {
+		damage = gdk_region_new ();
+		changed = e->tile_cache ? gdk_region_new () : NULL;
 
-	for (p = queue->clear_elems; p != NULL; p = p->next) {
-		HTMLDrawQueueClearElement *clear_elem;
+		e->clue->x = html_engine_get_left_border (e);
+		e->clue->y = html_engine_get_top_border (e) + e->clue->ascent;
 
-		clear_elem = p->data;
-		if (vis)
-			clear (queue, clear_elem);
-		clear_element_destroy (clear_elem);
-	}
+		/* Collect clear areas.  */
+
+		for (i = 0; i < queue->clear_elems->len; i++)
+			clear (queue, g_ptr_array_index (queue->clear_elems, i), damage, changed);
 
-	/* Draw objects.  */
+		/* Collect objects.  */
 
-	if (vis) {
-		for (p = queue->elems; p != NULL; p = p->next) {
-			HTMLObject *obj = HTML_OBJECT (p->data);
+		for (i = 0; i < queue->elems->len; i++) {
+			HTMLObject *obj = HTML_OBJECT (g_ptr_array_index (queue->elems, i));
 
 			if (obj->redraw_pending && !obj->free_pending) {
-				draw_obj (queue, obj);
+				draw_obj (queue, obj, damage, changed);
 				obj->redraw_pending = FALSE;
 			}
 		}
+
+		/* Invalidate it all at once.  */
+
+		if (!gdk_region_empty (damage)) {
+			damage = simplify_damage (damage, HTML_DRAW_QUEUE_MAX_RECTS);
+			queue->damage_area += region_area (damage);
+			gdk_window_invalidate_region (HTML_GDK_PAINTER (e->painter)->window, damage, FALSE);
+		}
+		gdk_region_destroy (damage);
+
+		if (changed) {
+			html_tile_cache_invalidate_region (e->tile_cache, changed);
+			gdk_region_destroy (changed);
+		}
+
+		queue->flushes++;
+		queue->flushed_elems += queue->elems->len + queue->clear_elems->len;
 	}
+
 	html_draw_queue_clear (queue);
 }
-
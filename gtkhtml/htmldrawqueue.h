@@ -32,19 +32,25 @@ struct _HTMLDrawQueueClearElement {
 	guint background_image_x_offset, background_image_y_offset;
 };
 
+/* Damage collected in one flush is simplified to at most this many
+   rectangles before the window is invalidated.  */
+#define HTML_DRAW_QUEUE_MAX_RECTS 16
+
 struct _HTMLDrawQueue {
 	/* The associated engine.  */
 	HTMLEngine *engine;
 
-	/* Elements to be drawn.  */
-	GList *elems;
-	/* Pointer to the last element in the list, for faster appending.  */
-	GList *last;
+	/* Elements to be drawn, each object at most once (see
+	   HTMLObject::redraw_pending).  */
+	GPtrArray *elems;
 
 	/* Elements to be cleared (HTMLDrawQueueClearElement).  */
-	GList *clear_elems;
-	/* Pointer to the last element.  */
-	GList *clear_last;
+	GPtrArray *clear_elems;
+
+	/* Statistics: flushes done, elements flushed and pixels invalidated.  */
+	guint flushes;
+	guint flushed_elems;
+	guint64 damage_area;
 };
 
 
@@ -54,6 +60,12 @@ void           html_draw_queue_destroy  (HTMLDrawQueue *queue);
 void           html_draw_queue_flush    (HTMLDrawQueue *queue);
 void           html_draw_queue_clear    (HTMLDrawQueue *queue);
 
+/* Statistics.  */
+guint          html_draw_queue_get_length       (HTMLDrawQueue *queue);
+guint64        html_draw_queue_get_damage_area  (HTMLDrawQueue *queue);
+guint          html_draw_queue_get_flushes      (HTMLDrawQueue *queue);
+guint          html_draw_queue_get_flushed_elems (HTMLDrawQueue *queue);
+
 /* Adding objects.  */
 void           html_draw_queue_add      (HTMLDrawQueue *queue,
 					 HTMLObject    *object);
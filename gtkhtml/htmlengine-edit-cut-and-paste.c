@@ -418,6 +418,7 @@ struct _DeleteUndo {
 	HTMLObject *buffer;
 	guint       buffer_len;
 	gint        level;
+	gboolean    single;     /* made of single character deletions */
 };
 typedef struct _DeleteUndo DeleteUndo;
 
@@ -442,6 +443,66 @@ delete_undo_action (HTMLEngine *e, HTMLUndoData *data, HTMLUndoDirection dir, gu
 	insert_object_for_undo (e, buffer, undo->buffer_len, position_after, undo->level, html_undo_direction_reverse (dir), TRUE);
 }
 
+static void
+add_object_size (HTMLObject *o, HTMLEngine *e, gpointer data)
+{
+	gsize *size = (gsize *) data;
+
+	*size += o->klass->object_size;
+	if (html_object_is_text (o))
+		*size += HTML_TEXT (o)->text_bytes;
+}
+
+static gsize
+delete_undo_size (DeleteUndo *undo)
+{
+	gsize size = sizeof (DeleteUndo);
+
+	if (undo->buffer)
+		html_object_forall (undo->buffer, NULL, add_object_size, &size);
+
+	return size;
+}
+
+/* consecutive single character deletions in plain text, by backspace
+   or by delete, become one deletion of the whole span */
+static gboolean
+delete_undo_merge (HTMLEngine *e, HTMLUndoAction *action, HTMLUndoAction *with)
+{
+	DeleteUndo *undo = (DeleteUndo *) action->data;
+	DeleteUndo *with_undo = (DeleteUndo *) with->data;
+	HTMLText *text, *with_text;
+
+	if (!undo->single || with_undo->buffer_len != 1 || undo->level != with_undo->level
+	    || !undo->buffer || !with_undo->buffer
+	    || HTML_OBJECT_TYPE (undo->buffer) != HTML_TYPE_TEXT || HTML_OBJECT_TYPE (with_undo->buffer) != HTML_TYPE_TEXT)
+		return FALSE;
+
+	text = HTML_TEXT (undo->buffer);
+	with_text = HTML_TEXT (with_undo->buffer);
+	if (text->font_style != with_text->font_style || text->color != with_text->color
+	    || text->links || with_text->links)
+		return FALSE;
+
+	if (with->position_after == action->position) {
+		if (!html_object_merge (with_undo->buffer, undo->buffer, e, NULL, NULL, NULL))
+			return FALSE;
+		undo->buffer = with_undo->buffer;
+		action->position = with->position;
+	} else if (with->position == action->position) {
+		if (!html_object_merge (undo->buffer, with_undo->buffer, e, NULL, NULL, NULL))
+			return FALSE;
+		action->position_after += with_undo->buffer_len;
+	} else
+		return FALSE;
+
+	with_undo->buffer = NULL;
+	undo->buffer_len += with_undo->buffer_len;
+	undo->data.size = delete_undo_size (undo);
+
+	return TRUE;
+}
+
 static void
 delete_setup_undo (HTMLEngine *e, HTMLObject *buffer, guint len, guint position_after, gint level, HTMLUndoDirection dir)
 {
@@ -454,9 +515,12 @@ delete_setup_undo (HTMLEngine *e, HTMLObject *buffer, guint len, guint position_
 #endif
 	html_undo_data_init (HTML_UNDO_DATA (undo));
 	undo->data.destroy = delete_undo_destroy;
+	undo->data.merge   = delete_undo_merge;
 	undo->buffer       = buffer;
 	undo->buffer_len   = len;
 	undo->level        = level;
+	undo->single       = len == 1;
+	undo->data.size    = delete_undo_size (undo);
 
 #ifdef OP_DEBUG
 	printf ("delete undo len %d\n", len);
@@ -944,6 +1008,7 @@ struct _InsertUndo {
 	guint len;
 	gboolean delete_paragraph_before;
 	gboolean delete_paragraph_after;
+	gboolean in_word;
 };
 typedef struct _InsertUndo InsertUndo;
 
@@ -974,6 +1039,27 @@ insert_undo_action (HTMLEngine *e, HTMLUndoData *data, HTMLUndoDirection dir, gu
 	}
 }
 
+/* characters typed one after another become one insertion, a new one
+   starts with each word */
+static gboolean
+insert_undo_merge (HTMLEngine *e, HTMLUndoAction *action, HTMLUndoAction *with)
+{
+	InsertUndo *undo = (InsertUndo *) action->data;
+	InsertUndo *with_undo = (InsertUndo *) with->data;
+
+	if (with_undo->len != 1 || with->position_after != action->position
+	    || undo->delete_paragraph_before || undo->delete_paragraph_after
+	    || with_undo->delete_paragraph_before || with_undo->delete_paragraph_after
+	    || (with_undo->in_word && !undo->in_word))
+		return FALSE;
+
+	action->position = with->position;
+	undo->len       += with_undo->len;
+	undo->in_word    = with_undo->in_word;
+
+	return TRUE;
+}
+
 static void
 insert_setup_undo (HTMLEngine *e, guint len, guint position_before, HTMLUndoDirection dir,
 		   gboolean delete_paragraph_before, gboolean delete_paragraph_after)
@@ -983,9 +1069,12 @@ insert_setup_undo (HTMLEngine *e, guint len, guint position_before, HTMLUndoDire
 	undo = g_new (InsertUndo, 1);
 
 	html_undo_data_init (HTML_UNDO_DATA (undo));
+	undo->data.merge = insert_undo_merge;
+	undo->data.size  = sizeof (InsertUndo);
 	undo->len = len;
 	undo->delete_paragraph_before = delete_paragraph_before;
 	undo->delete_paragraph_after  = delete_paragraph_after;
+	undo->in_word = len == 1 && html_is_in_word (html_cursor_get_prev_char (e->cursor));
 
 	/* printf ("insert undo len %d\n", len); */
 
@@ -1175,7 +1264,21 @@ check_magic_link (HTMLEngine *e, const gchar *text, guint len)
 	    && gtk_html_get_magic_links (e->widget)
 	    && len == 1
 	    && (*text == ' ' || text [0] == '\n' || text [0] == '>' || text [0] == ')'))
-		html_text_magic_link (HTML_TEXT (e->cursor->object), e, 1);
+		html_text_magic_link (HTML_TEXT (e->cursor->object), e, e->cursor->offset);
+}
+
+/* links the addresses in pasted text, the cursor is behind it */
+static void
+check_magic_links (HTMLEngine *e, guint len)
+{
+	if (HTML_IS_TEXT (e->cursor->object)
+	    && gtk_html_get_magic_links (e->widget)
+	    && len > 1 && e->cursor->offset >= len) {
+		html_engine_freeze (e);
+		if (html_text_magic_links (HTML_TEXT (e->cursor->object), e, e->cursor->offset - len, e->cursor->offset))
+			html_object_change_set (e->cursor->object, HTML_CHANGE_ALL_CALC);
+		html_engine_thaw (e);
+	}
 }
 
 static void
@@ -1437,6 +1540,7 @@ html_engine_insert_text_with_extra_attributes (HTMLEngine *e, const gchar *text,
 				       1, HTML_UNDO_UNDO, check);
 			if (alen == 1 && !HTML_IS_PLAIN_PAINTER (e->painter))
 				use_pictograms (e);
+			check_magic_links (e, alen);
 		}
 		if (nl) {
 			html_engine_insert_empty_paragraph (e);
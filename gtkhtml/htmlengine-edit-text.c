@@ -61,6 +61,8 @@ upper_lower (HTMLObject *obj, HTMLEngine *e, gpointer data)
 		g_free (old_text);
 		HTML_TEXT (obj)->text_len = g_utf8_strlen (HTML_TEXT (obj)->text, -1);
 		HTML_TEXT (obj)->text_bytes = strlen (HTML_TEXT (obj)->text);
+		HTML_TEXT (obj)->text_size = 0;
+		html_text_changed (HTML_TEXT (obj));
 	}
 }
 
@@ -21,6 +21,7 @@
 
 #include <config.h>
 
+#include "htmlclue.h"
 #include "htmlcursor.h"
 #include "htmlengine.h"
 #include "htmlengine-edit.h"
@@ -235,3 +236,484 @@ html_engine_search_incremental (HTMLEngine *e, const gchar *text, gboolean forwa
 	} else
 		return html_engine_search (e, text, FALSE, forward, FALSE);
 }
+
+/* Find all.  The matches are collected flow by flow from a low priority
+   idle handler, so the count grows while the document is scanned.  Each
+   flow remembers the text objects it was scanned with, after an edit only
+   the flows whose texts changed are searched again. */
+
+#define SEARCH_ALL_SLICE 0.005 /* seconds of scanning per idle call */
+
+typedef struct {
+	HTMLText *text;
+	guint offset;
+	guint len;
+} SearchAllSegment;
+
+typedef struct {
+	HTMLObject *object;
+	guint stamp;       /* of texts, see html_text_changed */
+} SearchAllKey;
+
+typedef struct {
+	GArray *keys;      /* children of the flow when it was scanned */
+	GArray *matches;   /* HTMLSearchMatch */
+	GArray *segments;  /* matched parts of the texts */
+} SearchAllFlow;
+
+typedef struct {
+	GPtrArray *texts;
+	guint i;           /* text at the position */
+	guint start;       /* run index of the text start */
+	guint pos;         /* byte index into the text */
+	guint offset;      /* character offset of pos */
+} SearchAllRun;
+
+struct _HTMLSearchAll {
+	HTMLEngine *engine;
+	HTMLSearch *search;
+	gboolean highlight;
+
+	GList *flows;
+	GList *scan;
+	GHashTable *scanned;     /* flow -> SearchAllFlow of this pass */
+	GHashTable *previous;    /* flow -> SearchAllFlow of former passes */
+
+	GArray *matches;         /* HTMLSearchMatch in document order */
+	GHashTable *highlights;  /* text -> GArray of HTMLSearchHighlight */
+
+	guint idle_id;
+};
+
+static void
+search_all_flow_free (SearchAllFlow *f)
+{
+	g_array_free (f->keys, TRUE);
+	g_array_free (f->matches, TRUE);
+	g_array_free (f->segments, TRUE);
+	g_free (f);
+}
+
+static void
+search_all_key (GArray *keys, HTMLObject *o)
+{
+	SearchAllKey key;
+
+	key.object = o;
+	key.stamp = html_object_is_text (o) ? HTML_TEXT (o)->stamp : 0;
+	g_array_append_val (keys, key);
+}
+
+static gboolean
+search_all_flow_valid (SearchAllFlow *f, HTMLObject *flow)
+{
+	HTMLObject *cur;
+	guint i = 0;
+
+	for (cur = HTML_CLUE (flow)->head; cur; cur = cur->next) {
+		SearchAllKey *key;
+
+		if (HTML_OBJECT_TYPE (cur) == HTML_TYPE_TEXTSLAVE)
+			continue;
+		if (i >= f->keys->len)
+			return FALSE;
+		key = &g_array_index (f->keys, SearchAllKey, i);
+		if (key->object != cur)
+			return FALSE;
+		if (html_object_is_text (cur) && key->stamp != HTML_TEXT (cur)->stamp)
+			return FALSE;
+		i++;
+	}
+
+	return i == f->keys->len;
+}
+
+static void
+search_all_seek (SearchAllRun *r, guint index)
+{
+	HTMLText *text;
+
+	while (r->i < r->texts->len
+	       && r->start + HTML_TEXT (g_ptr_array_index (r->texts, r->i))->text_bytes <= index) {
+		r->start += HTML_TEXT (g_ptr_array_index (r->texts, r->i))->text_bytes;
+		r->i++;
+		r->pos = r->offset = 0;
+	}
+
+	text = HTML_TEXT (g_ptr_array_index (r->texts, r->i));
+	r->offset += g_utf8_pointer_to_offset (text->text + r->pos, text->text + index - r->start);
+	r->pos = index - r->start;
+}
+
+static void
+search_all_add_match (SearchAllFlow *f, SearchAllRun *r, guint index, guint bytes)
+{
+	HTMLSearchMatch match = { NULL, 0, NULL, 0 };
+	guint end = index + bytes;
+
+	search_all_seek (r, index);
+	while (r->i < r->texts->len) {
+		HTMLText *text = HTML_TEXT (g_ptr_array_index (r->texts, r->i));
+		guint text_end = MIN (end, r->start + text->text_bytes) - r->start;
+
+		if (text_end > r->pos) {
+			SearchAllSegment segment;
+
+			segment.text = text;
+			segment.offset = r->offset;
+			segment.len = g_utf8_pointer_to_offset (text->text + r->pos, text->text + text_end);
+			g_array_append_val (f->segments, segment);
+
+			if (!match.first) {
+				match.first = HTML_OBJECT (text);
+				match.start_pos = segment.offset;
+			}
+			match.last = HTML_OBJECT (text);
+			match.stop_pos = segment.offset + segment.len;
+
+			r->pos = text_end;
+			r->offset += segment.len;
+		}
+
+		if (r->start + text->text_bytes >= end)
+			break;
+		r->start += text->text_bytes;
+		r->i++;
+		r->pos = r->offset = 0;
+	}
+
+	g_array_append_val (f->matches, match);
+}
+
+static void
+search_all_run (HTMLSearchAll *sa, SearchAllFlow *f, GPtrArray *texts)
+{
+	SearchAllRun r = { texts, 0, 0, 0, 0 };
+	guint bytes, index = 0, match_index, match_bytes;
+
+	html_search_get_run_text (sa->search, texts, &bytes);
+	while (index < bytes && html_search_match (sa->search, index, bytes, &match_index, &match_bytes)) {
+		search_all_add_match (f, &r, match_index, match_bytes);
+		index = match_index + match_bytes;
+	}
+}
+
+static SearchAllFlow *
+search_all_flow_scan (HTMLSearchAll *sa, HTMLObject *flow)
+{
+	SearchAllFlow *f = g_new (SearchAllFlow, 1);
+	GPtrArray *texts = g_ptr_array_new ();
+	HTMLObject *cur;
+
+	f->keys = g_array_new (FALSE, FALSE, sizeof (SearchAllKey));
+	f->matches = g_array_new (FALSE, FALSE, sizeof (HTMLSearchMatch));
+	f->segments = g_array_new (FALSE, FALSE, sizeof (SearchAllSegment));
+
+	for (cur = HTML_CLUE (flow)->head; ; cur = cur->next) {
+		if (cur && HTML_OBJECT_TYPE (cur) == HTML_TYPE_TEXTSLAVE)
+			continue;
+		if (cur && html_object_is_text (cur)) {
+			search_all_key (f->keys, cur);
+			g_ptr_array_add (texts, cur);
+			continue;
+		}
+		if (texts->len > 0) {
+			search_all_run (sa, f, texts);
+			g_ptr_array_set_size (texts, 0);
+		}
+		if (!cur)
+			break;
+		search_all_key (f->keys, cur);
+	}
+	g_ptr_array_free (texts, TRUE);
+
+	return f;
+}
+
+static void
+search_all_flow_add (HTMLSearchAll *sa, SearchAllFlow *f, gboolean draw)
+{
+	guint i;
+
+	g_array_append_vals (sa->matches, f->matches->data, f->matches->len);
+
+	for (i = 0; i < f->segments->len; i++) {
+		SearchAllSegment *segment = &g_array_index (f->segments, SearchAllSegment, i);
+		HTMLSearchHighlight highlight;
+		GArray *highlights;
+
+		highlights = g_hash_table_lookup (sa->highlights, segment->text);
+		if (!highlights) {
+			highlights = g_array_new (FALSE, FALSE, sizeof (HTMLSearchHighlight));
+			g_hash_table_insert (sa->highlights, segment->text, highlights);
+		}
+		highlight.offset = segment->offset;
+		highlight.len = segment->len;
+		g_array_append_val (highlights, highlight);
+
+		if (draw && sa->highlight)
+			html_text_queue_draw (segment->text, sa->engine, segment->offset, segment->len);
+	}
+}
+
+static gboolean
+search_all_idle (gpointer data)
+{
+	HTMLSearchAll *sa = data;
+	GTimer *timer;
+
+	/* the tree is being changed, html_engine_search_all_update restarts us */
+	if (html_engine_frozen (sa->engine)) {
+		sa->idle_id = 0;
+		return FALSE;
+	}
+
+	timer = g_timer_new ();
+	while (sa->scan && g_timer_elapsed (timer, NULL) < SEARCH_ALL_SLICE) {
+		HTMLObject *flow = HTML_OBJECT (sa->scan->data);
+		SearchAllFlow *f = g_hash_table_lookup (sa->previous, flow);
+		gboolean changed = FALSE;
+
+		if (f && search_all_flow_valid (f, flow))
+			g_hash_table_steal (sa->previous, flow);
+		else {
+			f = search_all_flow_scan (sa, flow);
+			changed = TRUE;
+		}
+		g_hash_table_insert (sa->scanned, flow, f);
+		search_all_flow_add (sa, f, changed);
+
+		sa->scan = sa->scan->next;
+	}
+	g_timer_destroy (timer);
+
+	if (sa->scan)
+		return TRUE;
+
+	/* what was not found again belongs to removed flows */
+	g_hash_table_remove_all (sa->previous);
+	sa->idle_id = 0;
+
+	return FALSE;
+}
+
+static void
+search_all_collect_flow (HTMLObject *o, HTMLEngine *e, gpointer data)
+{
+	HTMLSearchAll *sa = data;
+
+	/* frames and iframes have their own engines */
+	if (HTML_OBJECT_TYPE (o) == HTML_TYPE_CLUEFLOW && e == sa->engine)
+		sa->flows = g_list_prepend (sa->flows, o);
+}
+
+static gboolean
+search_all_keep_scanned (gpointer key, gpointer value, gpointer data)
+{
+	g_hash_table_replace ((GHashTable *) data, key, value);
+
+	return TRUE;
+}
+
+static void
+search_all_start (HTMLSearchAll *sa)
+{
+	HTMLEngine *e = sa->engine;
+
+	g_hash_table_foreach_steal (sa->scanned, search_all_keep_scanned, sa->previous);
+	g_array_set_size (sa->matches, 0);
+	g_hash_table_remove_all (sa->highlights);
+
+	g_list_free (sa->flows);
+	sa->flows = NULL;
+	if (e->clue)
+		html_object_forall (e->clue, e, search_all_collect_flow, sa);
+	sa->flows = g_list_reverse (sa->flows);
+	sa->scan = sa->flows;
+
+	if (!sa->idle_id)
+		sa->idle_id = g_idle_add_full (G_PRIORITY_LOW, search_all_idle, sa, NULL);
+}
+
+static void
+search_all_destroy (HTMLSearchAll *sa)
+{
+	if (sa->idle_id)
+		g_source_remove (sa->idle_id);
+	html_search_destroy (sa->search);
+	g_list_free (sa->flows);
+	g_hash_table_destroy (sa->scanned);
+	g_hash_table_destroy (sa->previous);
+	g_array_free (sa->matches, TRUE);
+	g_hash_table_destroy (sa->highlights);
+	g_free (sa);
+}
+
+static void
+search_all_free_highlights (GArray *highlights)
+{
+	g_array_free (highlights, TRUE);
+}
+
+void
+html_engine_search_all (HTMLEngine *e, const gchar *text,
+			gboolean case_sensitive, gboolean regular, gboolean highlight)
+{
+	HTMLSearchAll *sa;
+
+	g_return_if_fail (HTML_IS_ENGINE (e));
+	g_return_if_fail (text != NULL);
+
+	html_engine_search_all_clear (e);
+
+	sa = e->search_all = g_new0 (HTMLSearchAll, 1);
+	sa->engine = e;
+	sa->search = html_search_new (e, text, case_sensitive, TRUE, regular);
+	sa->highlight = highlight;
+	sa->scanned = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+					     (GDestroyNotify) search_all_flow_free);
+	sa->previous = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+					      (GDestroyNotify) search_all_flow_free);
+	sa->matches = g_array_new (FALSE, FALSE, sizeof (HTMLSearchMatch));
+	sa->highlights = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+						(GDestroyNotify) search_all_free_highlights);
+
+	search_all_start (sa);
+}
+
+/* called after the document changed, rescans the flows which did */
+void
+html_engine_search_all_update (HTMLEngine *e)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	if (e->search_all)
+		search_all_start (e->search_all);
+}
+
+/* Drops what was found in the flow of text before the text is cut, merged
+   or split, the matches would refer to objects the edit may free.  The
+   flow is searched again when the engine thaws. */
+void
+html_engine_search_all_forget (HTMLEngine *e, HTMLObject *text)
+{
+	HTMLSearchAll *sa;
+	SearchAllFlow *f;
+	guint i, j;
+
+	if (!e || !e->search_all || !text->parent)
+		return;
+
+	sa = e->search_all;
+	g_hash_table_remove (sa->previous, text->parent);
+	f = g_hash_table_lookup (sa->scanned, text->parent);
+	if (!f)
+		return;
+
+	/* matches and highlights are compared by address only, the other
+	   texts of the flow may be gone already */
+	for (i = 0; i < f->keys->len; i++) {
+		HTMLObject *o = g_array_index (f->keys, SearchAllKey, i).object;
+
+		g_hash_table_remove (sa->highlights, o);
+		for (j = 0; j < sa->matches->len;) {
+			if (g_array_index (sa->matches, HTMLSearchMatch, j).first == o)
+				g_array_remove_index (sa->matches, j);
+			else
+				j++;
+		}
+	}
+	g_hash_table_remove (sa->scanned, text->parent);
+}
+
+/* frees the find all state without redrawing, for engines being destroyed */
+void
+html_engine_search_all_destroy (HTMLEngine *e)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	if (e->search_all) {
+		search_all_destroy (e->search_all);
+		e->search_all = NULL;
+	}
+}
+
+void
+html_engine_search_all_clear (HTMLEngine *e)
+{
+	HTMLSearchAll *sa;
+
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	sa = e->search_all;
+	if (!sa)
+		return;
+
+	e->search_all = NULL;
+	if (sa->highlight && sa->matches->len > 0 && e->widget)
+		html_engine_draw (e, e->x_offset, e->y_offset, e->width, e->height);
+	search_all_destroy (sa);
+}
+
+gboolean
+html_engine_search_all_done (HTMLEngine *e)
+{
+	g_return_val_if_fail (HTML_IS_ENGINE (e), TRUE);
+
+	return !e->search_all || !e->search_all->scan;
+}
+
+guint
+html_engine_search_all_get_count (HTMLEngine *e)
+{
+	g_return_val_if_fail (HTML_IS_ENGINE (e), 0);
+
+	return e->search_all ? e->search_all->matches->len : 0;
+}
+
+const HTMLSearchMatch *
+html_engine_search_all_get_match (HTMLEngine *e, guint n)
+{
+	g_return_val_if_fail (HTML_IS_ENGINE (e), NULL);
+
+	if (!e->search_all || n >= e->search_all->matches->len)
+		return NULL;
+
+	return &g_array_index (e->search_all->matches, HTMLSearchMatch, n);
+}
+
+gboolean
+html_engine_search_all_select (HTMLEngine *e, guint n)
+{
+	const HTMLSearchMatch *match;
+
+	g_return_val_if_fail (HTML_IS_ENGINE (e), FALSE);
+
+	match = html_engine_search_all_get_match (e, n);
+	if (!match)
+		return FALSE;
+
+	if (e->editable) {
+		html_engine_hide_cursor (e);
+		html_engine_disable_selection (e);
+		html_cursor_jump_to (e->cursor, e, match->first, match->start_pos);
+		html_engine_set_mark (e);
+		html_cursor_jump_to (e->cursor, e, match->last, match->stop_pos);
+		html_engine_show_cursor (e);
+	} else
+		html_engine_select_interval (e, html_interval_new (match->first, match->last,
+								   match->start_pos, match->stop_pos));
+
+	return TRUE;
+}
+
+/* HTMLSearchHighlight ranges of the text in offset order, NULL when
+   nothing is to be highlighted */
+GArray *
+html_engine_search_all_get_highlights (HTMLEngine *e, HTMLText *text)
+{
+	if (!e->search_all || !e->search_all->highlight)
+		return NULL;
+
+	return g_hash_table_lookup (e->search_all->highlights, text);
+}
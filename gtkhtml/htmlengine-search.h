@@ -32,3 +32,36 @@ gboolean  html_engine_search_next               (HTMLEngine *e);
 gboolean  html_engine_search_incremental        (HTMLEngine *e,
 						 const gchar *text,
 						 gboolean forward);
+
+/* a match of html_engine_search_all, offsets are in characters */
+typedef struct {
+	HTMLObject *first;
+	guint       start_pos;
+	HTMLObject *last;
+	guint       stop_pos;
+} HTMLSearchMatch;
+
+typedef struct {
+	guint offset;
+	guint len;
+} HTMLSearchHighlight;
+
+void      html_engine_search_all                (HTMLEngine *e,
+						 const gchar *text,
+						 gboolean case_sensitive,
+						 gboolean regular,
+						 gboolean highlight);
+void      html_engine_search_all_update         (HTMLEngine *e);
+void      html_engine_search_all_clear          (HTMLEngine *e);
+void      html_engine_search_all_destroy        (HTMLEngine *e);
+void      html_engine_search_all_forget         (HTMLEngine *e,
+						 HTMLObject *text);
+gboolean  html_engine_search_all_done           (HTMLEngine *e);
+guint     html_engine_search_all_get_count      (HTMLEngine *e);
+const HTMLSearchMatch *
+          html_engine_search_all_get_match      (HTMLEngine *e,
+						 guint n);
+gboolean  html_engine_search_all_select         (HTMLEngine *e,
+						 guint n);
+GArray   *html_engine_search_all_get_highlights (HTMLEngine *e,
+						 HTMLText *text);
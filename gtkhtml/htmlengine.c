@@ -38,6 +38,7 @@
 #include <libxml/parser.h>
 #include <libxml/parserInternals.h>
 #include <libxml/HTMLparser.h>
+#include <libxml/SAX2.h>
 #include <libcroco/libcroco.h>
 
 #include "gtkhtml-embedded.h"
@@ -64,6 +65,7 @@
 #include "htmlundo.h"
 #include "htmldrawqueue.h"
 #include "htmlgdkpainter.h"
+#include "htmltilecache.h"
 #include "htmlplainpainter.h"
 #include "htmlreplace.h"
 #include "htmlentity.h"
@@ -78,6 +80,7 @@
 #include "htmllist.h"
 #include "htmltable.h"
 #include "htmltablecell.h"
+#include "htmltag.h"
 #include "htmltext.h"
 #include "htmltextslave.h"
 #include "htmlclueflow.h"
@@ -101,6 +104,7 @@
 #include "htmlmap.h"
 #include "htmlmarshal.h"
 #include "htmlstyle.h"
+#include "htmlcss.h"
 
 /* #define USEOLDRENDER */
 /* #define CHECK_CURSOR */
@@ -129,14 +133,31 @@ static void      html_engine_stream_end       (GtkHTMLStream       *stream,
 					       gpointer             data);
 static void      html_engine_set_object_data  (HTMLEngine          *e,
 					       HTMLObject          *o);
+static void      html_engine_parser_free      (HTMLEngine          *e);
+static void      html_engine_stream_finish    (HTMLEngine          *e);
 
 static void      update_embedded           (GtkWidget *widget,
 					    gpointer );
+static void      spell_check_start         (HTMLEngine *e);
+static void      spell_check_cancel        (HTMLEngine *e);
+static void      spell_check_invalidate    (HTMLEngine *e);
 
 static void      html_engine_map_table_clear (HTMLEngine *e);
 static void      html_engine_id_table_clear (HTMLEngine *e);
 static void      clear_pending_expose (HTMLEngine *e);
 
+#ifndef USEOLDRENDER
+static gboolean  html_engine_progressive_build  (HTMLEngine *e, gboolean finished);
+static void      html_engine_progressive_reset  (HTMLEngine *e);
+static void      html_engine_progressive_update (HTMLEngine *e);
+static gboolean  html_engine_parser_thread_start  (HTMLEngine *e);
+static void      html_engine_parser_thread_cancel (HTMLEngine *e);
+static void      parser_thread_send             (HTMLParserThread *pt,
+						 const gchar *data,
+						 gsize size,
+						 gboolean last);
+#endif
+
 #ifdef USEOLDRENDER
 static void      push_clue (HTMLEngine *e, HTMLObject *clue);
 static void      pop_clue (HTMLEngine *e);
@@ -247,7 +268,19 @@ static guint signals [LAST_SIGNAL] = { 0 };
 #define ID_U "u"
 #define ID_VAR "var"
 
-#define ID_EQ(x,y) (x == g_quark_from_string (y))
+/* atom of a literal tag or attribute name, looked up once per call site */
+#if defined (__GNUC__)
+#  define HTML_ATOM(name) ({							\
+	static GQuark _atom_ = 0;						\
+	if (!_atom_)								\
+		_atom_ = g_quark_from_static_string (name);			\
+	_atom_;									\
+    })
+#else
+#  define HTML_ATOM(name) g_quark_from_static_string (name)
+#endif
+
+#define ID_EQ(x,y) (x == HTML_ATOM (y))
 
 #ifdef USEOLDRENDER
 #define ELEMENT_PARSE_PARAMS HTMLEngine *e, HTMLObject *clue, xmlNode* xmlelement
@@ -268,11 +301,25 @@ static gchar default_content_type[] = "html/text; charset=utf-8";
 /* Font styles */
 typedef struct _HTMLElement HTMLElement;
 typedef void (*BlockFunc)(HTMLEngine *e, HTMLObject *clue, HTMLElement *el);
+
+typedef struct {
+	GQuark       name;   /* lowercase attribute name */
+	const gchar *value;  /* borrowed from the xml node */
+} HTMLElementAttr;
+
+/* most elements have a few attributes, they fit in the element itself */
+#define HTML_ELEMENT_INLINE_ATTRS 4
+
 struct _HTMLElement {
 	GQuark          id;
+	HTMLTagId       tag;
 	HTMLStyle      *style;
 
-	GHashTable     *attributes;  /* the parsed attributes */
+	/* the parsed attributes in source order, valid as long as the xml node */
+	HTMLElementAttr *attrs;
+	guint            n_attrs;
+	guint            attrs_size;
+	HTMLElementAttr  inline_attrs [HTML_ELEMENT_INLINE_ATTRS];
 
 	gint level;
 	gint miscData1;
@@ -310,9 +357,8 @@ HTMLObject* tag_func_td                  (TAG_FUNC_PARAM);
 HTMLObject* element_parse_nodedump_htmlobject_one(xmlNode* xmlelement, gint pos, HTMLEngine *e, HTMLObject* htmlelement, HTMLObject* parentclue, HTMLStyle *parent_style, gint *count);
 HTMLObject* element_parse_nodedump_htmlobject  (xmlNode* xmlelement, gint pos, HTMLEngine *e, HTMLObject* htmlelement, HTMLObject* parentclue, HTMLStyle *parent_style);
 #endif
-void           process_node             (xmlNode* node, const gchar * css);
 void           html_element_parse_styleattrs (HTMLElement *node);
-const gchar*   to_standart_attr         (const gchar* element_name,const gchar* attribute_name);
+const gchar*   to_standart_attr         (HTMLTagId tag, GQuark attribute);
 void           set_style_to_text        (HTMLText *text, HTMLStyle *style, HTMLEngine *e, gint start_index, gint end_index);
 HTMLObject*    create_from_xml_fix_align(HTMLObject *o, HTMLElement *element, gint max_width);
 HTMLText *     create_text_from_xml     (HTMLEngine *e, HTMLElement *element, const gchar* text);
@@ -377,84 +423,130 @@ parse_element_name (const gchar *str)
 }
 #endif
 
+/* the html parser gives lowercase names, downcase only the odd ones */
+static GQuark
+html_atom_from_name (const gchar *name)
+{
+	const gchar *p;
+
+	for (p = name; *p; p++)
+		if (g_ascii_isupper (*p)) {
+			gchar *lower = g_ascii_strdown (name, -1);
+			GQuark atom = g_quark_from_string (lower);
+
+			g_free (lower);
+			return atom;
+		}
+
+	return g_quark_from_string (name);
+}
+
+/* safe to use from the parser thread, the tag table is read only */
+static HTMLTagId
+html_tag_of_node (const xmlNode *node)
+{
+	if (!node->name)
+		return HTML_TAG_UNKNOWN;
+
+	return html_tag_lookup (XMLCHAR2GCHAR (node->name), strlen (XMLCHAR2GCHAR (node->name)));
+}
+
 static HTMLElement *
 html_element_new (HTMLEngine *e, const gchar *name)
 {
 	HTMLElement *element;
 
 	element = g_new0 (HTMLElement, 1);
-	element->id = g_quark_from_string (name);
+	element->id = html_atom_from_name (name);
+	element->tag = html_tag_lookup (name, strlen (name));
+	element->attrs = element->inline_attrs;
+	element->attrs_size = HTML_ELEMENT_INLINE_ATTRS;
 
 	return element;
 }
 
-#ifndef NO_ATTR_MACRO
-/* Macro definition to avoid bogus warnings about strict aliasing.
- */
-#  if __GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 3)
-#    define html_element_get_attr(node, key, value) ({					\
-	gpointer _tmp_;									\
-        (g_hash_table_lookup_extended (node->attributes, key, NULL, &_tmp_) && _tmp_) ?	\
-           (*value = _tmp_, TRUE) : FALSE;						\
-    })
-#  else
-#    define html_element_get_attr(node, key, value) (g_hash_table_lookup_extended (node->attributes, key, NULL, (gpointer *)value) && *value)
-#  endif
-#define html_element_has_attr(node, key) g_hash_table_lookup_extended (node->attributes, key, NULL, NULL)
-#else
-gboolean
-html_element_get_attr (HTMLElement *node, gchar *name, gchar **value)
+/* attribute names are lowercase atoms, see html_element_from_xml */
+static const HTMLElementAttr *
+html_element_find_attr (HTMLElement *element, GQuark name)
 {
-	gchar *orig_key;
+	guint i;
+
+	if (!name)
+		return NULL;
 
-	g_return_if_fail (node->attributes != NULL);
+	for (i = 0; i < element->n_attrs; i++)
+		if (element->attrs [i].name == name)
+			return &element->attrs [i];
 
-	return g_hash_table_lookup_extended (node->attributes, name, &orig_key, value)
+	return NULL;
 }
-#endif
 
-/* parse style*/
-const gchar*
-to_standart_attr(const gchar* element_name,const gchar* attribute_name)
+static gboolean
+html_element_lookup_attr (HTMLElement *element, GQuark name, gchar **value)
 {
-	if (
-		(
-			!g_ascii_strcasecmp (ID_OL, element_name) ||
-			!g_ascii_strcasecmp (ID_LI, element_name)
-		) && 
-		!g_ascii_strcasecmp ("type", attribute_name)
-	)
-		return "list-style-type";
+	const HTMLElementAttr *attr = html_element_find_attr (element, name);
 
-	if (
-		!g_ascii_strcasecmp (ID_HR, element_name) &&
-		!g_ascii_strcasecmp ("length", attribute_name)
-	)
-		return "width";
+	if (!attr || !attr->value)
+		return FALSE;
 
-	if (
-		(
-			!g_ascii_strcasecmp (ID_HR, element_name) ||
-			!g_ascii_strcasecmp (ID_SELECT, element_name) ||
-			!g_ascii_strcasecmp (ID_FONT, element_name)
-		) && 	
-		!g_ascii_strcasecmp ("size", attribute_name)
-	)
-		return "height";
+	*value = (gchar *) attr->value;
+	return TRUE;
+}
 
-	if (
-		(
-			!g_ascii_strcasecmp (ID_TH, element_name) ||
-			!g_ascii_strcasecmp (ID_TD, element_name)
-		) &&
-		!g_ascii_strcasecmp ("background", attribute_name)
-	)
-		return "background-image";
-		   
-	if ( !g_ascii_strcasecmp ("background-color", attribute_name))
+#define html_element_get_attr(node, key, value) html_element_lookup_attr (node, HTML_ATOM (key), value)
+#define html_element_has_attr(node, key) (html_element_find_attr (node, HTML_ATOM (key)) != NULL)
+
+static void
+html_element_add_attr (HTMLElement *element, GQuark name, const gchar *value)
+{
+	if (element->n_attrs == element->attrs_size) {
+		element->attrs_size *= 2;
+		if (element->attrs == element->inline_attrs) {
+			element->attrs = g_new (HTMLElementAttr, element->attrs_size);
+			memcpy (element->attrs, element->inline_attrs, sizeof (element->inline_attrs));
+		} else
+			element->attrs = g_renew (HTMLElementAttr, element->attrs, element->attrs_size);
+	}
+
+	element->attrs [element->n_attrs].name = name;
+	element->attrs [element->n_attrs].value = value;
+	element->n_attrs++;
+}
+
+/* parse style*/
+const gchar*
+to_standart_attr (HTMLTagId tag, GQuark attribute)
+{
+	switch (tag) {
+	case HTML_TAG_OL:
+	case HTML_TAG_LI:
+		if (ID_EQ (attribute, "type"))
+			return "list-style-type";
+		break;
+	case HTML_TAG_HR:
+		if (ID_EQ (attribute, "length"))
+			return "width";
+		if (ID_EQ (attribute, "size"))
+			return "height";
+		break;
+	case HTML_TAG_SELECT:
+	case HTML_TAG_FONT:
+		if (ID_EQ (attribute, "size"))
+			return "height";
+		break;
+	case HTML_TAG_TH:
+	case HTML_TAG_TD:
+		if (ID_EQ (attribute, "background"))
+			return "background-image";
+		break;
+	default:
+		break;
+	}
+
+	if (ID_EQ (attribute, "background-color"))
 		return "bgcolor";
 
-	return attribute_name;
+	return g_quark_to_string (attribute);
 }
 
 void
@@ -476,13 +568,12 @@ html_element_parse_styleattrs (HTMLElement *node)
 						}
 						if (!value)
 							value = g_strdup("");
-						if (!g_hash_table_lookup (node->attributes, lower)) {
+						if (!html_element_find_attr (node, g_quark_try_string (lower))) {
 							DE (g_print ("attrs (%s, %s)", lower, value));
 							node->style = html_style_add_styleattribute (node->style, lower, value);
-						} else {
-							g_free (lower);
-							g_free (value);
 						}
+						g_free (lower);
+						g_free (value);
 					}
 					g_strfreev(styleelem);
 				}
@@ -493,129 +584,145 @@ html_element_parse_styleattrs (HTMLElement *node)
 	};
 }
 
+/* matched style sheet declarations, the attributes and the style
+   attribute win over them */
+static void
+html_element_add_css_property (const gchar *name, const gchar *value, gpointer data)
+{
+	HTMLElement *element = data;
+
+	if (!html_element_find_attr (element, g_quark_try_string (name)))
+		element->style = html_style_add_styleattribute (element->style, name, value);
+}
+
 /*set style by tag name*/
 static HTMLStyle *
-gen_style_for_element(const gchar *name, HTMLStyle *style)
+gen_style_for_element (HTMLTagId tag, HTMLStyle *style)
 {
-	g_return_val_if_fail (name, style);
-	if (!g_ascii_strcasecmp(name, ID_B)) {
+	switch (tag) {
+	case HTML_TAG_B:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_BOLD);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_CODE) ||
-				!g_ascii_strcasecmp(name, ID_KBD)  ||
-				!g_ascii_strcasecmp(name, ID_TT)   ||
-				!g_ascii_strcasecmp(name, ID_VAR) ) {
+		break;
+	case HTML_TAG_CODE:
+	case HTML_TAG_KBD:
+	case HTML_TAG_TT:
+	case HTML_TAG_VAR:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_FIXED);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_STRIKE) ||
-				!g_ascii_strcasecmp(name, ID_S) ) {
+		break;
+	case HTML_TAG_STRIKE:
+	case HTML_TAG_S:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_STRIKEOUT);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_BIG)){
+		break;
+	case HTML_TAG_BIG:
 		style = html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_4);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_SMALL)){
+		break;
+	case HTML_TAG_SMALL:
 		style = html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_2);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_CITE)){
+		break;
+	case HTML_TAG_CITE:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_ITALIC | GTK_HTML_FONT_STYLE_BOLD);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_SUB)){
+		break;
+	case HTML_TAG_SUB:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_SUBSCRIPT);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_SUP)){
+		break;
+	case HTML_TAG_SUP:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_SUPERSCRIPT);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_ADDRESS)){
+		break;
+	case HTML_TAG_ADDRESS:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_ITALIC);
-	} else if (	!g_ascii_strcasecmp(name, ID_CENTER)){
+		break;
+	case HTML_TAG_CENTER:
 		style = html_style_set_display (style, HTMLDISPLAY_BLOCK);
 		style = html_style_add_text_align (style, HTML_HALIGN_CENTER);
-	} else if (	!g_ascii_strcasecmp(name, ID_U) ){
+		break;
+	case HTML_TAG_U:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_UNDERLINE);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_I) ||
-			!g_ascii_strcasecmp(name, ID_EM) ){
+		break;
+	case HTML_TAG_I:
+	case HTML_TAG_EM:
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_ITALIC);
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
+		break;
+	case HTML_TAG_SPAN:
 		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_SPAN)){
-		style = html_style_set_display (style, HTMLDISPLAY_INLINE);
-	} else if (	!g_ascii_strcasecmp(name, ID_DIV) ||
-			!g_ascii_strcasecmp(name, ID_NOBR)){
+		break;
+	case HTML_TAG_DIV:
+	case HTML_TAG_NOBR:
 		style = html_style_set_display (style, HTMLDISPLAY_BLOCK);
-	} else if (!g_ascii_strcasecmp(name, ID_HEADING1) ||
-		!g_ascii_strcasecmp(name, ID_HEADING2) ||
-		!g_ascii_strcasecmp(name, ID_HEADING3) ||
-		!g_ascii_strcasecmp(name, ID_HEADING4) ||
-		!g_ascii_strcasecmp(name, ID_HEADING5) ||
-		!g_ascii_strcasecmp(name, ID_HEADING6)
-	) {
-		if (!style)
-			style = html_style_new();
-		style = html_style_set_flow_style (style, HTML_CLUEFLOW_STYLE_H1 + (name[1] - '1'));
+		break;
+	case HTML_TAG_H1:
+	case HTML_TAG_H2:
+	case HTML_TAG_H3:
+	case HTML_TAG_H4:
+	case HTML_TAG_H5:
+	case HTML_TAG_H6:
+		style = html_style_set_flow_style (style, HTML_CLUEFLOW_STYLE_H1 + (tag - HTML_TAG_H1));
 		style = html_style_set_decoration (style, GTK_HTML_FONT_STYLE_BOLD);
 		switch (style->fstyle) {
 			case HTML_CLUEFLOW_STYLE_H6:
-				html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_1);
+				style = html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_1);
 				break;
 			case HTML_CLUEFLOW_STYLE_H5:
-				html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_2);
+				style = html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_2);
 				break;
 			case HTML_CLUEFLOW_STYLE_H4:
-				html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_3);
+				style = html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_3);
 				break;
 			case HTML_CLUEFLOW_STYLE_H3:
-				html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_4);
+				style = html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_4);
 				break;
 			case HTML_CLUEFLOW_STYLE_H2:
-				html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_5);
+				style = html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_5);
 				break;
 			case HTML_CLUEFLOW_STYLE_H1:
-				html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_6);
+				style = html_style_set_font_size (style, GTK_HTML_FONT_STYLE_SIZE_6);
 				break;
 			default:
 				break;
 		}
-	} else if (	!g_ascii_strcasecmp(name, ID_PRE)){
+		break;
+	case HTML_TAG_PRE:
 		style = html_style_set_flow_style (style, HTML_CLUEFLOW_STYLE_PRE);
-	} else if (	!g_ascii_strcasecmp(name, ID_LI)){
-
+		break;
+	case HTML_TAG_LI:
 		if (style)
-		/*	if(
-				style->fstyle != HTML_LIST_TYPE_CIRCLE &&
-				style->fstyle != HTML_LIST_TYPE_DISC &&
-				style->fstyle != HTML_LIST_TYPE_SQUARE &&
-				style->fstyle != HTML_LIST_TYPE_UNORDERED &&
-				style->fstyle != HTML_LIST_TYPE_ORDERED_ARABIC &&
-				style->fstyle != HTML_LIST_TYPE_ORDERED_LOWER_ALPHA &&
-				style->fstyle != HTML_LIST_TYPE_ORDERED_UPPER_ALPHA &&
-				style->fstyle != HTML_LIST_TYPE_ORDERED_LOWER_ROMAN &&
-				style->fstyle != HTML_LIST_TYPE_ORDERED_UPPER_ROMAN
-			)*/
-				style = html_style_set_list_type (style, HTML_LIST_TYPE_UNORDERED);
+			style = html_style_set_list_type (style, HTML_LIST_TYPE_UNORDERED);
 		style = html_style_set_flow_style (style, HTML_CLUEFLOW_STYLE_LIST_ITEM);
-		if(style)
-			style->listnumber = 1;
-	} else if (	!g_ascii_strcasecmp(name, ID_OL)){
+		style->listnumber = 1;
+		break;
+	case HTML_TAG_OL:
 		style = html_style_set_list_type(style, HTML_LIST_TYPE_ORDERED_ARABIC);
-	} else if (	!g_ascii_strcasecmp(name, ID_BLOCKQUOTE)){
+		break;
+	case HTML_TAG_BLOCKQUOTE:
 		style = html_style_set_flow_style (style, HTML_CLUEFLOW_STYLE_LIST_ITEM);
 		style = html_style_set_list_type(style, HTML_LIST_TYPE_BLOCKQUOTE);
-	} else if (	!g_ascii_strcasecmp(name, ID_UL) ||
-			!g_ascii_strcasecmp(name, ID_DIR)||
-			!g_ascii_strcasecmp(name, ID_OL) ){
-		 style = html_style_set_list_type(style, HTML_LIST_TYPE_UNORDERED);
-	} else if (	!g_ascii_strcasecmp(name, ID_DD)) {
+		break;
+	case HTML_TAG_UL:
+	case HTML_TAG_DIR:
+		style = html_style_set_list_type(style, HTML_LIST_TYPE_UNORDERED);
+		break;
+	case HTML_TAG_DD:
 		style = html_style_set_flow_style (style, HTML_CLUEFLOW_STYLE_LIST_ITEM);
 		style = html_style_set_list_type(style, HTML_LIST_TYPE_GLOSSARY_DD);
-	} else if (	!g_ascii_strcasecmp(name, ID_DIR)){
-		style = html_style_set_list_type(style, HTML_LIST_TYPE_DIR);
-	} else if (	!g_ascii_strcasecmp(name, ID_DL)){
+		break;
+	case HTML_TAG_DL:
 		style = html_style_set_list_type(style, HTML_LIST_TYPE_GLOSSARY_DL);
-	} else if (	!g_ascii_strcasecmp(name, ID_OBJECT) ||
-			!g_ascii_strcasecmp(name, ID_SELECT)){
+		break;
+	case HTML_TAG_OBJECT:
+	case HTML_TAG_SELECT:
 		style = html_style_set_display (style, HTMLDISPLAY_NONE);
+		break;
+	default:
+		break;
 	}
 
 	return style;
@@ -640,34 +747,30 @@ html_element_from_xml (HTMLEngine *e, const xmlNode* xmlelement, HTMLStyle *styl
 	g_return_val_if_fail (name, NULL);
 
 	element = html_element_new (e, name);
-	element->attributes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	/* do only copy, not change parent style*/
 	element->style = html_style_copy(style);
-	element->style = gen_style_for_element(name, element->style);
+	element->style = gen_style_for_element (element->tag, element->style);
 	for(currprop = xmlelement->properties; currprop; currprop = currprop->next) {
 		if (currprop->name ) {
-			gchar *lower = g_ascii_strdown (XMLCHAR2GCHAR(currprop->name), -1);
-			gchar *value = NULL;
-			if (currprop->children)
-				if (currprop->children->content)
-					value = g_strdup (XMLCHAR2GCHAR(currprop->children->content));
-			if (!value)
-				value = g_strdup("");
-			if (!g_hash_table_lookup (element->attributes, lower)) {
-				DE (g_print ("attrs (%s, %s)", lower, value));
-				element->style = html_style_add_attribute (element->style, to_standart_attr(name, lower), value);
-				g_hash_table_insert (element->attributes, lower, value);
-			} else {
-				g_free (lower);
-				g_free (value);
+			GQuark atom = html_atom_from_name (XMLCHAR2GCHAR(currprop->name));
+			const gchar *value = "";
+
+			if (currprop->children && currprop->children->content)
+				value = XMLCHAR2GCHAR(currprop->children->content);
+			if (!html_element_find_attr (element, atom)) {
+				DE (g_print ("attrs (%s, %s)", g_quark_to_string (atom), value));
+				element->style = html_style_add_attribute (element->style, to_standart_attr (element->tag, atom), value);
+				html_element_add_attr (element, atom, value);
 			}
 		}
 	}
 
+	html_css_foreach_property (xmlelement, html_element_add_css_property, element);
 	html_element_parse_styleattrs (element);
 	/* FIXME May be test this before use? */
 	if (!element->style)
 		element->style = html_style_new ();
+	element->style = html_style_intern (element->style);
 	return element;
 }
 
@@ -729,8 +832,8 @@ static void
 html_element_free (HTMLElement *element)
 {
 	g_return_if_fail (element);
-	if (element->attributes)
-		g_hash_table_destroy (element->attributes);
+	if (element->attrs != element->inline_attrs)
+		g_free (element->attrs);
 
 	html_style_free (element->style);
 	g_free (element);
@@ -2324,7 +2427,10 @@ element_parse_img (ELEMENT_PARSE_PARAMS)
 	element = html_element_from_xml (e, xmlelement, NULL);
 
 	if (element->style) {
+		element->style = html_style_writable (element->style);
+		g_free (element->style->href);
 		element->style->href = e->url?g_strdup(e->url):NULL;
+		g_free (element->style->target);
 		element->style->target = e->target?g_strdup(e->target):NULL;
 	}
 
@@ -2357,6 +2463,68 @@ html_engine_get_engine_type( HTMLEngine *e)
 	return e->enableconvert;
 }
 
+/* build completed subtrees while the stream is still open,
+   takes effect for the next html_engine_begin */
+void
+html_engine_set_progressive (HTMLEngine *e, gboolean progressive)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	e->progressive = progressive;
+	if (!progressive) {
+		e->streaming = FALSE;
+		e->threaded = FALSE;
+	}
+}
+
+gboolean
+html_engine_get_progressive (HTMLEngine *e)
+{
+	g_return_val_if_fail (HTML_IS_ENGINE (e), FALSE);
+
+	return e->progressive;
+}
+
+/* progressive build driven by the parser's end element events, which
+   frees the parsed nodes once they are built */
+void
+html_engine_set_streaming (HTMLEngine *e, gboolean streaming)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	e->streaming = streaming;
+	if (streaming)
+		e->progressive = TRUE;
+}
+
+gboolean
+html_engine_get_streaming (HTMLEngine *e)
+{
+	g_return_val_if_fail (HTML_IS_ENGINE (e), FALSE);
+
+	return e->streaming;
+}
+
+/* parse and apply the style sheets in a worker thread, the objects
+   are still built progressively on the main loop */
+void
+html_engine_set_threaded (HTMLEngine *e, gboolean threaded)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	e->threaded = threaded && g_thread_supported ();
+	if (e->threaded)
+		e->progressive = TRUE;
+}
+
+gboolean
+html_engine_get_threaded (HTMLEngine *e)
+{
+	g_return_val_if_fail (HTML_IS_ENGINE (e), FALSE);
+
+	return e->threaded;
+}
+
 const gchar *
 html_engine_get_href (HTMLEngine *e)
 {
@@ -2469,14 +2637,17 @@ element_parse_li (ELEMENT_PARSE_PARAMS)
 
 		top = html_stack_top (e->listStack);
 
+		element->style = html_style_writable (element->style);
 		element->style->listnumber = top->itemNumber;
 
 		if (html_stack_count (e->listStack) == 1 && element->style->listtype == HTML_LIST_TYPE_BLOCKQUOTE)
 			top->type = element->style->listtype = HTML_LIST_TYPE_UNORDERED;
 	}
 	value = XMLCHAR2GCHAR(xmlGetProp(xmlelement, GCHAR2XMLCHAR("value")));
-	if (value)
+	if (value) {
+		element->style = html_style_writable (element->style);
 		element->style->listnumber = atoi (value);
+	}
 
 	if (!html_stack_is_empty (e->listStack)) {
 		HTMLList *list;
@@ -2866,7 +3037,7 @@ element_parse_cell (ELEMENT_PARSE_PARAMS)
 	}
 
 	element = html_element_from_xml (e, xmlelement, NULL);
-	html_style_set_padding (element->style, table->padding);
+	element->style = html_style_set_padding (element->style, table->padding);
 	cell = create_cell_from_xml(e, element);
 
 	if (cell) {
@@ -3065,6 +3236,15 @@ clear_selection (HTMLEngine *e)
 	}
 }
 
+static void
+html_engine_dispose (GObject *object)
+{
+	/* batches sent to check_words are dropped when they come back */
+	spell_check_cancel (HTML_ENGINE (object));
+
+	G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
 static void
 html_engine_finalize (GObject *object)
 {
@@ -3139,10 +3319,16 @@ html_engine_finalize (GObject *object)
 		engine->mark = NULL;
 	}
 
-	if (engine->parser) {
-		htmlFreeParserCtxt(engine->parser);
-		engine->parser = NULL;
-	}
+#ifndef USEOLDRENDER
+	html_engine_parser_thread_cancel (engine);
+#endif
+	html_engine_parser_free (engine);
+	html_css_context_free (engine->css_context);
+	engine->css_context = NULL;
+
+#ifndef USEOLDRENDER
+	html_engine_progressive_reset (engine);
+#endif
 
 	if (engine->settings) {
 		html_settings_destroy (engine->settings);
@@ -3225,6 +3411,15 @@ html_engine_finalize (GObject *object)
 		engine->tempStrings = NULL;
 	}
 
+	/* clue and painter are gone, nothing may be redrawn */
+	html_engine_search_all_destroy (engine);
+	spell_check_cancel (engine);
+
+	if (engine->tile_cache) {
+		html_tile_cache_destroy (engine->tile_cache);
+		engine->tile_cache = NULL;
+	}
+
 	if (engine->draw_queue) {
 		html_draw_queue_destroy (engine->draw_queue);
 		engine->draw_queue = NULL;
@@ -3383,6 +3578,7 @@ html_engine_class_init (HTMLEngineClass *klass)
 			      g_cclosure_marshal_VOID__VOID,
 			      G_TYPE_NONE, 0);
 
+	object_class->dispose = html_engine_dispose;
 	object_class->finalize = html_engine_finalize;
 	object_class->set_property = html_engine_set_property;
 
@@ -3447,6 +3643,7 @@ html_engine_init (HTMLEngine *engine)
 	engine->tempStrings = NULL;
 
 	engine->draw_queue = html_draw_queue_new (engine);
+	engine->tile_cache = NULL;
 
 	engine->formList = NULL;
 
@@ -3476,6 +3673,7 @@ html_engine_init (HTMLEngine *engine)
 	engine->selection_updater = html_engine_edit_selection_updater_new (engine);
 
 	engine->search_info = NULL;
+	engine->search_all = NULL;
 	engine->need_spell_check = FALSE;
 
 	html_engine_print_set_min_split_index (engine, .75);
@@ -3497,8 +3695,20 @@ html_engine_init (HTMLEngine *engine)
 
 	engine->content_type = g_strdup (default_content_type);
 	engine->title = NULL;
-	engine->css = NULL;
+	engine->css_context = NULL;
 	engine->rootNode = NULL;
+
+	engine->progressive = FALSE;
+	engine->progressive_parent = NULL;
+	engine->progressive_last = NULL;
+	engine->progressive_clue = NULL;
+	engine->progressive_style = NULL;
+	engine->progressive_count = 1;
+	engine->progressive_timer = NULL;
+	engine->streaming = FALSE;
+	engine->threaded = FALSE;
+	engine->parser_thread = NULL;
+	engine->layout_tail = FALSE;
 }
 
 HTMLEngine *
@@ -3544,6 +3754,9 @@ html_engine_unrealize (HTMLEngine *e)
 		e->thaw_idle_id = 0;
 	}
 
+	if (e->tile_cache)
+		html_tile_cache_clear (e->tile_cache);
+
 	if (HTML_IS_GDK_PAINTER (e->painter))
 		html_gdk_painter_unrealize (
 			HTML_GDK_PAINTER (e->painter));
@@ -3704,10 +3917,15 @@ html_engine_begin (HTMLEngine *e, const gchar *content_type)
 
 	html_engine_set_content_type (e, content_type);
 
-	if (e->parser) {
-		htmlFreeParserCtxt(e->parser);
-		e->parser = NULL;
-	}
+#ifndef USEOLDRENDER
+	html_engine_parser_thread_cancel (e);
+#endif
+	html_engine_parser_free (e);
+	html_css_context_free (e->css_context);
+	e->css_context = NULL;
+#ifndef USEOLDRENDER
+	html_engine_progressive_reset (e);
+#endif
 
 	html_engine_stop_parser (e);
 	e->writing = TRUE;
@@ -3763,6 +3981,14 @@ html_engine_stop (HTMLEngine *e)
 	g_return_if_fail (HTML_IS_ENGINE (e));
 
 	e->stopped = TRUE;
+#ifndef USEOLDRENDER
+	if (e->parser_thread) {
+		html_engine_parser_thread_cancel (e);
+		/* the stream already ended and was waiting for the thread */
+		if (!e->writing)
+			html_engine_stream_finish (e);
+	}
+#endif
 	html_object_forall (e->clue, e, html_engine_stop_forall, NULL);
 }
 
@@ -3775,17 +4001,68 @@ html_engine_stream_types (GtkHTMLStream *handle,
 	return engine_content_types;
 }
 
+#ifndef USEOLDRENDER
+/* SAX end element handler used in streaming mode, builds the top level
+   blocks as soon as the parser closes them */
+static void
+html_engine_sax_end_element (void *ctx, const xmlChar *name)
+{
+	xmlParserCtxtPtr parser = (xmlParserCtxtPtr) ctx;
+	HTMLEngine *e = HTML_ENGINE (parser->_private);
+	xmlNode *node = parser->node;
+
+	xmlSAX2EndElement (ctx, name);
+
+	/* nothing deeper than a child of body can complete a block */
+	if (!node || !node->parent || !node->parent->parent
+	    || (node->parent->parent->type != XML_HTML_DOCUMENT_NODE
+		&& (!node->parent->parent->parent
+		    || node->parent->parent->parent->type != XML_HTML_DOCUMENT_NODE)))
+		return;
+
+	if (e->parser == parser && html_engine_progressive_build (e, FALSE))
+		html_engine_progressive_update (e);
+}
+#endif
+
 static void
 html_engine_parser_create(HTMLEngine *e)
 {
 	g_return_if_fail (HTML_IS_ENGINE (e));
 	if (!e->parser) {
 		xmlInitParser();
+#ifndef USEOLDRENDER
+		if (e->streaming && !e->threaded) {
+			htmlSAXHandler sax;
+
+			memset (&sax, 0, sizeof (htmlSAXHandler));
+			xmlSAX2InitHtmlDefaultSAXHandler (&sax);
+			sax.endElement = html_engine_sax_end_element;
+			e->parser = htmlCreatePushParserCtxt (&sax, NULL, NULL, 0, NULL, 0);
+			if (e->parser)
+				e->parser->_private = e;
+		} else
+#endif
 		e->parser = htmlCreatePushParserCtxt (NULL, NULL, NULL, 0/*e->size*/, NULL, 0);
 	}
 
 }
 
+/* htmlFreeParserCtxt leaves the document alone */
+static void
+html_engine_parser_free (HTMLEngine *e)
+{
+	if (e->parser) {
+		if (e->parser->myDoc) {
+			xmlFreeDoc (e->parser->myDoc);
+			e->parser->myDoc = NULL;
+		}
+		htmlFreeParserCtxt (e->parser);
+		e->parser = NULL;
+	}
+	e->rootNode = NULL;
+}
+
 static void
 html_engine_stream_mime (GtkHTMLStream *handle,
 			  const gchar *mime_type,
@@ -3802,6 +4079,10 @@ html_engine_stream_mime (GtkHTMLStream *handle,
 	html_engine_set_content_type (e, mime_type);
 	/* change real content type only in set to stream */
 
+	/* the parser belongs to its thread now */
+	if (e->parser_thread)
+		return;
+
 	html_engine_parser_create(e);
 
 	if (e->parser->input) {
@@ -3856,13 +4137,25 @@ html_engine_stream_write (GtkHTMLStream *handle,
 	HTMLEngine *e;
 	e = HTML_ENGINE (data);
 
-	if (buffer == NULL)
+	if (buffer == NULL || e->stopped)
 		return;
 
+#ifndef USEOLDRENDER
+	if (e->threaded && (e->parser_thread || html_engine_parser_thread_start (e))) {
+		parser_thread_send (e->parser_thread, buffer, size == -1 ? strlen (buffer) : size, FALSE);
+		return;
+	}
+#endif
+
 	html_engine_parser_create(e);
 
 	if (e->parser)
 		htmlParseChunk (e->parser, buffer, size == -1 ? strlen (buffer) : size, 0);
+
+#ifndef USEOLDRENDER
+	if (e->progressive && html_engine_progressive_build (e, FALSE))
+		html_engine_progressive_update (e);
+#endif
 }
 
 static void
@@ -4049,11 +4342,11 @@ html_engine_get_object_base (HTMLEngine *e, HTMLObject *o)
 typedef HTMLObject* (*HTMLTagsFunc)(TAG_FUNC_PARAM);
 
 typedef struct _HTMLDispatchFuncEntry {
-	const gchar *name;
+	HTMLTagId tag;
 	HTMLTagsFunc func;
 } HTMLDispatchFuncEntry;
 
-HTMLTagsFunc  get_callback_func_node(const gchar* tag);
+HTMLTagsFunc  get_callback_func_node(HTMLTagId tag);
 #endif
 
 const gchar * get_normal_name_typexml(xmlElementType type);
@@ -4071,16 +4364,14 @@ elementtree_parse_style_in_node(xmlNode* xmlelement, gint pos, HTMLEngine *e)
 			if( xmlelement->children->type == 4 &&
 				xmlelement->children->content )
 				{
-					gchar* old;
-					if(!e->css)
-						e->css = g_strdup("");
-					old = e->css;
-					/* approve after*/
-					if(e->rootNode)
-						process_node(e->rootNode, XMLCHAR2GCHAR(xmlelement->children->content));
-					
-					e->css = g_strconcat(e->css, XMLCHAR2GCHAR(xmlelement->children->content), NULL);
-					g_free(old);
+					gint sheet;
+
+					if (!e->css_context)
+						e->css_context = html_css_context_new ();
+					sheet = html_css_context_add_sheet (e->css_context, XMLCHAR2GCHAR(xmlelement->children->content));
+					/* progressive parsing matches each subtree before it's built */
+					if (sheet >= 0 && e->rootNode && !e->progressive)
+						html_css_context_match (e->css_context, e->rootNode, sheet, TRUE);
 					//
 					// FIXME PLEASE!!!!!
 					//g_print("style(%s)->%s\n", type, XMLCHAR2GCHAR(xmlelement->children->content));
@@ -4140,9 +4431,11 @@ elementtree_parse_map_in_node(xmlNode* xmlelement, gint pos, HTMLEngine *e, HTML
     xmlNode *current = NULL; /* current node */
     for (current = xmlelement; current; current = current->next)
     {
-	if(!g_ascii_strcasecmp(ID_AREA,XMLCHAR2GCHAR(current->name))) {
+	HTMLTagId tag = html_tag_of_node (current);
+
+	if (tag == HTML_TAG_AREA) {
 		elementtree_parse_area_in_node(current, pos+1, e, map);
-	} else if(!g_ascii_strcasecmp(ID_A,XMLCHAR2GCHAR(current->name))) {
+	} else if (tag == HTML_TAG_A) {
 		elementtree_parse_area_in_node(current, pos+1, e, map);
 	} else
 		g_printerr("unknow tag in area:%s\n", XMLCHAR2GCHAR(current->name));
@@ -4179,7 +4472,7 @@ get_text_from_children(xmlNode* xmlelement, HTMLEngine *e, gboolean need_trim)
 	if (xmlelement)
 		if (xmlelement->children)
 			if (xmlelement->children->type == XML_TEXT_NODE &&
-			    g_ascii_strcasecmp(XMLCHAR2GCHAR(xmlelement->children->name), ID_TEXT) == 0)
+			    html_tag_of_node (xmlelement->children) == HTML_TAG_TEXT)
 					return getcorrect_text(xmlelement->children,e, need_trim);
 	return NULL;
 }
@@ -4307,12 +4600,18 @@ elementtree_parse_head_in_node(xmlNode* xmlelement, gint pos, HTMLEngine *e)
 	xmlNode *current = NULL; /* current node */
     for (current = xmlelement; current; current = current->next)
     {
-		if(!g_ascii_strcasecmp(ID_STYLE,XMLCHAR2GCHAR(current->name))) {
+		switch (html_tag_of_node (current)) {
+		case HTML_TAG_STYLE:
 			elementtree_parse_style_in_node(current, pos+1, e);
-		} else if(!g_ascii_strcasecmp(ID_TITLE,XMLCHAR2GCHAR(current->name))) {
+			break;
+		case HTML_TAG_TITLE:
 			elementtree_parse_title_in_node(current, pos+1, e);
-		} else if(!g_ascii_strcasecmp(ID_META,XMLCHAR2GCHAR(current->name))) {
+			break;
+		case HTML_TAG_META:
 			elementtree_parse_meta_in_node(current, pos+1, e);
+			break;
+		default:
+			break;
 		}
     }
 }
@@ -4597,7 +4896,7 @@ create_cell_from_xml(HTMLEngine *e, HTMLElement *element)
 	gchar *value;
 	HTMLLength *len;
 
-	heading = !g_ascii_strcasecmp (g_quark_to_string (element->id), "th");
+	heading = element->tag == HTML_TAG_TH;
 
 	element->style = html_style_unset_decoration (element->style, 0xffff);
 	element->style = html_style_set_font_size (element->style, GTK_HTML_FONT_STYLE_SIZE_3);
@@ -4922,7 +5221,7 @@ create_text_from_xml(HTMLEngine *e, HTMLElement *testElement,const gchar* text)
 {
 	HTMLText *html_object;
 	if (!testElement->style->color)
-		testElement->style->color = html_colorset_get_color (e->settings->color_set, HTMLTextColor);
+		testElement->style = html_style_add_color (testElement->style, html_colorset_get_color (e->settings->color_set, HTMLTextColor));
 	html_object = HTML_TEXT (text_new (e, text, testElement->style->settings, testElement->style->color));
 	html_engine_set_object_data (e, HTML_OBJECT (html_object));
 	set_style_to_text (html_object, testElement->style, e, 0, /*strlen(text)*/html_object->text_bytes);
@@ -4995,8 +5294,8 @@ create_iframe_from_xml(HTMLEngine *e, HTMLElement *element, gint max_width)
 		border = atoi (value);
 
 	if (html_element_get_attr (element, "align", &value)) {
-		element->style->text_align = parse_halign(value, HTML_HALIGN_NONE);
-		element->style->text_valign = parse_valign(value, HTML_VALIGN_NONE);
+		element->style = html_style_add_text_align (element->style, parse_halign(value, HTML_HALIGN_NONE));
+		element->style = html_style_add_text_valign (element->style, parse_valign(value, HTML_VALIGN_NONE));
 	}
 
         element->style = html_style_set_display (element->style, HTMLDISPLAY_NONE);
@@ -5043,13 +5342,13 @@ create_image_from_xml(HTMLEngine *e, HTMLElement *element, gint max_width)
 	gchar *alt     = NULL;
 
 	if (element->style->url != NULL || element->style->target != NULL)
-		element->style->border_width = 2;
+		element->style = html_style_set_border_width (element->style, 2);
 	if (html_element_get_attr (element, "hspace", &value))
 		hspace = atoi (value);
 
 	if (html_element_get_attr (element, "align", &value)) {
-		element->style->text_align = parse_halign(value, HTML_HALIGN_NONE);
-		element->style->text_valign = parse_valign(value, HTML_VALIGN_NONE);
+		element->style = html_style_add_text_align (element->style, parse_halign(value, HTML_HALIGN_NONE));
+		element->style = html_style_add_text_valign (element->style, parse_valign(value, HTML_VALIGN_NONE));
 	}
 
 	if (html_element_get_attr (element, "alt", &value))
@@ -5068,9 +5367,9 @@ create_image_from_xml(HTMLEngine *e, HTMLElement *element, gint max_width)
 		return NULL;
 
 	if (element->style->text_align != HTML_HALIGN_NONE)
-		element->style->text_valign = HTML_VALIGN_BOTTOM;
+		element->style = html_style_add_text_valign (element->style, HTML_VALIGN_BOTTOM);
 	else if (element->style->text_valign == HTML_VALIGN_NONE)
-		element->style->text_valign = HTML_VALIGN_BOTTOM;
+		element->style = html_style_add_text_valign (element->style, HTML_VALIGN_BOTTOM);
 
 	if (element->style->width) {
 		width = element->style->width->val;
@@ -5302,6 +5601,7 @@ tag_func_li(TAG_FUNC_PARAM)
 			gchar *value;
 			if (html_element_get_attr (testElement, "value", &value))
 				*count = atoi (value);
+			testElement->style = html_style_writable (testElement->style);
 			testElement->style->listnumber = *count;
 			(*count)++;
 	}
@@ -5530,112 +5830,94 @@ tag_func_td(TAG_FUNC_PARAM)
 }
 
 static HTMLDispatchFuncEntry func_callback_table[] = {
-	{ ID_ADDRESS,          tag_func_simple_tag          },
-	{ ID_A,                tag_func_simple_without_flow },
-	{ ID_BASE,             tag_func_base                },
-	{ ID_BIG,              tag_func_simple_without_flow },
-	{ ID_BLOCKQUOTE,       tag_func_simple_tag          },
-	{ ID_CAPTION,          tag_func_hidden              },
-	{ ID_TBODY,            tag_func_simple_tag          },
-	{ ID_BODY,             tag_func_body                },
-	{ ID_BR,               tag_func_br                  },
-	{ ID_B,                tag_func_simple_without_flow },
-	{ ID_CENTER,           tag_func_simple_tag          },
-	{ ID_CITE,             tag_func_simple_without_flow },
-	{ ID_CODE,             tag_func_simple_without_flow },
-	{ ID_DATA,             tag_func_data                },
-	{ ID_DD,               tag_func_simple_tag          },
-	{ ID_DIR,              tag_func_simple_without_flow },
-	{ ID_DIV,              tag_func_simple_tag          },
-	{ ID_DL,               tag_func_simple_without_flow },
-	{ ID_DT,               tag_func_simple_tag          },
-	{ ID_EM,               tag_func_simple_without_flow },
-	{ ID_FONT,             tag_func_font                },
-	{ ID_FORM,             tag_func_form                },
-	{ ID_FRAMESET,         tag_func_frameset            },
-	{ ID_FRAME,            tag_func_frame               },
-	{ ID_HEADING1,         tag_func_simple_tag          },
-	{ ID_HEADING2,         tag_func_simple_tag          },
-	{ ID_HEADING3,         tag_func_simple_tag          },
-	{ ID_HEADING4,         tag_func_simple_tag          },
-	{ ID_HEADING5,         tag_func_simple_tag          },
-	{ ID_HEADING6,         tag_func_simple_tag          },
-	{ ID_HEAD,             tag_func_head                },
-	{ ID_HR,               tag_func_hr                  },
-	{ ID_HTML,             tag_func_simple_without_flow },
-	{ ID_IFRAME,           tag_func_frame               },
-	{ ID_IMG,              tag_func_img                 },
-	{ ID_INPUT,            tag_func_input               },
-	{ ID_I,                tag_func_simple_without_flow },
-	{ ID_KBD,              tag_func_simple_without_flow },
-	{ ID_LABEL,            tag_func_simple_without_flow },
-	{ ID_LI,               tag_func_li                  },
-	{ ID_MAP,              tag_func_map                 },
-	{ ID_MENU,             tag_func_simple_without_flow },
-	{ ID_NOBR,             tag_func_simple_without_flow },
-	{ ID_NOFRAME,          tag_func_simple_without_flow },
-	{ ID_NOSCRIPT,         tag_func_hidden              },
-	{ ID_OBJECT,           tag_func_object              },
-	{ ID_OL,               tag_func_simple_without_flow },
-	{ ID_PRE,              tag_func_simple_without_flow },
-	{ ID_P,                tag_func_simple_tag          },
-	{ ID_SCRIPT,           tag_func_hidden              },
-	{ ID_SELECT,           tag_func_select              },
-	{ ID_STYLE,            tag_func_style               },
-	{ ID_SMALL,            tag_func_simple_without_flow },
-	{ ID_SPAN,             tag_func_simple_without_flow },
-	{ ID_S,                tag_func_simple_without_flow },
-	{ ID_STRIKE,           tag_func_simple_without_flow },
-	{ ID_STRONG,           tag_func_simple_without_flow },
-	{ ID_SUB,              tag_func_simple_without_flow },
-	{ ID_TEXTAREA,         tag_func_textarea            },
-	{ ID_SUP,              tag_func_simple_without_flow },
-	{ ID_TABLE,            tag_func_table               },
-	{ ID_TD,               tag_func_td                  },
-	{ ID_TEXT,             tag_func_text                },
-	{ ID_TH,               tag_func_td                  },
-	{ ID_TR,               tag_func_tr                  },
-	{ ID_TT,               tag_func_simple_without_flow },
-	{ ID_UL,               tag_func_simple_without_flow },
-	{ ID_U,                tag_func_simple_without_flow },
-	{ ID_VAR,              tag_func_simple_without_flow },
-	{ ID_LINK,             tag_func_hidden              },
-	{ NULL,                NULL                         }
+	{ HTML_TAG_ADDRESS,    tag_func_simple_tag          },
+	{ HTML_TAG_A,          tag_func_simple_without_flow },
+	{ HTML_TAG_BASE,       tag_func_base                },
+	{ HTML_TAG_BIG,        tag_func_simple_without_flow },
+	{ HTML_TAG_BLOCKQUOTE, tag_func_simple_tag          },
+	{ HTML_TAG_CAPTION,    tag_func_hidden              },
+	{ HTML_TAG_TBODY,      tag_func_simple_tag          },
+	{ HTML_TAG_BODY,       tag_func_body                },
+	{ HTML_TAG_BR,         tag_func_br                  },
+	{ HTML_TAG_B,          tag_func_simple_without_flow },
+	{ HTML_TAG_CENTER,     tag_func_simple_tag          },
+	{ HTML_TAG_CITE,       tag_func_simple_without_flow },
+	{ HTML_TAG_CODE,       tag_func_simple_without_flow },
+	{ HTML_TAG_DATA,       tag_func_data                },
+	{ HTML_TAG_DD,         tag_func_simple_tag          },
+	{ HTML_TAG_DIR,        tag_func_simple_without_flow },
+	{ HTML_TAG_DIV,        tag_func_simple_tag          },
+	{ HTML_TAG_DL,         tag_func_simple_without_flow },
+	{ HTML_TAG_DT,         tag_func_simple_tag          },
+	{ HTML_TAG_EM,         tag_func_simple_without_flow },
+	{ HTML_TAG_FONT,       tag_func_font                },
+	{ HTML_TAG_FORM,       tag_func_form                },
+	{ HTML_TAG_FRAMESET,   tag_func_frameset            },
+	{ HTML_TAG_FRAME,      tag_func_frame               },
+	{ HTML_TAG_H1,         tag_func_simple_tag          },
+	{ HTML_TAG_H2,         tag_func_simple_tag          },
+	{ HTML_TAG_H3,         tag_func_simple_tag          },
+	{ HTML_TAG_H4,         tag_func_simple_tag          },
+	{ HTML_TAG_H5,         tag_func_simple_tag          },
+	{ HTML_TAG_H6,         tag_func_simple_tag          },
+	{ HTML_TAG_HEAD,       tag_func_head                },
+	{ HTML_TAG_HR,         tag_func_hr                  },
+	{ HTML_TAG_HTML,       tag_func_simple_without_flow },
+	{ HTML_TAG_IFRAME,     tag_func_frame               },
+	{ HTML_TAG_IMG,        tag_func_img                 },
+	{ HTML_TAG_INPUT,      tag_func_input               },
+	{ HTML_TAG_I,          tag_func_simple_without_flow },
+	{ HTML_TAG_KBD,        tag_func_simple_without_flow },
+	{ HTML_TAG_LABEL,      tag_func_simple_without_flow },
+	{ HTML_TAG_LI,         tag_func_li                  },
+	{ HTML_TAG_MAP,        tag_func_map                 },
+	{ HTML_TAG_MENU,       tag_func_simple_without_flow },
+	{ HTML_TAG_NOBR,       tag_func_simple_without_flow },
+	{ HTML_TAG_NOFRAME,    tag_func_simple_without_flow },
+	{ HTML_TAG_NOSCRIPT,   tag_func_hidden              },
+	{ HTML_TAG_OBJECT,     tag_func_object              },
+	{ HTML_TAG_OL,         tag_func_simple_without_flow },
+	{ HTML_TAG_PRE,        tag_func_simple_without_flow },
+	{ HTML_TAG_P,          tag_func_simple_tag          },
+	{ HTML_TAG_SCRIPT,     tag_func_hidden              },
+	{ HTML_TAG_SELECT,     tag_func_select              },
+	{ HTML_TAG_STYLE,      tag_func_style               },
+	{ HTML_TAG_SMALL,      tag_func_simple_without_flow },
+	{ HTML_TAG_SPAN,       tag_func_simple_without_flow },
+	{ HTML_TAG_S,          tag_func_simple_without_flow },
+	{ HTML_TAG_STRIKE,     tag_func_simple_without_flow },
+	{ HTML_TAG_STRONG,     tag_func_simple_without_flow },
+	{ HTML_TAG_SUB,        tag_func_simple_without_flow },
+	{ HTML_TAG_TEXTAREA,   tag_func_textarea            },
+	{ HTML_TAG_SUP,        tag_func_simple_without_flow },
+	{ HTML_TAG_TABLE,      tag_func_table               },
+	{ HTML_TAG_TD,         tag_func_td                  },
+	{ HTML_TAG_TEXT,       tag_func_text                },
+	{ HTML_TAG_TH,         tag_func_td                  },
+	{ HTML_TAG_TR,         tag_func_tr                  },
+	{ HTML_TAG_TT,         tag_func_simple_without_flow },
+	{ HTML_TAG_UL,         tag_func_simple_without_flow },
+	{ HTML_TAG_U,          tag_func_simple_without_flow },
+	{ HTML_TAG_VAR,        tag_func_simple_without_flow },
+	{ HTML_TAG_LINK,       tag_func_hidden              },
+	{ HTML_TAG_UNKNOWN,    NULL                         }
 };
 
-static GHashTable *
-dispatch_func_table_new (HTMLDispatchFuncEntry *entry)
-{
-	GHashTable *table = g_hash_table_new (g_str_hash, g_str_equal);
-	gint i = 0;
-
-	while (entry[i].name) {
-		g_hash_table_insert (
-			table, (gpointer) entry[i].name, &entry[i]);
-		i++;
-	}
-
-	return table;
-}
-
 HTMLTagsFunc
-get_callback_func_node(const gchar* tag) {
-
-	static GHashTable *func_callback = NULL;
-	HTMLDispatchFuncEntry *entry;
-
-	if (func_callback == NULL)
-		func_callback = dispatch_func_table_new (func_callback_table);
+get_callback_func_node (HTMLTagId tag)
+{
+	static HTMLTagsFunc funcs [HTML_TAG_LAST];
+	static gboolean funcs_set = FALSE;
 
-	if(tag == NULL)
-		return NULL;
+	if (!funcs_set) {
+		HTMLDispatchFuncEntry *entry;
 
-	entry = g_hash_table_lookup (func_callback, tag);
+		for (entry = func_callback_table; entry->func; entry++)
+			funcs [entry->tag] = entry->func;
+		funcs_set = TRUE;
+	}
 
-	if (entry)
-		return *entry->func;
-	else
-		return NULL;
+	return funcs [tag];
 }
 
 HTMLObject *
@@ -5654,14 +5936,16 @@ element_parse_nodedump_htmlobject_one(xmlNode* current, gint pos, HTMLEngine *e,
 		current->type == XML_ELEMENT_NODE ||
 		current->type == XML_TEXT_NODE
 	) {
-		callback_func = get_callback_func_node(XMLCHAR2GCHAR(current->name));
+		HTMLElement *testElement;
+
+		testElement = html_element_from_xml(e, current, parent_style);
+		g_return_val_if_fail (testElement, for_return);
+		callback_func = get_callback_func_node (testElement->tag);
 		if (callback_func) {
-			HTMLElement *testElement;
-			testElement = html_element_from_xml(e, current, parent_style);
-			g_return_val_if_fail (testElement, for_return);
 			for_return = callback_func(current, pos, e, htmlelement, parentclue, testElement, count);
 			html_element_free(testElement);
 		} else {
+			html_element_free(testElement);
 			g_printerr("unknow tag %s\n", XMLCHAR2GCHAR(current->name));
 			elementtree_parse_dumpnode_in_node(current, pos);
 			for_return = element_parse_nodedump_htmlobject(current->children,pos + 1, e, htmlelement, parentclue, parent_style);
@@ -5699,7 +5983,7 @@ elementtree_parse_object_in_node(xmlNode* xmlelement, gint pos, HTMLEngine *e, G
     xmlNode *current = NULL; /* current node */
     for (current = xmlelement; current; current = current->next)
     {
-	if(!g_ascii_strcasecmp("param",XMLCHAR2GCHAR(current->name))) {
+	if (html_tag_of_node (current) == HTML_TAG_PARAM) {
 		elementtree_parse_param_in_node(current, pos+1, e, eb);
 	} else
 		g_printerr("unknow tag in param:%s\n", XMLCHAR2GCHAR(current->name));
@@ -5742,7 +6026,7 @@ elementtree_parse_select_in_node(xmlNode* xmlelement, gint pos, HTMLEngine *e, H
     xmlNode *current = NULL; /* current node */
     for (current = xmlelement; current; current = current->next)
     {
-	if(!g_ascii_strcasecmp(ID_OPTION,XMLCHAR2GCHAR(current->name))) {
+	if (html_tag_of_node (current) == HTML_TAG_OPTION) {
 		elementtree_parse_option_in_node(current, pos+1, e, formSelect);
 	} else
 		g_printerr("unknow tag in option:%s\n", XMLCHAR2GCHAR(current->name));
@@ -5873,136 +6157,536 @@ stupid_render(ELEMENT_PARSE_PARAMS) {
 }
 #endif
 
-/*css*/
-void process_element(xmlNode* element, CRCascade *cascade, CRSelEng *selector);
-void add_single_property(xmlNode* element, CRDeclaration* decl);
-void add_properties(xmlNode* element, CRPropList *first);
+#ifndef USEOLDRENDER
+/* seconds between relayouts while a progressive stream is open */
+#define PROGRESSIVE_UPDATE_INTERVAL 0.25
 
-void add_single_property(xmlNode* element, CRDeclaration* decl)
+/* TRUE if node is on the push parser's open element path */
+static gboolean
+progressive_node_is_open (htmlParserCtxtPtr parser, xmlNode *node)
 {
-    	CRString* name = decl->property; /* name of the property */
-    	CRTerm* value = decl->value;     /* value of the property */
-
-    	gchar *vstr = (gchar*)cr_term_to_string(value); /* convert to gchar* */
-    	gchar *nstr = cr_string_dup2(name);     /* convert to gchar* */
-    	gchar *prevstyle = g_strdup("");
-    	gchar *style = NULL;
-
-    	if (!vstr || !nstr)
-    	{
-        	g_printerr ("%s\n", "Warning: out of memory when adding attribute");
+	xmlNode *current;
 
-        	/* free this far allocated memory */
-        	if (vstr)
-            		g_free(vstr);
-
-	        if (nstr)
-        		g_free(nstr);
-        	return;
-    	}
-
-	if (xmlGetProp(element, GCHAR2XMLCHAR(ID_STYLE)) != NULL)
-	        prevstyle = XMLCHAR2GCHAR(xmlGetProp(element, GCHAR2XMLCHAR(ID_STYLE)));
-
-	style = g_strdup_printf ("%s: %s; %s", nstr, vstr, prevstyle);
+	for (current = parser->node; current; current = current->parent)
+		if (current == node)
+			return TRUE;
 
-	g_free(prevstyle);
+	return FALSE;
+}
 
-	/* element.setAttributeNS(...) */
-    	if (!(xmlSetProp(element, GCHAR2XMLCHAR(ID_STYLE), GCHAR2XMLCHAR(style))))
-        	g_printerr("%s\n", "Warning: Could not add attribute to element");
+static gboolean
+progressive_node_is_complete (htmlParserCtxtPtr parser, xmlNode *node, gboolean finished)
+{
+	if (finished)
+		return TRUE;
 
-    	g_free(style);
+	if (progressive_node_is_open (parser, node))
+		return FALSE;
 
-	/* free the stringified representation of the property value */
-	g_free(vstr);
+	/* the last text child of an open element may still get text appended */
+	if (node->type == XML_TEXT_NODE && !node->next && node->parent
+	    && progressive_node_is_open (parser, node->parent))
+		return FALSE;
 
-	/* free the stringified representation of the property name */
-	g_free(nstr);
+	return TRUE;
 }
 
-void add_properties(xmlNode* element, CRPropList *first)
+static gboolean
+progressive_node_is_body (xmlNode *node)
 {
-    CRDeclaration *decl = NULL; /* a style declaration, a name/value pair */
-    CRPropList *current = NULL; /* a list of properties */
-
-    /* iterate over all properties in the list */
-    for (current = first; current; current = cr_prop_list_get_next(current))
-    {
-        decl = NULL;
+	return node->type == XML_ELEMENT_NODE
+		&& html_tag_of_node (node) == HTML_TAG_BODY;
+}
 
-        /* retrieve the declaration for the current property */
-        cr_prop_list_get_decl(current, &decl);
+static void
+html_engine_progressive_reset (HTMLEngine *e)
+{
+	html_style_free (e->progressive_style);
+	e->progressive_style = NULL;
+	e->progressive_parent = NULL;
+	e->progressive_last = NULL;
+	e->progressive_clue = NULL;
+	e->progressive_count = 1;
 
-        if (decl)
-        {
-            /* add the property to the element */
-            add_single_property(element, decl);
-        }
-    }
+	if (e->progressive_timer) {
+		g_timer_destroy (e->progressive_timer);
+		e->progressive_timer = NULL;
+	}
 }
 
-void process_element(xmlNode* element, CRCascade *cascade, CRSelEng *selector)
+/* the clue the next top level child of body is built into. Inline
+   content shares one flow with body's style, as it does when body is
+   built as a whole; a new flow is started after a block so that
+   layout can continue from the tail of the document clue. */
+static HTMLObject *
+progressive_get_clue (HTMLEngine *e)
 {
-    CRPropList *properties;  /* list of properties for the current element */
-    xmlNode *current = NULL; /* current node */
+	HTMLObject *clue = e->progressive_clue;
+	HTMLObject *tail;
 
-    /* foreach element $current in $doc add properties to element */
-    for (current = element; current; current = current->next)
-    {
-        if (current->type == XML_ELEMENT_NODE)
-        {
-            properties = NULL;
+	if (clue == e->parser_clue)
+		return clue;
 
-            /* get all properties for the current element */
-            cr_sel_eng_get_matched_properties_from_cascade(selector,
-                                                           cascade,
-                                                           current,
-                                                           &properties);
+	tail = clue ? HTML_CLUE (clue)->tail : NULL;
+	if (!clue || (tail && (HTML_IS_CLUEFLOW (tail) || HTML_IS_TABLE (tail)))) {
+		HTMLElement element;
 
-            /* add the properties as attributes to the element */
-            add_properties(current, properties);
-        }
+		memset (&element, 0, sizeof (HTMLElement));
+		element.style = e->progressive_style;
+		clue = create_flow_from_xml (e, &element);
+		html_clue_append (HTML_CLUE (e->parser_clue), clue);
+	}
 
-        /* recursively process the children of the element */
-        process_element(current->children, cascade, selector);
-    }
+	return clue;
 }
 
-/*process css on node*/
-void
-process_node(xmlNode* node, const gchar * css)
-{
-	enum CRStatus status  = CR_OK; /* status for libcroco operations */
-	CRStyleSheet* stylesheet; /* style sheet */
-        CRCascade*    cascade;    /* cascade abstraction */
-        CRSelEng*     selector;   /* selection engine */
-
-	/* read the style sheet into memory */
-	status = cr_om_parser_simply_parse_buf(GCHAR2XMLCHAR(css), strlen(css), CR_ASCII, &stylesheet);
-	/* check whether style sheet processing succeeded */
-	if (stylesheet != NULL) {
-		if (status == CR_OK) {
-			/* new cascade abstraction */
-			if ((cascade = cr_cascade_new(stylesheet, NULL, NULL))) {
-				/* new selector engine */
-				if ((selector = cr_sel_eng_new())) {
-					/* traverse the tree */
-    					process_element(node, cascade, selector);
-    					cr_sel_eng_destroy(selector);
-				}
-        		}
-	    		if (cascade) {
-        			/* free the cascade abstraction */
-        			cr_cascade_destroy(cascade);
-    			} else if (stylesheet) {
-        			/* free the style sheet */
-		        	cr_stylesheet_destroy(stylesheet);
-    			}
-    		}
+static void
+progressive_begin (HTMLEngine *e, xmlNode *root)
+{
+	e->eat_space = FALSE;
+	e->progressive_parent = root;
+	e->progressive_last = NULL;
+	e->progressive_clue = e->parser_clue;
+	html_style_free (e->progressive_style);
+	e->progressive_style = style_from_engine (e);
+	e->progressive_count = 1;
+}
+
+/* body itself, its children are built one by one */
+static void
+progressive_begin_body (HTMLEngine *e, xmlNode *body)
+{
+	HTMLElement *element;
+
+	element = html_element_from_xml (e, body, e->progressive_style);
+	if (element) {
+		fix_body_from_xml (e, element, e->parser_clue);
+		html_style_free (e->progressive_style);
+		e->progressive_style = html_style_copy (element->style);
+		html_element_free (element);
+	}
+
+	e->progressive_parent = body;
+	e->progressive_last = NULL;
+	e->progressive_clue = NULL;
+	e->progressive_count = 1;
+}
+
+/* body is done, continue with whatever follows it */
+static void
+progressive_end_body (HTMLEngine *e, xmlNode *root)
+{
+	e->progressive_parent = root;
+	e->progressive_clue = e->parser_clue;
+	html_style_free (e->progressive_style);
+	e->progressive_style = style_from_engine (e);
+}
+
+static void
+progressive_build_node (HTMLEngine *e, xmlNode *node, gboolean in_body)
+{
+	if (in_body)
+		e->progressive_clue = element_parse_nodedump_htmlobject_one (node, 2, e, progressive_get_clue (e), e->parser_clue,
+									     e->progressive_style, &e->progressive_count);
+	else
+		e->progressive_clue = element_parse_nodedump_htmlobject_one (node, 1, e, e->parser_clue, e->parser_clue,
+									     e->progressive_style, &e->progressive_count);
+}
+
+/*
+ * builds the children of html (and then of body) which are complete
+ * and not yet built. Returns TRUE if something has been built.
+ */
+static gboolean
+html_engine_progressive_build (HTMLEngine *e, gboolean finished)
+{
+	xmlNode *root, *current;
+	gboolean built = FALSE;
+	gboolean is_body;
+
+	if (!e->parser || !e->parser->myDoc || !e->parser_clue)
+		return FALSE;
+
+	root = xmlDocGetRootElement (e->parser->myDoc);
+	if (!root)
+		return FALSE;
+
+	e->rootNode = root;
+	if (!e->progressive_parent)
+		progressive_begin (e, root);
+
+	for (;;) {
+		current = e->progressive_last ? e->progressive_last->next : e->progressive_parent->children;
+
+		if (!current) {
+			if (e->progressive_parent == root
+			    || !progressive_node_is_complete (e->parser, e->progressive_parent, finished))
+				break;
+
+			e->progressive_last = e->progressive_parent;
+			if (e->streaming) {
+				xmlUnlinkNode (e->progressive_last);
+				xmlFreeNode (e->progressive_last);
+				e->progressive_last = NULL;
+			}
+			progressive_end_body (e, root);
+			continue;
+		}
+
+		is_body = e->progressive_parent == root && progressive_node_is_body (current);
+
+		if (!is_body && !progressive_node_is_complete (e->parser, current, finished))
+			break;
+
+		if (is_body) {
+			if (e->css_context)
+				html_css_context_match (e->css_context, current, 0, FALSE);
+			progressive_begin_body (e, current);
+			continue;
+		}
+
+		if (e->css_context)
+			html_css_context_match (e->css_context, current, 0, TRUE);
+
+		progressive_build_node (e, current, e->progressive_parent != root);
+		e->progressive_last = current;
+		built = TRUE;
+
+		/* built objects don't refer back to their nodes */
+		if (e->streaming) {
+			xmlUnlinkNode (current);
+			xmlFreeNode (current);
+			e->progressive_last = NULL;
+		}
+	}
+
+	return built;
+}
+
+/* relayout the new tail, the first one right away and then at most
+   every PROGRESSIVE_UPDATE_INTERVAL */
+static void
+html_engine_progressive_update (HTMLEngine *e)
+{
+	if (e->progressive_timer) {
+		if (g_timer_elapsed (e->progressive_timer, NULL) < PROGRESSIVE_UPDATE_INTERVAL)
+			return;
+		g_timer_start (e->progressive_timer);
+	} else
+		e->progressive_timer = g_timer_new ();
+
+	e->layout_tail = TRUE;
+	html_engine_schedule_update (e);
+}
+
+/*
+ * Threaded parsing: a worker thread owns the push parser, applies the
+ * style sheets and hands styled, detached copies of the complete top
+ * level nodes over to the main loop, which turns them into objects.
+ * Objects are only created on the main loop as they may create widgets,
+ * request images and emit signals.
+ */
+
+/* milliseconds between polls of the parser thread */
+#define PARSER_THREAD_POLL_INTERVAL 10
+/* seconds the main loop spends building per poll */
+#define PARSER_THREAD_SLICE 0.02
+
+typedef enum {
+	HTML_PARSED_NODE,
+	HTML_PARSED_BODY,
+	HTML_PARSED_BODY_END,
+	HTML_PARSED_DONE
+} HTMLParsedKind;
+
+typedef struct {
+	HTMLParsedKind kind;
+	xmlNode *node;          /* not attached to any document */
+} HTMLParsedItem;
+
+typedef struct {
+	gchar *data;
+	gsize size;
+	gboolean last;
+} HTMLParserChunk;
+
+struct _HTMLParserThread {
+	GThread *thread;
+	GAsyncQueue *chunks;    /* HTMLParserChunk, from the stream */
+	GAsyncQueue *items;     /* HTMLParsedItem, to the main loop */
+	gint cancelled;
+
+	/* owned by the thread while it runs */
+	htmlParserCtxtPtr parser;
+	xmlNode *body;
+	HTMLCssContext *css_context;    /* the copies refer to its matches */
+
+	/* main loop side */
+	guint timeout_id;
+	xmlNode *built_body;
+};
+
+static void
+parser_thread_push (HTMLParserThread *pt, HTMLParsedKind kind, xmlNode *node)
+{
+	HTMLParsedItem *item = g_new (HTMLParsedItem, 1);
+
+	item->kind = kind;
+	item->node = node;
+	g_async_queue_push (pt->items, item);
+}
+
+static void
+parsed_item_free (HTMLParsedItem *item)
+{
+	if (item->node)
+		xmlFreeNode (item->node);
+	g_free (item);
+}
+
+/* picks up the style sheets of a complete subtree before it's styled */
+static void
+parser_thread_collect_css (HTMLParserThread *pt, xmlNode *node)
+{
+	xmlNode *child;
+
+	if (node->type != XML_ELEMENT_NODE)
+		return;
+
+	if (html_tag_of_node (node) != HTML_TAG_STYLE) {
+		for (child = node->children; child; child = child->next)
+			parser_thread_collect_css (pt, child);
+		return;
+	}
+
+	if (node->children && node->children->type == XML_TEXT_NODE && node->children->content)
+		html_css_context_add_sheet (pt->css_context, XMLCHAR2GCHAR (node->children->content));
+}
+
+/* the copy doesn't share the parser's dictionary */
+static xmlNode *
+parser_thread_copy (xmlNode *node, gint extended)
+{
+	xmlNode *copy = xmlDocCopyNode (node, NULL, extended);
+
+	if (copy)
+		html_css_copy_matches (node, copy);
+
+	return copy;
+}
+
+/* same walk as html_engine_progressive_build, in the parser thread */
+static void
+parser_thread_collect (HTMLParserThread *pt, gboolean finished)
+{
+	xmlNode *root, *parent, *current;
+
+	if (!pt->parser->myDoc)
+		return;
+
+	root = xmlDocGetRootElement (pt->parser->myDoc);
+	if (!root)
+		return;
+
+	parent = pt->body ? pt->body : root;
+	while (!g_atomic_int_get (&pt->cancelled)) {
+		current = parent->children;
+
+		if (!current) {
+			if (parent == root || !progressive_node_is_complete (pt->parser, parent, finished))
+				break;
+
+			xmlUnlinkNode (parent);
+			xmlFreeNode (parent);
+			pt->body = NULL;
+			parent = root;
+			parser_thread_push (pt, HTML_PARSED_BODY_END, NULL);
+			continue;
+		}
+
+		if (parent == root && progressive_node_is_body (current)) {
+			html_css_context_match (pt->css_context, current, 0, FALSE);
+			pt->body = parent = current;
+			parser_thread_push (pt, HTML_PARSED_BODY, parser_thread_copy (current, 2));
+			continue;
+		}
+
+		if (!progressive_node_is_complete (pt->parser, current, finished))
+			break;
+
+		parser_thread_collect_css (pt, current);
+		html_css_context_match (pt->css_context, current, 0, TRUE);
+
+		xmlUnlinkNode (current);
+		parser_thread_push (pt, HTML_PARSED_NODE, parser_thread_copy (current, 1));
+		xmlFreeNode (current);
+	}
+}
+
+static gpointer
+parser_thread_main (gpointer data)
+{
+	HTMLParserThread *pt = data;
+	HTMLParserChunk *chunk;
+	gboolean last;
+
+	do {
+		chunk = g_async_queue_pop (pt->chunks);
+		last = chunk->last;
+
+		if (!g_atomic_int_get (&pt->cancelled)) {
+			htmlParseChunk (pt->parser, chunk->data, chunk->size, last);
+			parser_thread_collect (pt, last);
+		}
+
+		g_free (chunk->data);
+		g_free (chunk);
+	} while (!last);
+
+	parser_thread_push (pt, HTML_PARSED_DONE, NULL);
+
+	return NULL;
+}
+
+static void
+parser_thread_send (HTMLParserThread *pt, const gchar *data, gsize size, gboolean last)
+{
+	HTMLParserChunk *chunk = g_new (HTMLParserChunk, 1);
+
+	chunk->data = size ? g_memdup (data, size) : NULL;
+	chunk->size = size;
+	chunk->last = last;
+	g_async_queue_push (pt->chunks, chunk);
+}
+
+/* waits for the thread to stop and frees whatever it left behind */
+static void
+html_engine_parser_thread_cancel (HTMLEngine *e)
+{
+	HTMLParserThread *pt = e->parser_thread;
+	gpointer item;
+
+	if (!pt)
+		return;
+
+	e->parser_thread = NULL;
+
+	if (pt->timeout_id)
+		g_source_remove (pt->timeout_id);
+
+	g_atomic_int_set (&pt->cancelled, 1);
+	parser_thread_send (pt, NULL, 0, TRUE);
+	g_thread_join (pt->thread);
+
+	while ((item = g_async_queue_try_pop (pt->chunks))) {
+		g_free (((HTMLParserChunk *) item)->data);
+		g_free (item);
+	}
+	while ((item = g_async_queue_try_pop (pt->items)))
+		parsed_item_free (item);
+	g_async_queue_unref (pt->chunks);
+	g_async_queue_unref (pt->items);
+
+	if (pt->parser->myDoc)
+		xmlFreeDoc (pt->parser->myDoc);
+	htmlFreeParserCtxt (pt->parser);
+
+	html_css_context_free (pt->css_context);
+
+	if (pt->built_body) {
+		if (e->progressive_parent == pt->built_body)
+			e->progressive_parent = NULL;
+		xmlFreeNode (pt->built_body);
+	}
+
+	g_free (pt);
+}
+
+static gboolean
+html_engine_parser_thread_poll (HTMLEngine *e)
+{
+	HTMLParserThread *pt = e->parser_thread;
+	HTMLParsedItem *item;
+	GTimer *timer;
+	gboolean built = FALSE;
+	gboolean done = FALSE;
+
+	timer = g_timer_new ();
+	while (!done && g_timer_elapsed (timer, NULL) < PARSER_THREAD_SLICE
+	       && (item = g_async_queue_try_pop (pt->items))) {
+		switch (item->kind) {
+		case HTML_PARSED_NODE:
+			progressive_build_node (e, item->node, pt->built_body != NULL);
+			built = TRUE;
+			break;
+		case HTML_PARSED_BODY:
+			/* kept as progressive_parent until the body ends */
+			pt->built_body = item->node;
+			item->node = NULL;
+			progressive_begin_body (e, pt->built_body);
+			break;
+		case HTML_PARSED_BODY_END:
+			progressive_end_body (e, NULL);
+			xmlFreeNode (pt->built_body);
+			pt->built_body = NULL;
+			break;
+		case HTML_PARSED_DONE:
+			done = TRUE;
+			break;
+		}
+		parsed_item_free (item);
+	}
+	g_timer_destroy (timer);
+
+	if (built)
+		html_engine_progressive_update (e);
+
+	if (done) {
+		pt->timeout_id = 0;
+		html_engine_parser_thread_cancel (e);
+		html_engine_stream_finish (e);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* hands the parser over to a new thread, falls back to parsing on the
+   main loop if the thread can't be created */
+static gboolean
+html_engine_parser_thread_start (HTMLEngine *e)
+{
+	HTMLParserThread *pt;
+
+	html_engine_parser_create (e);
+	if (!e->parser)
+		return FALSE;
+
+	pt = g_new0 (HTMLParserThread, 1);
+	pt->parser = e->parser;
+	pt->chunks = g_async_queue_new ();
+	pt->items = g_async_queue_new ();
+	pt->css_context = html_css_context_new ();
+
+	pt->thread = g_thread_create (parser_thread_main, pt, TRUE, NULL);
+	if (!pt->thread) {
+		g_async_queue_unref (pt->chunks);
+		g_async_queue_unref (pt->items);
+		html_css_context_free (pt->css_context);
+		g_free (pt);
+		e->threaded = FALSE;
+		return FALSE;
 	}
+
+	e->parser = NULL;
+	e->parser_thread = pt;
+	progressive_begin (e, NULL);
+	pt->timeout_id = g_timeout_add (PARSER_THREAD_POLL_INTERVAL, (GSourceFunc) html_engine_parser_thread_poll, e);
+
+	return TRUE;
 }
-/* /css */
+#endif
 
 static gboolean
 html_engine_timer_event (HTMLEngine *e)
@@ -6079,12 +6763,30 @@ html_engine_stream_end (GtkHTMLStream *stream,
 		e->timerId = 0;
 	}
 
+#ifndef USEOLDRENDER
+	/* the rest is done once the thread has delivered everything */
+	if (e->threaded && e->parser_thread) {
+		parser_thread_send (e->parser_thread, NULL, 0, TRUE);
+		return;
+	}
+#endif
+
 	if (e->parser) {
 		/* always run this on end strim*/
 		htmlParseChunk (e->parser, NULL, 0, 1);
 		if (e->parser->myDoc)
 			e->rootNode = xmlDocGetRootElement(e->parser->myDoc);
 	}
+#ifndef USEOLDRENDER
+	if (e->progressive) {
+		html_engine_progressive_build (e, TRUE);
+		if (e->streaming && e->parser && e->parser->myDoc) {
+			xmlFreeDoc (e->parser->myDoc);
+			e->parser->myDoc = NULL;
+			e->rootNode = NULL;
+		}
+	} else
+#endif
 	if(e->rootNode) {
 		e->eat_space = FALSE;
 		/* elementtree_parse_dumpnode(e->rootNode, 0); */
@@ -6093,12 +6795,21 @@ html_engine_stream_end (GtkHTMLStream *stream,
 #else
 		stupid_render(e, e->parser_clue, e->rootNode);
 #endif
-		if (e->css) {
-			g_free(e->css);
-			e->css = NULL;
-		}
 	}
 
+	html_engine_stream_finish (e);
+}
+
+static void
+html_engine_stream_finish (HTMLEngine *e)
+{
+#ifndef USEOLDRENDER
+	if (e->progressive)
+		html_engine_progressive_reset (e);
+#endif
+	html_css_context_free (e->css_context);
+	e->css_context = NULL;
+
 	if (e->opened_streams)
 		html_engine_opened_streams_decrement (e);
 	DI (printf ("ENGINE(%p) opened streams: %d\n", e, e->opened_streams));
@@ -6188,9 +6899,20 @@ html_engine_draw_real (HTMLEngine *e, gint x, gint y, gint width, gint height, g
 	y1 = y;
 	y2 = y + height;
 
+	/* exposes of a read-only view are served from rendered tiles, other
+	   draws mean the area changed */
+	if (e->tile_cache && (!expose || e->editable || e->caret_mode))
+		html_tile_cache_invalidate (e->tile_cache, x, y, width, height);
+
 	if (!html_engine_intersection (e, &x1, &y1, &x2, &y2))
 		return;
 
+	if (e->tile_cache && expose && !e->editable && !e->caret_mode) {
+		html_tile_cache_draw (e->tile_cache, x1, y1, x2, y2);
+		e->expose = FALSE;
+		return;
+	}
+
 	html_painter_begin (e->painter, x1, y1, x2, y2);
 
 	html_engine_draw_background (e, x1, y1, x2 - x1, y2 - y1);
@@ -6208,13 +6930,57 @@ html_engine_draw_real (HTMLEngine *e, gint x, gint y, gint width, gint height, g
 	e->expose = FALSE;
 }
 
+/* Scrolling is done by GtkLayout moving its bin window, GDK copies the
+   pixels which stay visible and exposes just the revealed bands.  Those are
+   painted one by one as long as there are few of them and they cover
+   noticeably less than their bounding box, e.g. the L shape left by a
+   diagonal scroll, otherwise the bounding box is painted at once.  */
+#define EXPOSE_MAX_RECTS 4
+
 void
 html_engine_expose (HTMLEngine *e, GdkEventExpose *event)
 {
-	if (html_engine_frozen (e))
-		html_engine_add_expose (e, event->area.x, event->area.y, event->area.width, event->area.height, TRUE);
-	else
-		html_engine_draw_real (e, event->area.x, event->area.y, event->area.width, event->area.height, TRUE);
+	GdkRectangle *rects = NULL;
+	gint i, n = 0;
+	gboolean direct;
+
+	if (event->region) {
+		gint64 area = 0;
+
+		gdk_region_get_rectangles (event->region, &rects, &n);
+		for (i = 0; i < n; i++)
+			area += (gint64) rects [i].width * rects [i].height;
+		if (n > EXPOSE_MAX_RECTS || area * 4 > (gint64) event->area.width * event->area.height * 3) {
+			g_free (rects);
+			rects = NULL;
+		}
+	}
+
+	if (!rects) {
+		rects = g_new (GdkRectangle, 1);
+		rects [0] = event->area;
+		n = 1;
+	}
+
+	/* GDK already buffers exposes of the painter's window, the painter
+	   does not need its own back buffer then */
+	direct = HTML_IS_GDK_PAINTER (e->painter)
+		&& event->window == HTML_GDK_PAINTER (e->painter)->window
+		&& gtk_widget_get_double_buffered (GTK_WIDGET (e->widget));
+
+	for (i = 0; i < n; i++) {
+		if (html_engine_frozen (e))
+			html_engine_add_expose (e, rects [i].x, rects [i].y, rects [i].width, rects [i].height, TRUE);
+		else {
+			if (direct)
+				HTML_GDK_PAINTER (e->painter)->direct = TRUE;
+			html_engine_draw_real (e, rects [i].x, rects [i].y, rects [i].width, rects [i].height, TRUE);
+			if (direct)
+				HTML_GDK_PAINTER (e->painter)->direct = FALSE;
+		}
+	}
+
+	g_free (rects);
 }
 
 void
@@ -6366,11 +7132,24 @@ html_engine_calc_size (HTMLEngine *e, GList **changed_objs)
 	if (e->clue == 0)
 		return FALSE;
 
-	html_object_reset (e->clue);
-
 	max_width = MIN (html_engine_get_max_width (e),
 			 html_painter_get_pixel_size (e->painter)
 			 * (MAX_WIDGET_WIDTH - html_engine_get_left_border (e) - html_engine_get_right_border (e)));
+
+	/* progressive parsing only appended objects, continue from the last
+	   laid out one.  Otherwise lay out again what the edits marked as
+	   changed, or everything when the width changed. */
+	if (max_width != e->clue->max_width)
+		html_object_reset (e->clue);
+	else if (!e->layout_tail)
+		html_object_reset_changed (e->clue);
+
+	/* tiles show the old layout; changed areas of an unchanged layout are
+	   invalidated by thaw_idle and the draw queue */
+	if (e->tile_cache && (max_width != e->clue->max_width || e->layout_tail))
+		html_tile_cache_clear (e->tile_cache);
+	e->layout_tail = FALSE;
+
 	/* max_height = MIN (html_engine_get_max_height (e),
 			 html_painter_get_pixel_size (e->painter)
 			 * (MAX_WIDGET_WIDTH - e->topBorder - e->bottomBorder)); */
@@ -6408,6 +7187,10 @@ html_engine_parse (HTMLEngine *e)
 		html_search_destroy (e->search_info);
 		e->search_info = NULL;
 	}
+	html_engine_search_all_clear (e);
+	if (e->tile_cache)
+		html_tile_cache_clear (e->tile_cache);
+	spell_check_cancel (e);
 	if (e->replace_info) {
 		html_replace_destroy (e->replace_info);
 		e->replace_info = NULL;
@@ -6660,6 +7443,21 @@ html_engine_flush_draw_queue (HTMLEngine *e)
 	}
 }
 
+/* Enables the offscreen tile cache, which keeps the rendered document of
+   read-only views and paints exposes from it.  */
+void
+html_engine_set_tile_cache (HTMLEngine *e, gboolean enable)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	if (enable && !e->tile_cache)
+		e->tile_cache = html_tile_cache_new (e, HTML_TILE_CACHE_BUDGET);
+	else if (!enable && e->tile_cache) {
+		html_tile_cache_destroy (e->tile_cache);
+		e->tile_cache = NULL;
+	}
+}
+
 void
 html_engine_queue_draw (HTMLEngine *e, HTMLObject *o)
 {
@@ -6745,6 +7543,8 @@ html_engine_freeze (HTMLEngine *engine)
 	g_return_if_fail (HTML_IS_ENGINE (engine));
 
 	if (engine->freeze_count == 0) {
+		/* verdicts on the way may be for paragraphs the edit destroys */
+		spell_check_invalidate (engine);
 		gtk_html_im_reset (engine->widget);
 		html_engine_flush_draw_queue (engine);
 		if ((HTML_IS_GDK_PAINTER (engine->painter) || HTML_IS_PLAIN_PAINTER (engine->painter)) && HTML_GDK_PAINTER (engine->painter)->window)
@@ -6992,6 +7792,10 @@ thaw_idle (gpointer data)
 			gdk_region_union_with_rect (region, &paint);
 		}
 		g_list_free (changed_objs);
+		/* cleared areas and draws queued while frozen are not
+		   tile cache invalidated yet */
+		if (e->tile_cache)
+			html_tile_cache_invalidate_region (e->tile_cache, region);
 		if (HTML_IS_GDK_PAINTER (e->painter))
 			gdk_window_invalidate_region (
 				HTML_GDK_PAINTER (e->painter)->window,
@@ -7002,6 +7806,11 @@ thaw_idle (gpointer data)
 	g_slist_free (e->pending_expose);
 	e->pending_expose = NULL;
 
+	/* find all results follow the edits */
+	html_engine_search_all_update (e);
+	if (e->spell_pending)
+		spell_check_start (e);
+
 	html_engine_show_cursor (e);
 
 	return FALSE;
@@ -7139,13 +7948,186 @@ html_engine_replace_do (HTMLEngine *e, HTMLReplaceQueryAnswer answer)
 	return finished;
 }
 
-/* spell checking */
+/* spell checking
+
+   Whole document checks mark the paragraphs dirty and check them from an
+   idle handler, a time slice per call, the visible paragraphs first. */
+
+#define SPELL_CHECK_SLICE 0.008 /* seconds */
+#define SPELL_CHECK_BATCHES 8    /* paragraphs waiting for check_words */
+
+typedef struct {
+	HTMLEngine *engine;
+	HTMLClueFlow *flow;
+	guint generation;
+} SpellBatch;
+
+static gboolean spell_check_idle (gpointer data);
 
 static void
-check_paragraph (HTMLObject *o, HTMLEngine *unused, HTMLEngine *e)
+mark_paragraph (HTMLObject *o, HTMLEngine *unused, HTMLEngine *e)
 {
 	if (HTML_OBJECT_TYPE (o) == HTML_TYPE_CLUEFLOW)
-		html_clueflow_spell_check (HTML_CLUEFLOW (o), e, NULL);
+		HTML_CLUEFLOW (o)->spell_dirty = TRUE;
+}
+
+static void
+queue_paragraph (HTMLObject *o, HTMLEngine *unused, GList **queue)
+{
+	if (HTML_OBJECT_TYPE (o) == HTML_TYPE_CLUEFLOW && HTML_CLUEFLOW (o)->spell_dirty)
+		*queue = g_list_prepend (*queue, o);
+}
+
+static gboolean
+paragraph_visible (HTMLEngine *e, HTMLObject *o)
+{
+	gint x, y;
+
+	html_object_calc_abs_position (o, &x, &y);
+
+	return y + o->descent > e->y_offset && y - o->ascent < e->y_offset + e->height;
+}
+
+static void
+spell_check_done (gchar **words, const gboolean *correct, gpointer data)
+{
+	SpellBatch *batch = data;
+	HTMLEngine *e = batch->engine;
+
+	/* the engine may be gone, the weak pointer is NULL then */
+	if (e)
+		g_object_remove_weak_pointer (G_OBJECT (e), (gpointer *) &batch->engine);
+
+	if (e && batch->generation == e->spell_generation) {
+		GHashTable *verdicts = g_hash_table_new (g_str_hash, g_str_equal);
+		guint i;
+
+		for (i = 0; words [i]; i++)
+			g_hash_table_insert (verdicts, words [i], GINT_TO_POINTER (correct [i] + 1));
+		if (batch->flow->spell_dirty)
+			html_clueflow_spell_check_with_verdicts (batch->flow, e, NULL, verdicts);
+		g_hash_table_destroy (verdicts);
+
+		e->spell_in_flight--;
+		if (e->spell_queue && !e->spell_idle_id)
+			e->spell_idle_id = g_idle_add (spell_check_idle, e);
+		else if (!e->spell_queue && !e->spell_in_flight)
+			e->spell_pending = FALSE;
+	}
+
+	g_free (batch);
+}
+
+static gboolean
+spell_check_idle (gpointer data)
+{
+	HTMLEngine *e = HTML_ENGINE (data);
+	GTimer *timer;
+
+	/* queued paragraphs may be destroyed by the edit, thaw_idle queues
+	   the dirty ones again */
+	if (html_engine_frozen (e)) {
+		g_list_free (e->spell_queue);
+		e->spell_queue = NULL;
+		e->spell_idle_id = 0;
+		return FALSE;
+	}
+
+	timer = g_timer_new ();
+	while (e->spell_queue && e->spell_in_flight < SPELL_CHECK_BATCHES
+	       && g_timer_elapsed (timer, NULL) < SPELL_CHECK_SLICE) {
+		HTMLClueFlow *flow = HTML_CLUEFLOW (e->spell_queue->data);
+		gchar **words = NULL;
+
+		e->spell_queue = g_list_delete_link (e->spell_queue, e->spell_queue);
+		if (!flow->spell_dirty)
+			continue;
+
+		if (e->widget->editor_api && e->widget->editor_api->check_words)
+			words = html_clueflow_get_spell_words (flow);
+		if (words) {
+			SpellBatch *batch = g_new (SpellBatch, 1);
+
+			batch->engine = e;
+			g_object_add_weak_pointer (G_OBJECT (e), (gpointer *) &batch->engine);
+			batch->flow = flow;
+			batch->generation = e->spell_generation;
+			e->spell_in_flight++;
+			(*e->widget->editor_api->check_words) (e->widget, words, spell_check_done, batch,
+								 e->widget->editor_data);
+			g_strfreev (words);
+		} else
+			html_clueflow_spell_check (flow, e, NULL);
+	}
+	g_timer_destroy (timer);
+
+	if (e->spell_queue && e->spell_in_flight < SPELL_CHECK_BATCHES)
+		return TRUE;
+
+	/* spell_check_done continues */
+	e->spell_idle_id = 0;
+	if (!e->spell_queue && !e->spell_in_flight)
+		e->spell_pending = FALSE;
+
+	return FALSE;
+}
+
+static void
+spell_check_start (HTMLEngine *e)
+{
+	GList *queue = NULL, *visible = NULL, *rest = NULL, *l;
+
+	e->spell_pending = TRUE;
+	if (html_engine_frozen (e) || !e->clue)
+		return;
+
+	html_object_forall (e->clue, NULL, (HTMLObjectForallFunc) queue_paragraph, &queue);
+	for (l = queue; l; l = l->next) {
+		if (paragraph_visible (e, HTML_OBJECT (l->data)))
+			visible = g_list_prepend (visible, l->data);
+		else
+			rest = g_list_prepend (rest, l->data);
+	}
+	g_list_free (queue);
+
+	g_list_free (e->spell_queue);
+	e->spell_queue = g_list_concat (visible, rest);
+
+	if (!e->spell_idle_id)
+		e->spell_idle_id = g_idle_add (spell_check_idle, e);
+}
+
+static void
+spell_check_cancel (HTMLEngine *e)
+{
+	if (e->spell_idle_id) {
+		g_source_remove (e->spell_idle_id);
+		e->spell_idle_id = 0;
+	}
+	g_list_free (e->spell_queue);
+	e->spell_queue = NULL;
+	e->spell_pending = FALSE;
+	spell_check_invalidate (e);
+}
+
+/* drops the verdicts of the paragraphs sent to check_words, they stay
+   dirty and are queued again */
+static void
+spell_check_invalidate (HTMLEngine *e)
+{
+	if (e->spell_in_flight) {
+		e->spell_generation++;
+		e->spell_in_flight = 0;
+	}
+}
+
+/* stops checking the document, verdicts still on the way are dropped */
+void
+html_engine_spell_check_cancel (HTMLEngine *e)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	spell_check_cancel (e);
 }
 
 void
@@ -7156,8 +8138,12 @@ html_engine_spell_check (HTMLEngine *e)
 
 	e->need_spell_check = FALSE;
 
-	if (e->widget->editor_api && e->widget->editor_api->check_word)
-		html_object_forall (e->clue, NULL, (HTMLObjectForallFunc) check_paragraph, e);
+	if (e->widget->editor_api && e->widget->editor_api->check_word) {
+		/* the dictionaries may have changed */
+		spell_check_invalidate (e);
+		html_object_forall (e->clue, NULL, (HTMLObjectForallFunc) mark_paragraph, e);
+		spell_check_start (e);
+	}
 }
 
 static void
@@ -7165,6 +8151,8 @@ clear_spell_check (HTMLObject *o, HTMLEngine *unused, HTMLEngine *e)
 {
 	if (html_object_is_text (o))
 		html_text_spell_errors_clear (HTML_TEXT (o));
+	else if (HTML_OBJECT_TYPE (o) == HTML_TYPE_CLUEFLOW)
+		HTML_CLUEFLOW (o)->spell_dirty = FALSE;
 }
 
 void
@@ -7174,6 +8162,7 @@ html_engine_clear_spell_check (HTMLEngine *e)
 	g_return_if_fail (e->clue);
 
 	e->need_spell_check = FALSE;
+	spell_check_cancel (e);
 
 	html_object_forall (e->clue, NULL, (HTMLObjectForallFunc) clear_spell_check, e);
 	html_engine_draw (e, e->x_offset, e->y_offset, e->width, e->height);
@@ -7239,7 +8228,7 @@ html_engine_spell_word_is_valid (HTMLEngine *e)
 {
 	HTMLObject *obj;
 	HTMLText   *text;
-	GList *cur;
+	guint i;
 	gboolean valid = TRUE;
 	gint offset;
 	gunichar prev, curr;
@@ -7269,17 +8258,10 @@ html_engine_spell_word_is_valid (HTMLEngine *e)
 	text = HTML_TEXT (obj);
 
 	/* now we have text, so let search for spell_error area in it */
-	cur = text->spell_errors;
-	while (cur) {
-		SpellError *se = (SpellError *) cur->data;
-		if (se->off <= offset && offset <= se->off + se->len) {
-			valid = FALSE;
-			break;
-		}
-		if (offset < se->off)
-			break;
-		cur = cur->next;
-	}
+	i = html_text_spell_errors_search (text, offset);
+	if (text->spell_errors && i < text->spell_errors->len
+	    && g_array_index (text->spell_errors, SpellError, i).off <= offset)
+		valid = FALSE;
 
 	/* printf ("is_valid: %d\n", valid); */
 
@@ -7559,6 +8541,8 @@ html_engine_queue_redraw_all (HTMLEngine *e)
 
 	clear_pending_expose (e);
 	html_draw_queue_clear (e->draw_queue);
+	if (e->tile_cache)
+		html_tile_cache_clear (e->tile_cache);
 
 	if (gtk_widget_get_realized (GTK_WIDGET (e->widget))) {
 		gtk_widget_queue_draw (GTK_WIDGET (e->widget));
@@ -7846,6 +8830,7 @@ html_engine_saved (HTMLEngine *e)
 	g_return_if_fail (HTML_IS_ENGINE (e));
 
 	e->saved_step_count = html_undo_get_step_count (e->undo);
+	html_undo_mark_saved (e->undo);
 }
 
 static gboolean
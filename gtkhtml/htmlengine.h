@@ -52,6 +52,8 @@
 struct _HTMLEngine {
 	GObject parent;
 	HTMLDrawQueue *draw_queue;
+	/* rendered tiles of read-only documents, NULL unless enabled */
+	HTMLTileCache *tile_cache;
 
 	HTMLPainter *painter;
 
@@ -87,7 +89,7 @@ struct _HTMLEngine {
 
 	gboolean enableconvert;        /*enable convert encoding*/
 	gchar * content_type;          /*current encoding*/
-	gchar * css;                   /* current css */
+	HTMLCssContext *css_context;   /* style sheets of the current document */
 	xmlNode* rootNode;
 
 	gboolean parsing;
@@ -217,6 +219,7 @@ struct _HTMLEngine {
 	/* search & replace */
 	HTMLSearch  *search_info;
 	HTMLReplace *replace_info;
+	HTMLSearchAll *search_all;
 
 	/* id-to-object mapping */
 	GHashTable *id_table;
@@ -230,6 +233,15 @@ struct _HTMLEngine {
 	gdouble min_split_index;
 
 	gboolean need_spell_check;
+
+	/* paragraphs waiting for the idle spell checker, visible first */
+	GList *spell_queue;
+	guint spell_idle_id;
+	gboolean spell_pending;
+	/* paragraphs sent to editor_api->check_words */
+	guint spell_in_flight;
+	guint spell_generation;
+
 	gint block_events;
 	gchar *language;
 
@@ -259,6 +271,23 @@ struct _HTMLEngine {
 	gboolean need_update;
 
 	HTMLObject *parser_clue;  /* the root of the currently parsed block */
+
+	/* Progressive parsing: completed top level subtrees are turned into
+	   objects while the stream is still open.  */
+	gboolean progressive;
+	xmlNode *progressive_parent;    /* node whose children are being built */
+	xmlNode *progressive_last;      /* last child of progressive_parent already built */
+	HTMLObject *progressive_clue;   /* clue the next built child goes to */
+	HTMLStyle *progressive_style;   /* style inherited from progressive_parent */
+	gint progressive_count;
+	GTimer *progressive_timer;      /* time since the last progressive update */
+	gboolean streaming;             /* build from SAX events and free built nodes */
+	gboolean threaded;              /* parse and style in a worker thread */
+	HTMLParserThread *parser_thread;
+
+	/* When set, the next calc_size continues from the last laid out
+	   object of the document clue instead of starting over.  */
+	gboolean layout_tail;
 };
 
 /* must be forward referenced *sigh* */
@@ -315,6 +344,15 @@ const gchar *  html_engine_get_content_type (HTMLEngine *e);
 const gchar *  html_engine_get_href         (HTMLEngine *e);
 void           html_engine_set_href         (HTMLEngine *e,
                                         const gchar * url);
+void           html_engine_set_progressive  (HTMLEngine *e,
+					 gboolean progressive);
+gboolean       html_engine_get_progressive  (HTMLEngine *e);
+void           html_engine_set_streaming    (HTMLEngine *e,
+					 gboolean streaming);
+gboolean       html_engine_get_streaming    (HTMLEngine *e);
+void           html_engine_set_threaded     (HTMLEngine *e,
+					 gboolean threaded);
+gboolean       html_engine_get_threaded     (HTMLEngine *e);
 
 /* Rendering control.  */
 gint  html_engine_calc_min_width       (HTMLEngine *e);
@@ -348,6 +386,8 @@ gboolean  html_engine_goto_anchor          (HTMLEngine  *e,
 
 /* Draw/clear queue.  */
 void  html_engine_flush_draw_queue  (HTMLEngine *e);
+void  html_engine_set_tile_cache    (HTMLEngine *e,
+				     gboolean    enable);
 void  html_engine_queue_draw        (HTMLEngine *e,
 				     HTMLObject *o);
 void  html_engine_queue_clear       (HTMLEngine *e,
@@ -413,6 +453,7 @@ void      html_engine_init_magic_links          (void);
 /* spell checking */
 void      html_engine_spell_check              (HTMLEngine  *e);
 void      html_engine_clear_spell_check        (HTMLEngine  *e);
+void      html_engine_spell_check_cancel       (HTMLEngine  *e);
 gchar    *html_engine_get_spell_word           (HTMLEngine  *e);
 gboolean  html_engine_spell_word_is_valid      (HTMLEngine  *e);
 void      html_engine_replace_spell_word_with  (HTMLEngine  *e,
@@ -42,6 +42,114 @@ static HTMLPainterClass *parent_class = NULL;
 
 static void set_clip_rectangle (HTMLPainter *painter, gint x, gint y, gint width, gint height);
 
+/* Background images are tiled from a pixmap holding one copy of the
+   image over the background color.  Those are kept per painter, most
+   recently used first, for as long as the image's pixbuf lives.  */
+
+#define BACKGROUND_TILES_MAX 16
+
+typedef struct {
+	HTMLGdkPainter *painter;
+	/* not referenced, the tile is dropped when it is finalized */
+	GdkPixbuf *pixbuf;
+	gboolean has_color;
+	GdkColor color;
+	GdkPixmap *pixmap;
+	GdkGC *gc;
+} HTMLGdkBackgroundTile;
+
+static void
+background_tile_free (HTMLGdkBackgroundTile *tile)
+{
+	g_object_unref (tile->pixmap);
+	g_object_unref (tile->gc);
+	g_free (tile);
+}
+
+static void
+background_tile_pixbuf_finalized (gpointer data, GObject *pixbuf)
+{
+	HTMLGdkBackgroundTile *tile = data;
+
+	tile->painter->background_tiles = g_slist_remove (tile->painter->background_tiles, tile);
+	background_tile_free (tile);
+}
+
+static void
+background_tile_remove (HTMLGdkPainter *painter, HTMLGdkBackgroundTile *tile)
+{
+	g_object_weak_unref (G_OBJECT (tile->pixbuf), background_tile_pixbuf_finalized, tile);
+	painter->background_tiles = g_slist_remove (painter->background_tiles, tile);
+	background_tile_free (tile);
+}
+
+/* Drops all background tiles, needed when an image changes in place.  */
+void
+html_gdk_painter_clear_background_tiles (HTMLGdkPainter *painter)
+{
+	g_return_if_fail (HTML_IS_GDK_PAINTER (painter));
+
+	while (painter->background_tiles)
+		background_tile_remove (painter, painter->background_tiles->data);
+}
+
+static HTMLGdkBackgroundTile *
+get_background_tile (HTMLGdkPainter *painter, GdkPixbuf *pixbuf, GdkColor *color)
+{
+	HTMLGdkBackgroundTile *tile;
+	GSList *l;
+	gint pw, ph;
+
+	for (l = painter->background_tiles; l; l = l->next) {
+		tile = l->data;
+
+		if (tile->pixbuf == pixbuf
+		    && (color ? tile->has_color && gdk_color_equal (color, &tile->color) : !tile->has_color)) {
+			if (l != painter->background_tiles) {
+				painter->background_tiles = g_slist_delete_link (painter->background_tiles, l);
+				painter->background_tiles = g_slist_prepend (painter->background_tiles, tile);
+			}
+			return tile;
+		}
+	}
+
+	if (g_slist_length (painter->background_tiles) >= BACKGROUND_TILES_MAX)
+		background_tile_remove (painter, g_slist_last (painter->background_tiles)->data);
+
+	pw = gdk_pixbuf_get_width (pixbuf);
+	ph = gdk_pixbuf_get_height (pixbuf);
+
+	tile = g_new0 (HTMLGdkBackgroundTile, 1);
+	tile->painter = painter;
+	tile->pixbuf = pixbuf;
+	tile->pixmap = gdk_pixmap_new (painter->window, pw, ph, -1);
+	tile->gc = gdk_gc_new (painter->window);
+
+	if (color) {
+		tile->has_color = TRUE;
+		tile->color = *color;
+		gdk_gc_set_foreground (tile->gc, color);
+		gdk_draw_rectangle (tile->pixmap, tile->gc,
+				    TRUE, 0, 0,
+				    pw, ph);
+	}
+
+	gdk_draw_pixbuf (tile->pixmap, NULL, pixbuf,
+			 0, 0,
+			 0, 0,
+			 pw, ph,
+			 GDK_RGB_DITHER_NORMAL,
+			 0, 0);
+
+	gdk_gc_set_tile (tile->gc, tile->pixmap);
+	gdk_gc_set_fill (tile->gc, GDK_TILED);
+
+	g_object_weak_ref (G_OBJECT (pixbuf), background_tile_pixbuf_finalized, tile);
+	painter->background_tiles = g_slist_prepend (painter->background_tiles, tile);
+
+	return tile;
+}
+
 /* GObject methods.  */
 
 static void
@@ -51,6 +159,8 @@ finalize (GObject *object)
 
 	painter = HTML_GDK_PAINTER (object);
 
+	html_gdk_painter_clear_background_tiles (painter);
+
 	if (painter->gc != NULL) {
 		g_object_unref (painter->gc);
 		painter->gc = NULL;
@@ -99,7 +209,12 @@ begin (HTMLPainter *painter, gint x1, gint y1, gint x2, gint y2)
 
 	set_clip_rectangle (painter, 0, 0, 0, 0);
 
-	if (gdk_painter->double_buffer) {
+	gdk_painter->area.x = x1;
+	gdk_painter->area.y = y1;
+	gdk_painter->area.width = x2 - x1;
+	gdk_painter->area.height = y2 - y1;
+
+	if (gdk_painter->double_buffer && !gdk_painter->direct) {
 		const gint width = x2 - x1 + 1;
 		const gint height = y2 - y1 + 1;
 
@@ -141,7 +256,7 @@ end (HTMLPainter *painter)
 
 	gdk_painter = HTML_GDK_PAINTER (painter);
 
-	if (!gdk_painter->double_buffer)
+	if (!gdk_painter->double_buffer || gdk_painter->pixmap == gdk_painter->window)
 		return;
 
 	gdk_draw_drawable (gdk_painter->window, gdk_painter->gc,
@@ -155,6 +270,45 @@ end (HTMLPainter *painter)
 	gdk_painter->pixmap = NULL;
 }
 
+/**
+ * html_gdk_painter_begin_pixmap:
+ * @painter: a painter
+ * @pixmap: pixmap to draw on
+ * @x: window x coordinate of the pixmap's left edge
+ * @y: window y coordinate of the pixmap's top edge
+ *
+ * Like html_painter_begin, but draws into @pixmap instead of the window,
+ * used to render offscreen tiles. Finish with html_gdk_painter_end_pixmap.
+ **/
+void
+html_gdk_painter_begin_pixmap (HTMLGdkPainter *painter, GdkPixmap *pixmap, gint x, gint y)
+{
+	gint width, height;
+
+	g_return_if_fail (painter->window != NULL);
+
+	set_clip_rectangle (HTML_PAINTER (painter), 0, 0, 0, 0);
+
+	gdk_drawable_get_size (pixmap, &width, &height);
+	if (painter->pixmap && painter->pixmap != painter->window)
+		g_object_unref (painter->pixmap);
+	painter->pixmap = g_object_ref (pixmap);
+	painter->x1 = painter->area.x = x;
+	painter->y1 = painter->area.y = y;
+	painter->x2 = x + width;
+	painter->y2 = y + height;
+	painter->area.width = width;
+	painter->area.height = height;
+}
+
+void
+html_gdk_painter_end_pixmap (HTMLGdkPainter *painter)
+{
+	if (painter->pixmap && painter->pixmap != painter->window)
+		g_object_unref (painter->pixmap);
+	painter->pixmap = NULL;
+}
+
 static void
 clear (HTMLPainter *painter)
 {
@@ -181,7 +335,7 @@ set_clip_rectangle (HTMLPainter *painter,
 		    gint width, gint height)
 {
 	HTMLGdkPainter *gdk_painter;
-	GdkRectangle rect;
+	GdkRectangle rect, *area;
 
 	gdk_painter = HTML_GDK_PAINTER (painter);
 
@@ -190,10 +344,11 @@ set_clip_rectangle (HTMLPainter *painter,
 		return;
 	}
 
-	rect.x = CLAMP (x - gdk_painter->x1, 0, gdk_painter->x2 - gdk_painter->x1);
-	rect.y = CLAMP (y - gdk_painter->y1, 0, gdk_painter->y2 - gdk_painter->y1);
-	rect.width = CLAMP (width, 0, gdk_painter->x2 - gdk_painter->x1 - rect.x);
-	rect.height = CLAMP (height, 0, gdk_painter->y2 - gdk_painter->y1 - rect.y);
+	area = &gdk_painter->area;
+	rect.x = CLAMP (x, area->x, area->x + area->width) - gdk_painter->x1;
+	rect.y = CLAMP (y, area->y, area->y + area->height) - gdk_painter->y1;
+	rect.width = CLAMP (width, 0, area->x + area->width - gdk_painter->x1 - rect.x);
+	rect.height = CLAMP (height, 0, area->y + area->height - gdk_painter->y1 - rect.y);
 
 	gdk_gc_set_clip_rectangle (gdk_painter->gc, &rect);
 }
@@ -372,10 +527,7 @@ draw_background (HTMLPainter *painter,
 	expose.width  = width;
 	expose.height = height;
 
-	clip.x = gdk_painter->x1;
-	clip.width = gdk_painter->x2 - gdk_painter->x1;
-	clip.y = gdk_painter->y1;
-	clip.height = gdk_painter->y2 - gdk_painter->y1;
+	clip = gdk_painter->area;
 
 	if (!gdk_rectangle_intersect (&clip, &expose, &paint))
 		return;
@@ -431,45 +583,24 @@ draw_background (HTMLPainter *painter,
 
 	/* do tiling */
 	if (tile_width > pw || tile_height > ph) {
-		GdkPixmap *pixmap = NULL;
 		gint cw, ch, cx, cy;
 		gint dw, dh;
-		GdkGC *gc;
 
 		dw = MIN (pw, tile_width);
 		dh = MIN (ph, tile_height);
 
-		gc = gdk_gc_new (gdk_painter->window);
-
 		if (color || !gdk_pixbuf_get_has_alpha (pixbuf)) {
-			pixmap = gdk_pixmap_new (gdk_painter->window, dw, dh, -1);
-
-			if (color) {
-				gdk_gc_set_foreground (gc, color);
-				gdk_draw_rectangle (pixmap, gc,
-						    TRUE, 0, 0,
-						    dw, dh);
-			}
+			HTMLGdkBackgroundTile *tile;
 
-			gdk_draw_pixbuf (pixmap, NULL, pixbuf,
-					 0, 0,
-					 0, 0,
-					 dw, dh,
-					 GDK_RGB_DITHER_NORMAL,
-					 paint.x, paint.y);
+			tile = get_background_tile (gdk_painter, pixbuf, color);
 
-			gdk_gc_set_tile (gc, pixmap);
-			gdk_gc_set_fill (gc, GDK_TILED);
-			gdk_gc_set_ts_origin (gc,
+			gdk_gc_set_ts_origin (tile->gc,
 					      paint.x - (tile_x % pw) - clip.x,
 					      paint.y - (tile_y % ph) - clip.y);
 
-			gdk_draw_rectangle (gdk_painter->pixmap, gc, TRUE,
+			gdk_draw_rectangle (gdk_painter->pixmap, tile->gc, TRUE,
 					    paint.x - clip.x, paint.y - clip.y,
 					    paint.width, paint.height);
-
-			g_object_unref (pixmap);
-			g_object_unref (gc);
 		} else {
 			gint incr_x = 0;
 			gint incr_y = 0;
@@ -502,8 +633,6 @@ draw_background (HTMLPainter *painter,
 				cy += incr_y;
 				h = 0;
 			}
-
-			g_object_unref (gc);
 		}
 	} else {
 		if (color && gdk_pixbuf_get_has_alpha (pixbuf)) {
@@ -522,66 +651,33 @@ draw_background (HTMLPainter *painter,
 	}
 }
 
-static void
-draw_pixmap (HTMLPainter *painter,
-	     GdkPixbuf *pixbuf,
-	     gint x, gint y,
-	     gint scale_width, gint scale_height,
-	     const GdkColor *color)
+/* Renders the width x height area at x, y of pixbuf scaled to
+   scale_width x scale_height, tinted with color when set.  */
+static GdkPixbuf *
+scale_pixbuf (GdkPixbuf *pixbuf,
+	      gint x, gint y,
+	      gint width, gint height,
+	      gint scale_width, gint scale_height,
+	      const GdkColor *color)
 {
-	GdkRectangle clip, image, paint;
-	HTMLGdkPainter *gdk_painter;
 	GdkPixbuf *tmp_pixbuf;
 	guint n_channels;
 	gint orig_width;
 	gint orig_height;
 	gint bilinear;
 
-	gdk_painter = HTML_GDK_PAINTER (painter);
-
 	orig_width = gdk_pixbuf_get_width (pixbuf);
 	orig_height = gdk_pixbuf_get_height (pixbuf);
 
-	if (scale_width < 0)
-		scale_width = orig_width;
-	if (scale_height < 0)
-		scale_height = orig_height;
-
-	image.x = x;
-	image.y = y;
-	image.width  = scale_width;
-	image.height = scale_height;
-
-	clip.x = gdk_painter->x1;
-	clip.width = gdk_painter->x2 - gdk_painter->x1;
-	clip.y = gdk_painter->y1;
-	clip.height = gdk_painter->y2 - gdk_painter->y1;
-
-	if (!gdk_rectangle_intersect (&clip, &image, &paint))
-	    return;
-
-	if (scale_width == orig_width && scale_height == orig_height && color == NULL) {
-		gdk_draw_pixbuf (gdk_painter->pixmap, NULL, pixbuf,
-				 paint.x - image.x,
-				 paint.y - image.y,
-				 paint.x - clip.x,
-				 paint.y - clip.y,
-				 paint.width,
-				 paint.height,
-				 GDK_RGB_DITHER_NORMAL,
-				 paint.x, paint.y);
-		return;
-	}
-
 	tmp_pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
 				     gdk_pixbuf_get_has_alpha (pixbuf),
 				     gdk_pixbuf_get_bits_per_sample (pixbuf),
-				     paint.width, paint.height);
-
-	gdk_pixbuf_fill (tmp_pixbuf, 0xff000000);
+				     width, height);
 
 	if (tmp_pixbuf == NULL)
-		return;
+		return NULL;
+
+	gdk_pixbuf_fill (tmp_pixbuf, 0xff000000);
 
 	/*
 	 * FIXME this is a hack to work around a gdk-pixbuf bug
@@ -594,9 +690,9 @@ draw_pixmap (HTMLPainter *painter,
 	gdk_pixbuf_composite (pixbuf, tmp_pixbuf,
 			      0,
 			      0,
-			      paint.width, paint.height,
-			      (double)-(paint.x - image.x),
-			      (double)-(paint.y - image.y),
+			      width, height,
+			      (double)-x,
+			      (double)-y,
 			      (gdouble) scale_width/ (gdouble) orig_width,
 			      (gdouble) scale_height/ (gdouble) orig_height,
 			      bilinear ? GDK_INTERP_BILINEAR : GDK_INTERP_NEAREST,
@@ -608,10 +704,10 @@ draw_pixmap (HTMLPainter *painter,
 
 		n_channels = gdk_pixbuf_get_n_channels (tmp_pixbuf);
 		q = gdk_pixbuf_get_pixels (tmp_pixbuf);
-		for (i = 0; i < paint.height; i++) {
+		for (i = 0; i < height; i++) {
 			guchar *p = q;
 
-			for (j = 0; j < paint.width; j++) {
+			for (j = 0; j < width; j++) {
 				gint r, g, b, a;
 
 				if (n_channels > 3)
@@ -637,6 +733,87 @@ draw_pixmap (HTMLPainter *painter,
 		}
 	}
 
+	return tmp_pixbuf;
+}
+
+/**
+ * html_gdk_painter_scale_pixbuf:
+ * @pixbuf: the source image
+ * @scale_width: width of the result
+ * @scale_height: height of the result
+ * @color: tint color or NULL
+ *
+ * Renders the whole @pixbuf the way draw_pixmap paints it at the given
+ * size and tint, so that the result can be kept and drawn unscaled.
+ *
+ * Return value: a new pixbuf or NULL.
+ **/
+GdkPixbuf *
+html_gdk_painter_scale_pixbuf (GdkPixbuf *pixbuf,
+			       gint scale_width, gint scale_height,
+			       const GdkColor *color)
+{
+	g_return_val_if_fail (pixbuf != NULL, NULL);
+	g_return_val_if_fail (scale_width > 0 && scale_height > 0, NULL);
+
+	return scale_pixbuf (pixbuf, 0, 0, scale_width, scale_height, scale_width, scale_height, color);
+}
+
+static void
+draw_pixmap (HTMLPainter *painter,
+	     GdkPixbuf *pixbuf,
+	     gint x, gint y,
+	     gint scale_width, gint scale_height,
+	     const GdkColor *color)
+{
+	GdkRectangle clip, image, paint;
+	HTMLGdkPainter *gdk_painter;
+	GdkPixbuf *tmp_pixbuf;
+	gint orig_width;
+	gint orig_height;
+
+	gdk_painter = HTML_GDK_PAINTER (painter);
+
+	orig_width = gdk_pixbuf_get_width (pixbuf);
+	orig_height = gdk_pixbuf_get_height (pixbuf);
+
+	if (scale_width < 0)
+		scale_width = orig_width;
+	if (scale_height < 0)
+		scale_height = orig_height;
+
+	image.x = x;
+	image.y = y;
+	image.width  = scale_width;
+	image.height = scale_height;
+
+	clip = gdk_painter->area;
+
+	if (!gdk_rectangle_intersect (&clip, &image, &paint))
+	    return;
+
+	if (scale_width == orig_width && scale_height == orig_height && color == NULL) {
+		gdk_draw_pixbuf (gdk_painter->pixmap, NULL, pixbuf,
+				 paint.x - image.x,
+				 paint.y - image.y,
+				 paint.x - clip.x,
+				 paint.y - clip.y,
+				 paint.width,
+				 paint.height,
+				 GDK_RGB_DITHER_NORMAL,
+				 paint.x, paint.y);
+		return;
+	}
+
+	tmp_pixbuf = scale_pixbuf (pixbuf,
+				   paint.x - image.x, paint.y - image.y,
+				   paint.width, paint.height,
+				   scale_width, scale_height,
+				   color);
+
+	if (tmp_pixbuf == NULL)
+		return;
+
 	gdk_draw_pixbuf (gdk_painter->pixmap, NULL, tmp_pixbuf,
 			 0,
 			 0,
@@ -875,11 +1052,15 @@ html_gdk_painter_init (GObject *object)
 	gdk_painter->gc = NULL;
 
 	gdk_painter->double_buffer = TRUE;
+	gdk_painter->direct = FALSE;
 	gdk_painter->pixmap = NULL;
 	gdk_painter->x1 = gdk_painter->y1 = 0;
 	gdk_painter->x2 = gdk_painter->y2 = 0;
+	gdk_painter->area.x = gdk_painter->area.y = 0;
+	gdk_painter->area.width = gdk_painter->area.height = 0;
 	gdk_painter->set_background = FALSE;
 	gdk_painter->do_clear = FALSE;
+	gdk_painter->background_tiles = NULL;
 
 	init_color (& gdk_painter->background, 0xffff, 0xffff, 0xffff);
 	init_color (& gdk_painter->dark, 0, 0, 0);
@@ -1003,6 +1184,8 @@ html_gdk_painter_unrealize (HTMLGdkPainter *painter)
 	g_return_if_fail (HTML_IS_GDK_PAINTER (painter));
 
 	if (html_gdk_painter_realized (painter)) {
+		html_gdk_painter_clear_background_tiles (painter);
+
 		g_object_unref (painter->gc);
 		painter->gc = NULL;
 
@@ -44,11 +44,19 @@ struct _HTMLGdkPainter {
 
 	/* For the double-buffering system.  */
 	gboolean double_buffer;
+	/* Set while painting an expose GDK already buffers, the painter then
+	   draws straight to the window.  */
+	gboolean direct;
 	GdkPixmap *pixmap;
+	/* pixmap origin and far corner in window coordinates */
 	gint x1, y1, x2, y2;
+	/* area being painted in window coordinates, drawing is clipped to it */
+	GdkRectangle area;
 	GdkColor background;
 	gboolean set_background;
 	gboolean do_clear;
+	/* prepared background image tiles, most recently used first */
+	GSList *background_tiles;
 
 	/* Colors used for shading.  */
 	GdkColor dark;
@@ -67,5 +75,15 @@ void               html_gdk_painter_realize                          (HTMLGdkPai
 								      GdkWindow             *window);
 void               html_gdk_painter_unrealize                        (HTMLGdkPainter        *painter);
 gboolean           html_gdk_painter_realized                         (HTMLGdkPainter        *painter);
+void               html_gdk_painter_begin_pixmap                     (HTMLGdkPainter        *painter,
+								      GdkPixmap             *pixmap,
+								      gint                   x,
+								      gint                   y);
+void               html_gdk_painter_end_pixmap                       (HTMLGdkPainter        *painter);
+void               html_gdk_painter_clear_background_tiles           (HTMLGdkPainter        *painter);
+GdkPixbuf         *html_gdk_painter_scale_pixbuf                     (GdkPixbuf             *pixbuf,
+								      gint                   scale_width,
+								      gint                   scale_height,
+								      const GdkColor        *color);
 
 #endif /* _HTMLGDKPAINTER_H */
@@ -56,6 +56,8 @@ struct _HTMLImageFactory {
 
 
 #define DEFAULT_SIZE 48
+/* bytes of scaled image renditions kept over all images */
+#define HTML_IMAGE_RENDITIONS_BUDGET (8 * 1024 * 1024)
 #define STRDUP_HELPER(i,j) if (i != j) {char *tmp = g_strdup (j); g_free(i); i = tmp;}
 
 #define DA(x)
@@ -69,6 +71,12 @@ static void                html_image_pointer_unref             (HTMLImagePointe
 static gboolean            html_image_pointer_timeout           (HTMLImagePointer *ip);
 static gint                html_image_pointer_update            (HTMLImagePointer *ip);
 static void                html_image_pointer_start_animation   (HTMLImagePointer *ip);
+static void                html_image_pointer_drop_renditions   (HTMLImagePointer *ip);
+static GdkPixbuf          *html_image_pointer_get_rendition     (HTMLImagePointer *ip,
+								 GdkPixbuf *pixbuf,
+								 gint width,
+								 gint height,
+								 const GdkColor *color);
 
 static GdkPixbuf *         html_image_factory_get_missing       (HTMLImageFactory *factory);
 
@@ -535,6 +543,16 @@ draw (HTMLObject *o,
 
 	}
 
+	if (HTML_IS_GDK_PAINTER (painter)) {
+		GdkPixbuf *rendition;
+
+		rendition = html_image_pointer_get_rendition (ip, pixbuf, scale_width, scale_height, highlight_color);
+		if (rendition) {
+			pixbuf = rendition;
+			highlight_color = NULL;
+		}
+	}
+
 	html_painter_draw_pixmap (painter, pixbuf,
 				  base_x, base_y,
 				  scale_width, scale_height,
@@ -1173,6 +1191,11 @@ html_image_pointer_update (HTMLImagePointer *ip)
 	engine = ip->factory->engine;
 	ip->animation_timeout = 0;
 
+	/* the frame changed */
+	html_image_pointer_drop_renditions (ip);
+	if (g_slist_find (ip->interests, NULL) && HTML_IS_GDK_PAINTER (engine->painter))
+		html_gdk_painter_clear_background_tiles (HTML_GDK_PAINTER (engine->painter));
+
 	DA (printf ("animation_timeout (%p)\n", ip);)
 	for (cur = ip->interests; cur; cur = cur->next) {
 		HTMLImage           *image = cur->data;
@@ -1189,6 +1212,99 @@ html_image_pointer_update (HTMLImagePointer *ip)
 	return FALSE;
 }
 
+/* Scaled renditions of image frames, shared by all images of a pointer and
+   kept under a common budget in least recently used order.  */
+
+typedef struct {
+	HTMLImagePointer *ip;
+	GdkPixbuf *source;
+	gint width, height;
+	gboolean tinted;
+	GdkColor tint;
+	GdkPixbuf *pixbuf;
+	gsize size;
+
+	/* link in renditions_lru, data points back to the rendition */
+	GList lru_link;
+} HTMLImageRendition;
+
+static GQueue renditions_lru = G_QUEUE_INIT;
+static gsize renditions_size = 0;
+
+static void
+rendition_free (HTMLImageRendition *r)
+{
+	r->ip->renditions = g_slist_remove (r->ip->renditions, r);
+	g_queue_unlink (&renditions_lru, &r->lru_link);
+	renditions_size -= r->size;
+	g_object_unref (r->pixbuf);
+	g_object_unref (r->source);
+	g_free (r);
+}
+
+static void
+html_image_pointer_drop_renditions (HTMLImagePointer *ip)
+{
+	while (ip->renditions)
+		rendition_free (ip->renditions->data);
+}
+
+/* Returns pixbuf scaled to width x height and tinted with color, or NULL
+   when it needs neither or is too big to keep.  */
+static GdkPixbuf *
+html_image_pointer_get_rendition (HTMLImagePointer *ip, GdkPixbuf *pixbuf, gint width, gint height, const GdkColor *color)
+{
+	HTMLImageRendition *r;
+	GSList *l;
+	gsize size;
+
+	if (width <= 0 || height <= 0
+	    || (width == gdk_pixbuf_get_width (pixbuf) && height == gdk_pixbuf_get_height (pixbuf) && !color))
+		return NULL;
+
+	for (l = ip->renditions; l; l = l->next) {
+		r = l->data;
+
+		if (r->source == pixbuf && r->width == width && r->height == height
+		    && (color ? r->tinted && gdk_color_equal (color, &r->tint) : !r->tinted)) {
+			g_queue_unlink (&renditions_lru, &r->lru_link);
+			g_queue_push_head_link (&renditions_lru, &r->lru_link);
+			return r->pixbuf;
+		}
+	}
+
+	size = (gsize) width * height * gdk_pixbuf_get_n_channels (pixbuf);
+	if (size > HTML_IMAGE_RENDITIONS_BUDGET / 4)
+		return NULL;
+
+	while (renditions_size + size > HTML_IMAGE_RENDITIONS_BUDGET && renditions_lru.tail)
+		rendition_free (renditions_lru.tail->data);
+
+	r = g_new0 (HTMLImageRendition, 1);
+	r->pixbuf = html_gdk_painter_scale_pixbuf (pixbuf, width, height, color);
+	if (!r->pixbuf) {
+		g_free (r);
+		return NULL;
+	}
+
+	r->ip = ip;
+	r->source = g_object_ref (pixbuf);
+	r->width = width;
+	r->height = height;
+	if (color) {
+		r->tinted = TRUE;
+		r->tint = *color;
+	}
+	r->size = size;
+	r->lru_link.data = r;
+
+	ip->renditions = g_slist_prepend (ip->renditions, r);
+	g_queue_push_head_link (&renditions_lru, &r->lru_link);
+	renditions_size += size;
+
+	return r->pixbuf;
+}
+
 static void
 html_image_pointer_start_animation (HTMLImagePointer *ip)
 {
@@ -1316,6 +1432,7 @@ html_image_pointer_new (const gchar *filename, HTMLImageFactory *factory)
 					       (GtkFunction)html_image_pointer_timeout,
 					       retval);
 	retval->animation_timeout = 0;
+	retval->renditions = NULL;
 	return retval;
 }
 
@@ -1359,6 +1476,7 @@ html_image_pointer_ref (HTMLImagePointer *ip)
 static void
 free_image_ptr_data (HTMLImagePointer *ip)
 {
+	html_image_pointer_drop_renditions (ip);
 	if (ip->loader) {
 		gdk_pixbuf_loader_close (ip->loader, NULL);
 		g_object_unref (ip->loader);
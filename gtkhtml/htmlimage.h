@@ -41,6 +41,7 @@ struct _HTMLImagePointer {
 	gint stall;
 	guint stall_timeout;
 	guint animation_timeout;
+	GSList *renditions; /* scaled and tinted copies of the current frame */
 };
 
 #define HTML_IMAGE(x) ((HTMLImage *)(x))
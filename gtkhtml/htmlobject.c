@@ -1085,6 +1085,12 @@ html_object_calc_size (HTMLObject *o, HTMLPainter *painter, GList **changed_objs
 void
 html_object_set_max_width (HTMLObject *o, HTMLPainter *painter, gint max_width)
 {
+	/* clean subtrees already gave the same widths to their children */
+	if (o->max_width == max_width && !(o->change & HTML_CHANGE_SIZE))
+		return;
+
+	if (o->max_width != max_width)
+		o->change |= HTML_CHANGE_SIZE;
 	(* HO_CLASS (o)->set_max_width) (o, painter, max_width);
 }
 
@@ -1122,6 +1128,37 @@ void
 html_object_reset (HTMLObject *o)
 {
 	(* HO_CLASS (o)->reset) (o);
+	/* a reset object is laid out from scratch */
+	o->change |= HTML_CHANGE_SIZE;
+}
+
+/**
+ * html_object_reset_changed:
+ * @o: An HTMLObject.
+ *
+ * Reset only the objects marked with HTML_CHANGE_SIZE.  Vertical clues
+ * without aligned objects are walked down to their changed children,
+ * their clean children keep the sizes computed by the last layout and
+ * are just moved by html_object_calc_size.  Anything else is reset as
+ * a whole.
+ **/
+void
+html_object_reset_changed (HTMLObject *o)
+{
+	HTMLObject *child;
+
+	if (!(o->change & HTML_CHANGE_SIZE))
+		return;
+
+	if (!HTML_IS_CLUEV (o)
+	    || HTML_CLUEV (o)->align_left_list || HTML_CLUEV (o)->align_right_list) {
+		html_object_reset (o);
+		return;
+	}
+
+	for (child = HTML_CLUE (o)->head; child; child = child->next)
+		html_object_reset_changed (child);
+	HTML_CLUE (o)->curr = NULL;
 }
 
 gint
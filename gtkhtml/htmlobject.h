@@ -330,6 +330,7 @@ gint            html_object_get_right_margin      (HTMLObject            *self,
 void            html_object_set_painter           (HTMLObject            *o,
 						   HTMLPainter           *p);
 void            html_object_reset                 (HTMLObject            *o);
+void            html_object_reset_changed         (HTMLObject            *o);
 gboolean        html_object_is_text               (HTMLObject            *object);
 gboolean        html_object_is                    (HTMLObject            *object,
 							HTMLType 			 type);
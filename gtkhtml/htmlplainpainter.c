@@ -61,10 +61,7 @@ draw_background (HTMLPainter *painter,
 	expose.width  = width;
 	expose.height = height;
 
-	clip.x = gdk_painter->x1;
-	clip.width = gdk_painter->x2 - gdk_painter->x1;
-	clip.y = gdk_painter->y1;
-	clip.height = gdk_painter->y2 - gdk_painter->y1;
+	clip = gdk_painter->area;
 
 	if (!gdk_rectangle_intersect (&clip, &expose, &paint))
 		return;
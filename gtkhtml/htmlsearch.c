@@ -36,6 +36,76 @@
 #include "htmlobject.h"
 #include "htmlentity.h"
 #include "htmlengine.h"
+#include "htmltext.h"
+
+struct _RunEntry {
+	HTMLText *text;
+	guint stamp;
+	guint bytes;
+};
+typedef struct _RunEntry RunEntry;
+
+/* upper cases text char by char, like the matching used to compare */
+static gchar *
+fold_text (const gchar *text, guint bytes, guint *folded_bytes, gboolean *shifted)
+{
+	GString *str = g_string_sized_new (bytes + 1);
+	const gchar *p;
+
+	*shifted = FALSE;
+	for (p = text; p < text + bytes; p = g_utf8_next_char (p)) {
+		if (!(*p & 0x80))
+			g_string_append_c (str, g_ascii_toupper (*p));
+		else {
+			gsize len = str->len;
+
+			g_string_append_unichar (str, g_unichar_toupper (g_utf8_get_char (p)));
+			if (str->len - len != g_utf8_next_char (p) - p)
+				*shifted = TRUE;
+		}
+	}
+
+	*folded_bytes = str->len;
+
+	return g_string_free (str, FALSE);
+}
+
+static void
+prepare (HTMLSearch *s)
+{
+	guint i;
+
+	if (s->regex) {
+		g_regex_unref (s->regex);
+		s->regex = NULL;
+	}
+	g_free (s->pattern);
+	s->pattern = NULL;
+	s->pattern_bytes = 0;
+
+	if (s->regular) {
+		GError *error = NULL;
+
+		s->regex = g_regex_new (s->text, G_REGEX_OPTIMIZE | (s->case_sensitive ? 0 : G_REGEX_CASELESS), 0, &error);
+		if (!s->regex) {
+			g_warning ("%s", error->message);
+			g_error_free (error);
+		}
+	} else {
+		gboolean shifted;
+
+		if (s->case_sensitive) {
+			s->pattern = g_strdup (s->text);
+			s->pattern_bytes = s->text_bytes;
+		} else
+			s->pattern = fold_text (s->text, s->text_bytes, &s->pattern_bytes, &shifted);
+
+		for (i = 0; i < 256; i ++)
+			s->shift [i] = s->pattern_bytes;
+		for (i = 0; i + 1 < s->pattern_bytes; i ++)
+			s->shift [(guchar) s->pattern [i]] = s->pattern_bytes - 1 - i;
+	}
+}
 
 static void
 set_text (HTMLSearch *s, const gchar *text)
@@ -76,35 +146,7 @@ html_search_new (HTMLEngine *e, const gchar *text, gboolean case_sensitive, gboo
 	}
 
 	ns->regular = regular;
-	if (regular) {
-#ifdef HAVE_GNU_REGEX
-		const gchar *rv;
-
-		ns->reb = g_new0 (regex_t, 1);
-
-		ns->reb->translate = ns->trans;
-		rv = re_compile_pattern (ns->text, ns->text_bytes, ns->reb);
-		if (rv) {
-			g_warning (rv);
-		}
-#else
-		gint rv_int;
-
-		ns->reb = g_new0 (regex_t, 1);
-
-		rv_int = regcomp (ns->reb, ns->text, (case_sensitive) ? 0 : REG_ICASE);
-		if (rv_int) {
-			gchar buf[1024];
-			if (regerror(rv_int, ns->reb, buf, sizeof(buf))) {
-				g_warning ("%s", buf);
-			} else {
-				g_warning ("regcomp failed, error code %d", rv_int);
-			}
-		}
-#endif
-	} else {
-		ns->reb = NULL;
-	}
+	prepare (ns);
 
 	return ns;
 }
@@ -115,11 +157,13 @@ html_search_destroy (HTMLSearch *search)
 	g_free (search->text);
 	if (search->stack)
 		g_slist_free (search->stack);
-	if (search->reb) {
-		regfree (search->reb);
-		g_free (search->reb);
-	}
-	g_free (search->trans);
+	if (search->regex)
+		g_regex_unref (search->regex);
+	g_free (search->pattern);
+	if (search->run)
+		g_array_free (search->run, TRUE);
+	g_free (search->run_text);
+	g_free (search->run_folded);
 
 	g_free (search);
 }
@@ -160,6 +204,7 @@ html_search_set_text (HTMLSearch *search, const gchar *text)
 {
 	g_free (search->text);
 	set_text (search, text);
+	prepare (search);
 }
 
 void
@@ -168,3 +213,168 @@ html_search_set_forward (HTMLSearch *search, gboolean forward)
 	if (search)
 		search->forward = forward;
 }
+
+/* Returns the concatenated text of texts, given in document order.  The
+   text is kept for the following calls, as long as they search the same
+   objects and their stamps show these were not edited meanwhile. */
+const gchar *
+html_search_get_run_text (HTMLSearch *search, GPtrArray *texts, guint *bytes)
+{
+	gboolean valid;
+	guint i;
+
+	valid = search->run && search->run->len == texts->len;
+	for (i = 0; valid && i < texts->len; i ++) {
+		RunEntry *entry = &g_array_index (search->run, RunEntry, i);
+		HTMLText *text = HTML_TEXT (g_ptr_array_index (texts, i));
+
+		valid = entry->text == text && entry->stamp == text->stamp;
+	}
+
+	if (!valid) {
+		gchar *p;
+
+		if (!search->run)
+			search->run = g_array_new (FALSE, FALSE, sizeof (RunEntry));
+		g_array_set_size (search->run, texts->len);
+		g_free (search->run_text);
+		g_free (search->run_folded);
+		search->run_folded = NULL;
+
+		search->run_bytes = 0;
+		for (i = 0; i < texts->len; i ++) {
+			RunEntry *entry = &g_array_index (search->run, RunEntry, i);
+			HTMLText *text = HTML_TEXT (g_ptr_array_index (texts, i));
+
+			entry->text  = text;
+			entry->stamp = text->stamp;
+			entry->bytes = text->text_bytes;
+			search->run_bytes += text->text_bytes;
+		}
+
+		p = search->run_text = g_new (gchar, search->run_bytes + 1);
+		for (i = 0; i < texts->len; i ++) {
+			RunEntry *entry = &g_array_index (search->run, RunEntry, i);
+
+			memcpy (p, entry->text->text, entry->bytes);
+			p += entry->bytes;
+		}
+		*p = 0;
+
+		if (!search->case_sensitive && !search->regular)
+			search->run_folded = fold_text (search->run_text, search->run_bytes,
+							&search->run_folded_bytes, &search->run_shifted);
+	}
+
+	*bytes = search->run_bytes;
+
+	return search->run_text;
+}
+
+/* byte index conversion between the run text and its folded copy */
+static guint
+to_folded (HTMLSearch *search, guint index)
+{
+	if (!search->run_folded || !search->run_shifted)
+		return index;
+
+	return g_utf8_offset_to_pointer (search->run_folded, g_utf8_pointer_to_offset (search->run_text, search->run_text + index))
+		- search->run_folded;
+}
+
+static guint
+from_folded (HTMLSearch *search, guint index)
+{
+	if (!search->run_folded || !search->run_shifted)
+		return index;
+
+	return g_utf8_offset_to_pointer (search->run_text, g_utf8_pointer_to_offset (search->run_folded, search->run_folded + index))
+		- search->run_text;
+}
+
+static gint
+find_pattern (HTMLSearch *search, const gchar *haystack, guint bytes, guint from)
+{
+	const guchar *h = (const guchar *) haystack;
+	const guchar *p = (const guchar *) search->pattern;
+	guint m = search->pattern_bytes;
+	guint i = from;
+
+	if (m == 0)
+		return -1;
+
+	while (i + m <= bytes) {
+		guchar last = h [i + m - 1];
+
+		if (last == p [m - 1] && !memcmp (h + i, p, m - 1))
+			return i;
+		i += search->shift [last];
+	}
+
+	return -1;
+}
+
+static gboolean
+match_regex (HTMLSearch *search, gint index, guint limit, guint *match_index, guint *match_bytes)
+{
+	GMatchInfo *info = NULL;
+	gboolean found = FALSE;
+	gint start, end;
+
+	g_regex_match_full (search->regex, search->run_text, search->forward ? search->run_bytes : limit,
+			    search->forward ? index : 0, 0, &info, NULL);
+	while (g_match_info_matches (info)) {
+		g_match_info_fetch_pos (info, 0, &start, &end);
+		if (!search->forward && start > index)
+			break;
+		if (end > start) {
+			*match_index = start;
+			*match_bytes = end - start;
+			found = TRUE;
+			if (search->forward)
+				break;
+		}
+		g_match_info_next (info, NULL);
+	}
+	g_match_info_free (info);
+
+	return found;
+}
+
+/* Looks for the searched text in the run text.  Forward it finds the
+   first match starting at index or later, backward the last one starting
+   at index or earlier and ending before limit. */
+gboolean
+html_search_match (HTMLSearch *search, gint index, guint limit, guint *match_index, guint *match_bytes)
+{
+	const gchar *haystack;
+	guint bytes;
+	gint found, last = -1;
+
+	if (search->regular)
+		return search->regex && match_regex (search, index, limit, match_index, match_bytes);
+
+	haystack = search->run_folded ? search->run_folded : search->run_text;
+	bytes    = search->run_folded ? search->run_folded_bytes : search->run_bytes;
+
+	if (search->forward)
+		last = find_pattern (search, haystack, bytes, to_folded (search, index));
+	else {
+		guint folded_index = to_folded (search, index);
+		guint folded_limit = to_folded (search, limit);
+
+		found = find_pattern (search, haystack, folded_limit, 0);
+		while (found >= 0 && found <= folded_index) {
+			last = found;
+			found = find_pattern (search, haystack, folded_limit, found + 1);
+		}
+	}
+
+	if (last < 0)
+		return FALSE;
+
+	*match_index = from_folded (search, last);
+	*match_bytes = from_folded (search, last + search->pattern_bytes) - *match_index;
+
+	return TRUE;
+}
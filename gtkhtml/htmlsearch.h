@@ -23,13 +23,11 @@
 #ifndef _HTML_SEARCH_H_
 #define _HTML_SEARCH_H_
 
-#include <sys/types.h>
-#include <regex.h>
+#include <glib.h>
 #include "htmltypes.h"
 
 struct _HTMLSearch {
 	HTMLEngine *engine;
-	gchar *trans;
 	gchar *text;
 	guint  text_bytes;
 	guint  found_bytes;
@@ -45,7 +43,22 @@ struct _HTMLSearch {
 	gint start_pos;
 	gint stop_pos;
 
-	regex_t *reb;        /* regex buffer */
+	GRegex *regex;
+
+	/* literal search: the text upper cased unless case_sensitive
+	   and its Boyer-Moore-Horspool shift table */
+	gchar *pattern;
+	guint  pattern_bytes;
+	guint  shift [256];
+
+	/* text of the last searched run of text objects and its upper
+	   cased copy, reused while the objects are unchanged */
+	GArray *run;
+	gchar  *run_text;
+	guint   run_bytes;
+	gchar  *run_folded;
+	guint   run_folded_bytes;
+	gboolean run_shifted;   /* folding changed byte offsets */
 };
 
 HTMLSearch      *html_search_new            (HTMLEngine *e,
@@ -62,4 +75,12 @@ void             html_search_set_text       (HTMLSearch *search,
 					     const gchar *text);
 void             html_search_set_forward    (HTMLSearch *search,
 					     gboolean    forward);
+const gchar     *html_search_get_run_text   (HTMLSearch *search,
+					     GPtrArray  *texts,
+					     guint      *bytes);
+gboolean         html_search_match          (HTMLSearch *search,
+					     gint        index,
+					     guint       limit,
+					     guint      *match_index,
+					     guint      *match_bytes);
 #endif
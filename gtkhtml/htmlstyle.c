@@ -141,11 +141,15 @@ parse_length (const gchar *str) {
 	return len;
 }
 
+/* styles equal to an interned one share it, see html_style_intern */
+static GHashTable *interned_styles = NULL;
+
 HTMLStyle *
 html_style_new (void)
 {
 	HTMLStyle *style = g_new0 (HTMLStyle, 1);
 
+	style->ref_count = 1;
 	style->display = HTMLDISPLAY_NONE;
 
 	style->color = NULL;
@@ -168,19 +172,15 @@ html_style_new (void)
 	return style;
 }
 
-HTMLStyle *
-html_style_copy(HTMLStyle *orig)
+static HTMLStyle *
+html_style_dup (HTMLStyle *orig)
 {
 	HTMLStyle *style;
 
-	if (!orig)
-		return NULL;
 	style = g_new0 (HTMLStyle, 1);
-	style->color = html_color_copy(orig->color);
-
-	if (orig->face)
-		style->face = g_strdup(orig->face);
-
+	style->ref_count = 1;
+	style->color = html_color_copy (orig->color);
+	style->face = g_strdup (orig->face);
 	style->settings = orig->settings;
 	style->mask = orig->mask;
 
@@ -189,41 +189,97 @@ html_style_copy(HTMLStyle *orig)
 	style->clear = orig->clear;
 	style->dir = orig->dir;
 	style->listtype = orig->listtype;
+	style->listnumber = orig->listnumber;
 
 	/* Cell Level */
 	style->text_valign = orig->text_valign;
 
 	/* box settings */
-	orig->width = html_length_copy(orig->width);
-	orig->height = html_length_copy(orig->height);
-
-	if(orig->bg_image)
-		style->bg_image = g_strdup(orig->bg_image);
-
-	style->bg_color = html_color_copy(orig->bg_color);
+	style->width = html_length_copy (orig->width);
+	style->height = html_length_copy (orig->height);
+	style->bg_image = g_strdup (orig->bg_image);
+	style->bg_color = html_color_copy (orig->bg_color);
 	style->display = orig->display;
-	style->listnumber = 0;
-	style->listtype = HTML_LIST_TYPE_BLOCKQUOTE;
 
 	/* border */
 	style->border_width = orig->border_width;
 	style->border_style = orig->border_style;
-	style->border_color = html_color_copy(orig->border_color);
+	style->border_color = html_color_copy (orig->border_color);
 	style->padding = orig->padding;
 	/*url*/
-	if (orig->url)
-		style->url = g_strdup(orig->url);
-	if (orig->target)
-		style->url = g_strdup(orig->target);
-	if (orig->href)
-		style->href = g_strdup(orig->href);
+	style->url = g_strdup (orig->url);
+	style->target = g_strdup (orig->target);
+	style->href = g_strdup (orig->href);
 	/*flow*/
 	style->fstyle = orig->fstyle;
 
-	style->leftmargin = style->leftmargin;
-	style->rightmargin = style->rightmargin;
-	style->topmargin = style->topmargin;
-	style->bottommargin = style->bottommargin;
+	style->leftmargin = orig->leftmargin;
+	style->rightmargin = orig->rightmargin;
+	style->topmargin = orig->topmargin;
+	style->bottommargin = orig->bottommargin;
+
+	return style;
+}
+
+HTMLStyle *
+html_style_ref (HTMLStyle *style)
+{
+	if (style)
+		style->ref_count ++;
+
+	return style;
+}
+
+/* returns a style which can be changed in place, a new one when the
+   style is shared or NULL */
+HTMLStyle *
+html_style_writable (HTMLStyle *style)
+{
+	HTMLStyle *copy;
+
+	if (!style)
+		return html_style_new ();
+
+	if (style->ref_count == 1) {
+		if (style->interned) {
+			g_hash_table_remove (interned_styles, style);
+			style->interned = FALSE;
+		}
+		return style;
+	}
+
+	copy = html_style_dup (style);
+	html_style_free (style);
+
+	return copy;
+}
+
+/* inherited style for a child, width, height, margins and the list
+   settings start over */
+HTMLStyle *
+html_style_copy (HTMLStyle *orig)
+{
+	HTMLStyle *style;
+
+	if (!orig)
+		return NULL;
+
+	style = html_style_ref (orig);
+	if (style->width || style->height || style->listnumber || style->listtype != HTML_LIST_TYPE_BLOCKQUOTE
+	    || style->leftmargin || style->rightmargin || style->topmargin || style->bottommargin) {
+		style = html_style_writable (style);
+
+		g_free (style->width);
+		style->width = NULL;
+		g_free (style->height);
+		style->height = NULL;
+		style->listnumber = 0;
+		style->listtype = HTML_LIST_TYPE_BLOCKQUOTE;
+		style->leftmargin = 0;
+		style->rightmargin = 0;
+		style->topmargin = 0;
+		style->bottommargin = 0;
+	}
 
 	return style;
 }
@@ -237,25 +293,32 @@ html_style_copy_onlyinherit(HTMLStyle *orig)
 
 	style = html_style_copy(orig);
 
-	style->border_width = 0;
-	style->border_style = HTML_BORDER_NONE;
-	if (style->border_color)
-		html_color_unref (style->border_color);
-	style->border_color = NULL;
-	style->padding = 0;
-	style->leftmargin = 0;
-	style->rightmargin = 0;
-	style->topmargin = 0;
-	style->bottommargin = 0;
+	if (style->border_width || style->border_style != HTML_BORDER_NONE || style->border_color || style->padding) {
+		style = html_style_writable (style);
+
+		style->border_width = 0;
+		style->border_style = HTML_BORDER_NONE;
+		if (style->border_color)
+			html_color_unref (style->border_color);
+		style->border_color = NULL;
+		style->padding = 0;
+	}
 	return style;
 }
 
+/* drops a reference */
 void
 html_style_free (HTMLStyle *style)
 {
 	if (!style)
 		return;
 
+	if (-- style->ref_count > 0)
+		return;
+
+	if (style->interned)
+		g_hash_table_remove (interned_styles, style);
+
 	g_free (style->face);
 	g_free (style->bg_image);
 	g_free (style->width);
@@ -271,14 +334,107 @@ html_style_free (HTMLStyle *style)
 		html_color_unref (style->border_color);
 	g_free(style->url);
 	g_free(style->target);
+	g_free(style->href);
 	g_free (style);
 }
 
+static guint
+color_hash (HTMLColor *color)
+{
+	return color ? (color->color.red << 16) ^ (color->color.green << 8) ^ color->color.blue : 0;
+}
+
+static gboolean
+length_equal (HTMLLength *a, HTMLLength *b)
+{
+	if (!a || !b)
+		return a == b;
+
+	return a->val == b->val && a->type == b->type;
+}
+
+static guint
+html_style_hash (gconstpointer key)
+{
+	const HTMLStyle *style = key;
+	guint hash;
+
+	hash = style->settings ^ (style->mask << 7) ^ (style->display << 13) ^ (style->fstyle << 17) ^ (style->listtype << 21);
+	hash ^= style->text_align ^ (style->text_valign << 3) ^ (style->padding << 5) ^ (style->border_width << 9);
+	hash = hash * 31 + color_hash (style->color);
+	hash = hash * 31 + color_hash (style->bg_color);
+	if (style->face)
+		hash = hash * 31 + g_str_hash (style->face);
+	if (style->href)
+		hash = hash * 31 + g_str_hash (style->href);
+
+	return hash;
+}
+
+static gboolean
+html_style_equal (gconstpointer a, gconstpointer b)
+{
+	const HTMLStyle *s1 = a, *s2 = b;
+
+	return s1->settings == s2->settings
+		&& s1->mask == s2->mask
+		&& s1->text_align == s2->text_align
+		&& s1->clear == s2->clear
+		&& s1->dir == s2->dir
+		&& s1->listtype == s2->listtype
+		&& s1->listnumber == s2->listnumber
+		&& s1->text_valign == s2->text_valign
+		&& s1->display == s2->display
+		&& s1->border_width == s2->border_width
+		&& s1->border_style == s2->border_style
+		&& s1->padding == s2->padding
+		&& s1->fstyle == s2->fstyle
+		&& s1->leftmargin == s2->leftmargin
+		&& s1->rightmargin == s2->rightmargin
+		&& s1->topmargin == s2->topmargin
+		&& s1->bottommargin == s2->bottommargin
+		&& html_color_equal (s1->color, s2->color)
+		&& html_color_equal (s1->bg_color, s2->bg_color)
+		&& html_color_equal (s1->border_color, s2->border_color)
+		&& length_equal (s1->width, s2->width)
+		&& length_equal (s1->height, s2->height)
+		&& !g_strcmp0 (s1->face, s2->face)
+		&& !g_strcmp0 (s1->bg_image, s2->bg_image)
+		&& !g_strcmp0 (s1->url, s2->url)
+		&& !g_strcmp0 (s1->target, s2->target)
+		&& !g_strcmp0 (s1->href, s2->href);
+}
+
+/* takes over the reference and returns the shared instance equal to
+   the style, the interned styles are changed only by copying them */
+HTMLStyle *
+html_style_intern (HTMLStyle *style)
+{
+	HTMLStyle *shared;
+
+	if (!style || style->interned)
+		return style;
+
+	if (!interned_styles)
+		interned_styles = g_hash_table_new (html_style_hash, html_style_equal);
+
+	shared = g_hash_table_lookup (interned_styles, style);
+	if (shared) {
+		html_style_ref (shared);
+		html_style_free (style);
+		return shared;
+	}
+
+	g_hash_table_insert (interned_styles, style, style);
+	style->interned = TRUE;
+
+	return style;
+}
+
 HTMLStyle *
 html_style_set_flow_style (HTMLStyle *style, HTMLClueFlowStyle value)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 	style->fstyle = value;
 	return style;
 }
@@ -286,8 +442,7 @@ html_style_set_flow_style (HTMLStyle *style, HTMLClueFlowStyle value)
 HTMLStyle *
 html_style_set_list_type (HTMLStyle *style, HTMLListType value)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 	style->listtype = value;
 	return style;
 }
@@ -321,8 +476,7 @@ html_style_add_color (HTMLStyle *style, HTMLColor *color)
 {
 	HTMLColor *old;
 
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	old = style->color;
 
@@ -342,8 +496,7 @@ html_style_add_dir (HTMLStyle *style, const gchar* dir_text)
 {
 	if (dir_text) {
 
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 
 		if (!g_ascii_strncasecmp (dir_text, "ltr", 3))
 			style->dir = HTML_DIRECTION_LTR;
@@ -383,8 +536,7 @@ parse_valign (const gchar *token, HTMLVAlignType default_val)
 HTMLStyle *
 html_style_unset_decoration (HTMLStyle *style, GtkHTMLFontStyle font_style)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	font_style &= ~GTK_HTML_FONT_STYLE_SIZE_MASK;
 	style->mask |= font_style;
@@ -396,8 +548,7 @@ html_style_unset_decoration (HTMLStyle *style, GtkHTMLFontStyle font_style)
 HTMLStyle *
 html_style_set_decoration (HTMLStyle *style, GtkHTMLFontStyle font_style)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	font_style &= ~GTK_HTML_FONT_STYLE_SIZE_MASK;
 	style->mask |= font_style;
@@ -409,8 +560,7 @@ html_style_set_decoration (HTMLStyle *style, GtkHTMLFontStyle font_style)
 HTMLStyle *
 html_style_set_font_size (HTMLStyle *style, GtkHTMLFontStyle font_style)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	font_style &= GTK_HTML_FONT_STYLE_SIZE_MASK;
 	style->mask |= GTK_HTML_FONT_STYLE_SIZE_MASK;
@@ -422,8 +572,7 @@ html_style_set_font_size (HTMLStyle *style, GtkHTMLFontStyle font_style)
 HTMLStyle *
 html_style_add_font_face (HTMLStyle *style, const HTMLFontFace *face)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	g_free (style->face);
 	style->face = g_strdup (face);
@@ -434,8 +583,7 @@ html_style_add_font_face (HTMLStyle *style, const HTMLFontFace *face)
 HTMLStyle *
 html_style_add_text_align (HTMLStyle *style, HTMLHAlignType type)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	style->text_align = type;
 
@@ -445,8 +593,7 @@ html_style_add_text_align (HTMLStyle *style, HTMLHAlignType type)
 HTMLStyle *
 html_style_add_text_valign (HTMLStyle *style, HTMLVAlignType type)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	style->text_valign = type;
 
@@ -458,8 +605,7 @@ html_style_add_background_color (HTMLStyle *style, HTMLColor *color)
 {
 	HTMLColor *old;
 
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	old = style->bg_color;
 
@@ -477,8 +623,7 @@ html_style_add_background_color (HTMLStyle *style, HTMLColor *color)
 HTMLStyle *
 html_style_set_display (HTMLStyle *style, HTMLDisplayType display)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	style->display = display;
 
@@ -488,8 +633,7 @@ html_style_set_display (HTMLStyle *style, HTMLDisplayType display)
 HTMLStyle *
 html_style_set_clear (HTMLStyle *style, HTMLClearType clear)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	style->clear = clear;
 
@@ -499,8 +643,7 @@ html_style_set_clear (HTMLStyle *style, HTMLClearType clear)
 HTMLStyle *
 html_style_add_width (HTMLStyle *style,const gchar *len)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	g_free (style->width);
 
@@ -512,8 +655,7 @@ html_style_add_width (HTMLStyle *style,const gchar *len)
 HTMLStyle *
 html_style_add_height (HTMLStyle *style,const gchar *len)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	g_free (style->height);
 
@@ -525,8 +667,7 @@ html_style_add_height (HTMLStyle *style,const gchar *len)
 HTMLStyle *
 html_style_add_background_image (HTMLStyle *style, const gchar *url)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	g_free (style->bg_image);
 	style->bg_image = g_strdup (url);
@@ -537,8 +678,7 @@ html_style_add_background_image (HTMLStyle *style, const gchar *url)
 HTMLStyle *
 html_style_set_border_style (HTMLStyle *style, HTMLBorderStyle bstyle)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	style->border_style = bstyle;
 
@@ -548,8 +688,7 @@ html_style_set_border_style (HTMLStyle *style, HTMLBorderStyle bstyle)
 HTMLStyle *
 html_style_set_border_width (HTMLStyle *style, gint width)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	style->border_width = width;
 
@@ -559,8 +698,7 @@ html_style_set_border_width (HTMLStyle *style, gint width)
 HTMLStyle *
 html_style_set_padding (HTMLStyle *style, gint padding)
 {
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	style->padding = padding;
 
@@ -572,8 +710,7 @@ html_style_set_border_color (HTMLStyle *style, HTMLColor *color)
 {
 	HTMLColor *old;
 
-	if (!style)
-		style = html_style_new ();
+	style = html_style_writable (style);
 
 	old = style->border_color;
 
@@ -783,48 +920,39 @@ html_style_add_styleattribute (HTMLStyle *style, const gchar *attr, const gchar
 			style = html_style_set_clear (style, HTML_CLEAR_NONE);
 		}
 	} else if (!g_ascii_strcasecmp ("href", attr)) { /*a*/
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		if (style->href)
 			g_free (style->href);
 		style->href = g_strdup(value);
 	} else if (!g_ascii_strcasecmp ("src", attr)) { /*iframe, frame, img*/
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		if (style->url)
 			g_free (style->url);
 		style->url = g_strdup(value);
 	} else if (!g_ascii_strcasecmp ("target", attr)) {
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		if (style->target)
 			g_free (style->target);
 		style->target = g_strdup(value);
 	} else if ( !g_ascii_strcasecmp ("list-style-type", attr)) {
 		style = parse_list_type (style, value);
 	} else if (!g_ascii_strcasecmp ("leftmargin", attr)) {
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		style->leftmargin = atoi (value);
 	} else if (!g_ascii_strcasecmp ("rightmargin", attr)) {
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		style->rightmargin = atoi (value);
 	} else if (!g_ascii_strcasecmp ("topmargin", attr)) {
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		style->topmargin = atoi (value);
 	} else if (!g_ascii_strcasecmp ("bottommargin", attr)) {
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		style->bottommargin = atoi (value);
 	} else if (!g_ascii_strcasecmp ("marginwidth", attr)) {
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		style->leftmargin = style->rightmargin = atoi (value);
 	} else if (!g_ascii_strcasecmp ("marginheight", attr)) {
-		if (!style)
-			style = html_style_new ();
+		style = html_style_writable (style);
 		style->topmargin = style->bottommargin = atoi (value);
 	}
 	return style;
@@ -68,10 +68,18 @@ struct _HTMLStyle {
 	HTMLClueFlowStyle fstyle;
 
 	gint leftmargin, rightmargin, topmargin, bottommargin;
+
+	/* styles are shared, change them only through the setters or
+	   after html_style_writable */
+	gint ref_count;
+	gboolean interned;
 };
 
 HTMLStyle *html_style_new                  (void);
-/*copy all fields*/
+HTMLStyle *html_style_ref                  (HTMLStyle *style);
+HTMLStyle *html_style_writable             (HTMLStyle *style);
+HTMLStyle *html_style_intern               (HTMLStyle *style);
+/*copy inherited fields, shares the style when nothing is reset*/
 HTMLStyle *html_style_copy                 (HTMLStyle *style);
 /*copy only inherit */
 HTMLStyle *html_style_copy_onlyinherit     (HTMLStyle *orig);
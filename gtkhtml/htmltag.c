@@ -0,0 +1,309 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/* htmltag.c, generated from htmltag.gperf
+ *
+ * This file is part of the GtkHTML library.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include <glib.h>
+#include "htmltag.h"
+
+/* the lookup function gperf 3.0 generates */
+struct _TagEntry;
+const struct _TagEntry *html_tag_hash (const char *str, unsigned int len);
+
+struct _TagEntry {
+	const gchar *name;
+	HTMLTagId id;
+};
+
+#define TOTAL_KEYWORDS 75
+#define MIN_WORD_LENGTH 1
+#define MAX_WORD_LENGTH 10
+#define MIN_HASH_VALUE 2
+#define MAX_HASH_VALUE 131
+
+static unsigned char gperf_downcase[256] =
+  {
+        0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+       15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,
+       30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,
+       45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,
+       60,  61,  62,  63,  64,  97,  98,  99, 100, 101, 102, 103, 104, 105, 106,
+      107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121,
+      122,  91,  92,  93,  94,  95,  96,  97,  98,  99, 100, 101, 102, 103, 104,
+      105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117, 118, 119,
+      120, 121, 122, 123, 124, 125, 126, 127, 128, 129, 130, 131, 132, 133, 134,
+      135, 136, 137, 138, 139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 149,
+      150, 151, 152, 153, 154, 155, 156, 157, 158, 159, 160, 161, 162, 163, 164,
+      165, 166, 167, 168, 169, 170, 171, 172, 173, 174, 175, 176, 177, 178, 179,
+      180, 181, 182, 183, 184, 185, 186, 187, 188, 189, 190, 191, 192, 193, 194,
+      195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208, 209,
+      210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222, 223, 224,
+      225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239,
+      240, 241, 242, 243, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253, 254,
+      255
+  };
+
+static int
+gperf_case_strncmp (register const char *s1, register const char *s2, register unsigned int n)
+{
+  for (; n > 0;)
+    {
+      unsigned char c1 = gperf_downcase[(unsigned char)*s1++];
+      unsigned char c2 = gperf_downcase[(unsigned char)*s2++];
+      if (c1 != 0 && c1 == c2)
+        {
+          n--;
+          continue;
+        }
+      return (int)c1 - (int)c2;
+    }
+  return 0;
+}
+
+static unsigned int
+hash (register const char *str, register unsigned int len)
+{
+  static const unsigned short asso_values[] =
+    {
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132,   8,
+        2,  12,  21,  11,  38, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132,  39,   3,  25,   0,  16,
+       37,  33,  17,   5,   5,   4,   1,  38,  30,  30,
+       13, 132,   6,   1,  28,  35,   5, 132,  40,   1,
+      132, 132, 132, 132, 132, 132, 132,  39,   3,  25,
+        0,  16,  37,  33,  17,   5,   5,   4,   1,  38,
+       30,  30,  13, 132,   6,   1,  28,  35,   5, 132,
+       40,   1, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132, 132, 132, 132, 132,
+      132, 132, 132, 132, 132, 132
+    };
+  register int hval = len;
+
+  switch (hval)
+    {
+      default:
+        hval += asso_values[(unsigned char)str[2]];
+      /*FALLTHROUGH*/
+      case 2:
+        hval += asso_values[(unsigned char)str[1]];
+      /*FALLTHROUGH*/
+      case 1:
+        break;
+    }
+  return hval + asso_values[(unsigned char)str[len - 1]] + asso_values[(unsigned char)str[0]];
+}
+
+const struct _TagEntry *
+html_tag_hash (register const char *str, register unsigned int len)
+{
+  static const unsigned char lengthtable[] =
+    {
+       0,  0,  2,  1,  2,  0,  0,  1,  0,  0,  3,  1,  0,  2,  0,
+       0,  0,  2,  3,  0,  3,  0,  0,  2,  0,  0,  0,  1,  0,  0,
+       2,  2,  0,  0,  2,  2,  0,  0,  4,  2,  0,  2,  2,  2,  4,
+       3,  0,  7,  0,  5,  0,  5,  6,  0,  3,  0,  0,  6,  2,  3,
+      10,  2,  0,  4,  2,  3,  6,  5,  0,  0,  6,  1,  6,  4,  6,
+       4,  4,  3,  4,  1,  0,  5,  5,  6,  5,  0,  2,  4,  4,  0,
+       0,  5,  0,  0,  2,  2,  0,  8,  0,  0,  0,  5,  0,  5,  4,
+       0,  3,  6,  0,  0,  4,  0,  3,  0,  7,  4,  4,  0,  8,  0,
+       7,  0,  0,  4,  0,  4,  0,  0,  0,  4,  0,  8
+    };
+  static const struct _TagEntry wordlist[] =
+    {
+      {""},
+      {""},
+      {"dd", HTML_TAG_DD},
+      {"s", HTML_TAG_S},
+      {"dl", HTML_TAG_DL},
+      {""},
+      {""},
+      {"b", HTML_TAG_B},
+      {""},
+      {""},
+      {"kbd", HTML_TAG_KBD},
+      {"i", HTML_TAG_I},
+      {""},
+      {"li", HTML_TAG_LI},
+      {""},
+      {""},
+      {""},
+      {"br", HTML_TAG_BR},
+      {"div", HTML_TAG_DIV},
+      {""},
+      {"dir", HTML_TAG_DIR},
+      {""},
+      {""},
+      {"h2", HTML_TAG_H2},
+      {""},
+      {""},
+      {""},
+      {"p", HTML_TAG_P},
+      {""},
+      {""},
+      {"td", HTML_TAG_TD},
+      {"hr", HTML_TAG_HR},
+      {""},
+      {""},
+      {"ol", HTML_TAG_OL},
+      {"h1", HTML_TAG_H1},
+      {""},
+      {""},
+      {"body", HTML_TAG_BODY},
+      {"ul", HTML_TAG_UL},
+      {""},
+      {"h5", HTML_TAG_H5},
+      {"tr", HTML_TAG_TR},
+      {"h3", HTML_TAG_H3},
+      {"link", HTML_TAG_LINK},
+      {"sub", HTML_TAG_SUB},
+      {""},
+      {"address", HTML_TAG_ADDRESS},
+      {""},
+      {"label", HTML_TAG_LABEL},
+      {""},
+      {"style", HTML_TAG_STYLE},
+      {"select", HTML_TAG_SELECT},
+      {""},
+      {"pre", HTML_TAG_PRE},
+      {""},
+      {""},
+      {"strike", HTML_TAG_STRIKE},
+      {"dt", HTML_TAG_DT},
+      {"var", HTML_TAG_VAR},
+      {"blockquote", HTML_TAG_BLOCKQUOTE},
+      {"h4", HTML_TAG_H4},
+      {""},
+      {"base", HTML_TAG_BASE},
+      {"th", HTML_TAG_TH},
+      {"sup", HTML_TAG_SUP},
+      {"script", HTML_TAG_SCRIPT},
+      {"tbody", HTML_TAG_TBODY},
+      {""},
+      {""},
+      {"iframe", HTML_TAG_IFRAME},
+      {"u", HTML_TAG_U},
+      {"object", HTML_TAG_OBJECT},
+      {"nobr", HTML_TAG_NOBR},
+      {"strong", HTML_TAG_STRONG},
+      {"code", HTML_TAG_CODE},
+      {"head", HTML_TAG_HEAD},
+      {"big", HTML_TAG_BIG},
+      {"cite", HTML_TAG_CITE},
+      {"a", HTML_TAG_A},
+      {""},
+      {"input", HTML_TAG_INPUT},
+      {"title", HTML_TAG_TITLE},
+      {"center", HTML_TAG_CENTER},
+      {"small", HTML_TAG_SMALL},
+      {""},
+      {"tt", HTML_TAG_TT},
+      {"span", HTML_TAG_SPAN},
+      {"html", HTML_TAG_HTML},
+      {""},
+      {""},
+      {"table", HTML_TAG_TABLE},
+      {""},
+      {""},
+      {"em", HTML_TAG_EM},
+      {"h6", HTML_TAG_H6},
+      {""},
+      {"noscript", HTML_TAG_NOSCRIPT},
+      {""},
+      {""},
+      {""},
+      {"param", HTML_TAG_PARAM},
+      {""},
+      {"frame", HTML_TAG_FRAME},
+      {"area", HTML_TAG_AREA},
+      {""},
+      {"map", HTML_TAG_MAP},
+      {"option", HTML_TAG_OPTION},
+      {""},
+      {""},
+      {"data", HTML_TAG_DATA},
+      {""},
+      {"img", HTML_TAG_IMG},
+      {""},
+      {"caption", HTML_TAG_CAPTION},
+      {"form", HTML_TAG_FORM},
+      {"text", HTML_TAG_TEXT},
+      {""},
+      {"frameset", HTML_TAG_FRAMESET},
+      {""},
+      {"noframe", HTML_TAG_NOFRAME},
+      {""},
+      {""},
+      {"menu", HTML_TAG_MENU},
+      {""},
+      {"meta", HTML_TAG_META},
+      {""},
+      {""},
+      {""},
+      {"font", HTML_TAG_FONT},
+      {""},
+      {"textarea", HTML_TAG_TEXTAREA}
+    };
+
+  if (len <= MAX_WORD_LENGTH && len >= MIN_WORD_LENGTH)
+    {
+      register int key = hash (str, len);
+
+      if (key <= MAX_HASH_VALUE && key >= 0)
+        if (len == lengthtable[key])
+          {
+            register const char *s = wordlist[key].name;
+
+            if ((((unsigned char)*str ^ (unsigned char)*s) & ~32) == 0 && !gperf_case_strncmp (str, s, len))
+              return &wordlist[key];
+          }
+    }
+  return 0;
+}
+
+HTMLTagId
+html_tag_lookup (const gchar *name, guint len)
+{
+	const struct _TagEntry *result;
+
+	if (name == NULL)
+		return HTML_TAG_UNKNOWN;
+
+	result = html_tag_hash (name, len);
+	if (result == NULL)
+		return HTML_TAG_UNKNOWN;
+	return result->id;
+}
+
@@ -0,0 +1,109 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/* htmltag.h
+ *
+ * This file is part of the GtkHTML library.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _HTMLTAG_H
+#define _HTMLTAG_H
+
+#include <glib.h>
+
+/* tags known to the engine, text nodes are named "text" by libxml */
+typedef enum {
+	HTML_TAG_UNKNOWN,
+	HTML_TAG_A,
+	HTML_TAG_ADDRESS,
+	HTML_TAG_AREA,
+	HTML_TAG_B,
+	HTML_TAG_BASE,
+	HTML_TAG_BIG,
+	HTML_TAG_BLOCKQUOTE,
+	HTML_TAG_BODY,
+	HTML_TAG_BR,
+	HTML_TAG_CAPTION,
+	HTML_TAG_CENTER,
+	HTML_TAG_CITE,
+	HTML_TAG_CODE,
+	HTML_TAG_DATA,
+	HTML_TAG_DD,
+	HTML_TAG_DIR,
+	HTML_TAG_DIV,
+	HTML_TAG_DL,
+	HTML_TAG_DT,
+	HTML_TAG_EM,
+	HTML_TAG_FONT,
+	HTML_TAG_FORM,
+	HTML_TAG_FRAME,
+	HTML_TAG_FRAMESET,
+	HTML_TAG_H1,
+	HTML_TAG_H2,
+	HTML_TAG_H3,
+	HTML_TAG_H4,
+	HTML_TAG_H5,
+	HTML_TAG_H6,
+	HTML_TAG_HEAD,
+	HTML_TAG_HR,
+	HTML_TAG_HTML,
+	HTML_TAG_I,
+	HTML_TAG_IFRAME,
+	HTML_TAG_IMG,
+	HTML_TAG_INPUT,
+	HTML_TAG_KBD,
+	HTML_TAG_LABEL,
+	HTML_TAG_LI,
+	HTML_TAG_LINK,
+	HTML_TAG_MAP,
+	HTML_TAG_MENU,
+	HTML_TAG_META,
+	HTML_TAG_NOBR,
+	HTML_TAG_NOFRAME,
+	HTML_TAG_NOSCRIPT,
+	HTML_TAG_OBJECT,
+	HTML_TAG_OL,
+	HTML_TAG_OPTION,
+	HTML_TAG_P,
+	HTML_TAG_PARAM,
+	HTML_TAG_PRE,
+	HTML_TAG_S,
+	HTML_TAG_SCRIPT,
+	HTML_TAG_SELECT,
+	HTML_TAG_SMALL,
+	HTML_TAG_SPAN,
+	HTML_TAG_STRIKE,
+	HTML_TAG_STRONG,
+	HTML_TAG_STYLE,
+	HTML_TAG_SUB,
+	HTML_TAG_SUP,
+	HTML_TAG_TABLE,
+	HTML_TAG_TBODY,
+	HTML_TAG_TD,
+	HTML_TAG_TEXT,
+	HTML_TAG_TEXTAREA,
+	HTML_TAG_TH,
+	HTML_TAG_TITLE,
+	HTML_TAG_TR,
+	HTML_TAG_TT,
+	HTML_TAG_U,
+	HTML_TAG_UL,
+	HTML_TAG_VAR,
+	HTML_TAG_LAST
+} HTMLTagId;
+
+HTMLTagId html_tag_lookup (const gchar *name, guint len);
+
+#endif
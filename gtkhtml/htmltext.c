@@ -25,7 +25,6 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
-#include <regex.h>
 #include <math.h>
 
 #define PANGO_ENABLE_BACKEND /* Required to get PANGO_GLYPH_EMPTY */
@@ -45,6 +44,7 @@
 #include "htmlengine-edit.h"
 #include "htmlengine-edit-cut-and-paste.h"
 #include "htmlengine-save.h"
+#include "htmlengine-search.h"
 #include "htmlentity.h"
 #include "htmlsettings.h"
 #include "htmltextslave.h"
@@ -62,18 +62,18 @@ static const PangoAttrClass html_pango_attr_font_size_klass;
 #define EMPTY_GLYPH 0
 #endif
 
-static SpellError * spell_error_new         (guint off, guint len);
-static void         spell_error_destroy     (SpellError *se);
-static void         move_spell_errors       (GList *spell_errors, guint offset, gint delta);
-static GList *      remove_spell_errors     (GList *spell_errors, guint offset, guint len);
-static GList *      merge_spell_errors      (GList *se1, GList *se2);
+static void         move_spell_errors       (GArray *spell_errors, guint offset, gint delta);
+static void         remove_spell_errors     (GArray *spell_errors, guint offset, guint len);
+static GArray *     merge_spell_errors      (GArray *se1, GArray *se2);
 static void         remove_text_slaves      (HTMLObject *self);
 
 /* void
-debug_spell_errors (GList *se)
+debug_spell_errors (GArray *se)
 {
-	for (;se;se = se->next)
-		printf ("SE: %4d, %4d\n", ((SpellError *) se->data)->off, ((SpellError *) se->data)->len);
+	guint i;
+
+	for (i = 0; se && i < se->len; i ++)
+		printf ("SE: %4d, %4d\n", g_array_index (se, SpellError, i).off, g_array_index (se, SpellError, i).len);
 } */
 
 static inline gboolean
@@ -96,15 +96,28 @@ html_text_pango_info_new (gint n)
 	pi->have_font = FALSE;
 	pi->font_style = GTK_HTML_FONT_STYLE_DEFAULT;
 	pi->face = NULL;
+	pi->ref_count = 1;
 
 	return pi;
 }
 
+HTMLTextPangoInfo *
+html_text_pango_info_ref (HTMLTextPangoInfo *pi)
+{
+	pi->ref_count ++;
+
+	return pi;
+}
+
+/* drops a reference, the info is freed with the last one */
 void
 html_text_pango_info_destroy (HTMLTextPangoInfo *pi)
 {
 	gint i;
 
+	if (-- pi->ref_count > 0)
+		return;
+
 	for (i = 0; i < pi->n; i ++) {
 		pango_item_free (pi->entries [i].glyph_item.item);
 		if (pi->entries [i].glyph_item.glyphs)
@@ -127,14 +140,78 @@ pango_info_destroy (HTMLText *text)
 }
 
 static void
-free_links (GSList *list)
+free_links (GPtrArray *links)
 {
-	if (list) {
-		GSList *l;
+	if (links) {
+		guint i;
+
+		for (i = 0; i < links->len; i ++)
+			html_link_free ((Link *) g_ptr_array_index (links, i));
+		g_ptr_array_free (links, TRUE);
+	}
+}
+
+/* index of the first link starting at or after offset */
+static guint
+links_search (GPtrArray *links, gint offset)
+{
+	guint lo = 0, hi = links->len;
+
+	while (lo < hi) {
+		guint mid = (lo + hi) / 2;
+
+		if (((Link *) g_ptr_array_index (links, mid))->start_offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void
+links_insert (GPtrArray *links, guint i, Link *link)
+{
+	g_ptr_array_add (links, link);
+	if (i < links->len - 1) {
+		memmove (links->pdata + i + 1, links->pdata + i, (links->len - 1 - i) * sizeof (gpointer));
+		links->pdata [i] = link;
+	}
+}
+
+static void
+links_remove_range (GPtrArray *links, guint from, guint to)
+{
+	guint i;
+
+	if (from >= to)
+		return;
+
+	for (i = from; i < to; i ++)
+		html_link_free ((Link *) g_ptr_array_index (links, i));
+	g_ptr_array_remove_range (links, from, to - from);
+}
+
+static void
+links_shift (GPtrArray *links, guint from, gint delta_offset, gint delta_index)
+{
+	for (; from < links->len; from ++) {
+		Link *link = (Link *) g_ptr_array_index (links, from);
+
+		link->start_offset += delta_offset;
+		link->start_index += delta_index;
+		link->end_offset += delta_offset;
+		link->end_index += delta_index;
+	}
+}
 
-		for (l = list; l; l = l->next)
-			html_link_free ((Link *) l->data);
-		g_slist_free (list);
+/* keeps text->links NULL when there are no links left */
+static void
+links_drop_empty (HTMLText *text)
+{
+	if (text->links && text->links->len == 0) {
+		g_ptr_array_free (text->links, TRUE);
+		text->links = NULL;
 	}
 }
 
@@ -156,12 +233,14 @@ copy (HTMLObject *s,
 {
 	HTMLText *src  = HTML_TEXT (s);
 	HTMLText *dest = HTML_TEXT (d);
-	GList *cur;
-	GSList *csl;
+	guint i;
 
 	(* HTML_OBJECT_CLASS (parent_class)->copy) (s, d);
 
 	dest->text = g_strdup (src->text);
+	dest->stamp         = html_text_new_stamp ();
+	dest->offsets       = NULL;
+	dest->text_size     = 0;
 	dest->text_len      = src->text_len;
 	dest->text_bytes    = src->text_bytes;
 	dest->font_style    = src->font_style;
@@ -174,18 +253,18 @@ copy (HTMLObject *s,
 
 	html_color_ref (dest->color);
 
-	dest->spell_errors = g_list_copy (src->spell_errors);
-	cur = dest->spell_errors;
-	while (cur) {
-		SpellError *se = (SpellError *) cur->data;
-		cur->data = spell_error_new (se->off, se->len);
-		cur = cur->next;
+	dest->spell_errors = NULL;
+	if (src->spell_errors && src->spell_errors->len) {
+		dest->spell_errors = g_array_sized_new (FALSE, FALSE, sizeof (SpellError), src->spell_errors->len);
+		g_array_append_vals (dest->spell_errors, src->spell_errors->data, src->spell_errors->len);
 	}
 
-	dest->links = g_slist_copy (src->links);
-
-	for (csl = dest->links; csl; csl = csl->next)
-		csl->data = html_link_dup ((Link *) csl->data);
+	dest->links = NULL;
+	if (src->links) {
+		dest->links = g_ptr_array_sized_new (src->links->len);
+		for (i = 0; i < src->links->len; i ++)
+			g_ptr_array_add (dest->links, html_link_dup ((Link *) g_ptr_array_index (src->links, i)));
+	}
 
 	dest->pi = NULL;
 	dest->direction = src->direction;
@@ -278,16 +357,28 @@ cut_attr_list (HTMLText *text, gint begin_index, gint end_index)
 static void
 cut_links_full (HTMLText *text, gint start_offset, gint end_offset, gint start_index, gint end_index, gint shift_offset, gint shift_index)
 {
-	GSList *l, *next;
-	Link *link;
+	GPtrArray *links = text->links;
+	Link *link, *dup = NULL;
+	guint i, keep, head, tail, dup_at = 0;
+
+	if (!links)
+		return;
 
-	for (l = text->links; l; l = next) {
-		next = l->next;
-		link = (Link *) l->data;
+	/* links are disjoint and sorted, so only the ones from the last link
+	   starting before start_offset up to the ones starting at end_offset
+	   need a closer look, those past end_offset are just moved */
+	head = links_search (links, start_offset);
+	if (head > 0)
+		head --;
+	tail = links_search (links, end_offset + 1);
+	links_shift (links, tail, -shift_offset, -shift_index);
+
+	for (i = keep = head; i < tail; i ++) {
+		link = (Link *) g_ptr_array_index (links, i);
 
 		if (start_offset <= link->start_offset && link->end_offset <= end_offset) {
 			html_link_free (link);
-			text->links = g_slist_delete_link (text->links, l);
+			continue;
 		} else if (end_offset <= link->start_offset) {
 			link->start_offset -= shift_offset;
 			link->start_index -= shift_index;
@@ -310,22 +401,27 @@ cut_links_full (HTMLText *text, gint start_offset, gint end_offset, gint start_i
 					link->start_offset = end_offset;
 					link->start_index = end_index;
 				} else {
-					Link *dup = html_link_dup (link);
+					dup = html_link_dup (link);
 
 					link->start_offset = end_offset;
 					link->start_index = end_index;
 					dup->end_offset = start_offset;
 					dup->end_index = start_index;
-
-					l = g_slist_prepend (l, dup);
-					next = l->next->next;
+					dup_at = keep;
 				}
 			}
 		} else if (start_offset < link->end_offset) {
 			link->end_offset = start_offset;
 			link->end_index = start_index;
 		}
+		links->pdata [keep ++] = link;
 	}
+
+	if (keep < tail)
+		g_ptr_array_remove_range (links, keep, tail - keep);
+	if (dup)
+		links_insert (links, dup_at, dup);
+	links_drop_empty (text);
 }
 
 static void
@@ -358,9 +454,12 @@ html_text_op_copy_helper (HTMLText *text, GList *from, GList *to, guint *len)
 	nt = g_strndup (rvt->text + begin_index, rvt->text_bytes);
 	g_free (rvt->text);
 	rvt->text = nt;
+	rvt->text_size = 0;
+	html_text_changed (rvt);
 
-	rvt->spell_errors = remove_spell_errors (rvt->spell_errors, 0, begin);
-	rvt->spell_errors = remove_spell_errors (rvt->spell_errors, end, text->text_len - end);
+	remove_spell_errors (rvt->spell_errors, 0, begin);
+	remove_spell_errors (rvt->spell_errors, end, text->text_len - end);
+	move_spell_errors (rvt->spell_errors, begin, -begin);
 
 	if (end_index < text->text_bytes)
 		cut_attr_list (rvt, end_index, text->text_bytes);
@@ -387,6 +486,8 @@ html_text_op_cut_helper (HTMLText *text, HTMLEngine *e, GList *from, GList *to,
 	g_assert (begin <= end);
 	g_assert (end <= text->text_len);
 
+	html_engine_search_all_forget (e, HTML_OBJECT (text));
+
 	/* printf ("before cut '%s'\n", text->text);
 	   debug_word_width (text); */
 
@@ -416,31 +517,32 @@ html_text_op_cut_helper (HTMLText *text, HTMLEngine *e, GList *from, GList *to,
 			cut_links (rvt, end, rvt->text_len, end_index, rvt->text_bytes);
 		if (begin > 0)
 			cut_links (rvt, 0, begin, 0, begin_index);
-		nt = g_strconcat (text->text, tail, NULL);
-		g_free (text->text);
+		memmove (text->text + begin_index, tail, strlen (tail) + 1);
 
-		rvt->spell_errors = remove_spell_errors (rvt->spell_errors, 0, begin);
-		rvt->spell_errors = remove_spell_errors (rvt->spell_errors, end, text->text_len - end);
+		remove_spell_errors (rvt->spell_errors, 0, begin);
+		remove_spell_errors (rvt->spell_errors, end, text->text_len - end);
 		move_spell_errors (rvt->spell_errors, begin, -begin);
 
-		text->text = nt;
 		text->text_len -= end - begin;
 		*len           += end - begin;
+		html_text_changed (text);
 
 		nt = g_strndup (rvt->text + begin_index, end_index - begin_index);
 		g_free (rvt->text);
 		rvt->text = nt;
 		rvt->text_len = end - begin;
 		rvt->text_bytes = end_index - begin_index;
+		rvt->text_size = 0;
+		html_text_changed (rvt);
 
-		text->spell_errors = remove_spell_errors (text->spell_errors, begin, end - begin);
+		remove_spell_errors (text->spell_errors, begin, end - begin);
 		move_spell_errors (text->spell_errors, end, - (end - begin));
 
 		html_text_convert_nbsp (text, TRUE);
 		html_text_convert_nbsp (rvt, TRUE);
 		pango_info_destroy (text);
 	} else {
-		text->spell_errors = remove_spell_errors (text->spell_errors, 0, text->text_len);
+		remove_spell_errors (text->spell_errors, 0, text->text_len);
 		html_object_move_cursor_before_remove (HTML_OBJECT (text), e);
 		html_object_change_set (HTML_OBJECT (text)->parent, HTML_CHANGE_ALL_CALC);
 		/* force parent redraw */
@@ -475,31 +577,30 @@ static void
 merge_links (HTMLText *t1, HTMLText *t2)
 {
 	Link *tail, *head;
-	GSList *l;
+	guint first = 0;
 
 	if (t2->links) {
-		for (l = t2->links; l; l = l->next) {
-			Link *link = (Link *) l->data;
+		links_shift (t2->links, 0, t1->text_len, t1->text_bytes);
 
-			link->start_offset += t1->text_len;
-			link->start_index += t1->text_bytes;
-			link->end_offset += t1->text_len;
-			link->end_index += t1->text_bytes;
+		if (!t1->links) {
+			t1->links = t2->links;
+			t2->links = NULL;
+			return;
 		}
 
-		if (t1->links) {
-			head = (Link *) t1->links->data;
-			tail = (Link *) g_slist_last (t2->links)->data;
+		tail = (Link *) g_ptr_array_index (t1->links, t1->links->len - 1);
+		head = (Link *) g_ptr_array_index (t2->links, 0);
 
-			if (tail->start_offset == head->end_offset && html_link_equal (head, tail)) {
-				tail->start_offset = head->start_offset;
-				tail->start_index = head->start_index;
-				html_link_free (head);
-				t1->links = g_slist_delete_link (t1->links, t1->links);
-			}
+		if (head->start_offset == tail->end_offset && html_link_equal (head, tail)) {
+			tail->end_offset = head->end_offset;
+			tail->end_index = head->end_index;
+			html_link_free (head);
+			first = 1;
 		}
 
-		t1->links = g_slist_concat (t2->links, t1->links);
+		for (; first < t2->links->len; first ++)
+			g_ptr_array_add (t1->links, g_ptr_array_index (t2->links, first));
+		g_ptr_array_free (t2->links, TRUE);
 		t2->links = NULL;
 	}
 }
@@ -508,13 +609,15 @@ static gboolean
 object_merge (HTMLObject *self, HTMLObject *with, HTMLEngine *e, GList **left, GList **right, HTMLCursor *cursor)
 {
 	HTMLText *t1, *t2;
-	gchar *to_free;
 
 	t1 = HTML_TEXT (self);
 	t2 = HTML_TEXT (with);
 
 	/* printf ("merge '%s' '%s'\n", t1->text, t2->text); */
 
+	html_engine_search_all_forget (e, self);
+	html_engine_search_all_forget (e, with);
+
 	/* merge_word_width (t1, t2, e->painter); */
 
 	if (e->cursor->object == with) {
@@ -540,11 +643,11 @@ object_merge (HTMLObject *self, HTMLObject *with, HTMLEngine *e, GList **left, G
 	}
 	merge_links (t1, t2);
 
-	to_free       = t1->text;
-	t1->text      = g_strconcat (t1->text, t2->text, NULL);
+	html_text_reserve (t1, t1->text_bytes + t2->text_bytes);
+	memcpy (t1->text + t1->text_bytes, t2->text, t2->text_bytes + 1);
 	t1->text_len += t2->text_len;
 	t1->text_bytes += t2->text_bytes;
-	g_free (to_free);
+	html_text_changed (t1);
 	html_text_convert_nbsp (t1, TRUE);
 	html_object_change_set (self, HTML_CHANGE_ALL_CALC);
 	pango_info_destroy (t1);
@@ -615,63 +718,35 @@ split_attrs (HTMLText *t1, HTMLText *t2, gint index)
 static void
 split_links (HTMLText *t1, HTMLText *t2, gint offset, gint index)
 {
-	GSList *l, *prev = NULL;
-
-	for (l = t1->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
+	Link *link;
+	guint n;
 
-		if (link->start_offset < offset) {
+	if (t1->links) {
+		n = links_search (t1->links, offset);
+		links_remove_range (t1->links, n, t1->links->len);
+		if (n > 0) {
+			link = (Link *) g_ptr_array_index (t1->links, n - 1);
 			if (link->end_offset > offset) {
 				link->end_offset = offset;
 				link->end_index = index;
 			}
-
-			if (prev) {
-				prev->next = NULL;
-				free_links (t1->links);
-			}
-			t1->links = l;
-			break;
-		}
-		prev = l;
-
-		if (!l->next) {
-			free_links (t1->links);
-			t1->links = NULL;
-			break;
 		}
+		links_drop_empty (t1);
 	}
 
-	prev = NULL;
-	for (l = t2->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
-
-		if (link->start_offset < offset) {
+	if (t2->links) {
+		n = links_search (t2->links, offset);
+		if (n > 0) {
+			link = (Link *) g_ptr_array_index (t2->links, n - 1);
 			if (link->end_offset > offset) {
 				link->start_offset = offset;
 				link->start_index = index;
-				prev = l;
-				l = l->next;
+				n --;
 			}
-			if (prev) {
-				prev->next = NULL;
-				free_links (l);
-			} else {
-				free_links (t2->links);
-				t2->links = NULL;
-			}
-			break;
 		}
-		prev = l;
-	}
-
-	for (l = t2->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
-
-		link->start_offset -= offset;
-		link->start_index -= index;
-		link->end_offset -= offset;
-		link->end_index -= index;
+		links_remove_range (t2->links, 0, n);
+		links_shift (t2->links, 0, -offset, -index);
+		links_drop_empty (t2);
 	}
 }
 
@@ -686,15 +761,15 @@ object_split (HTMLObject *self, HTMLEngine *e, HTMLObject *child, gint offset, g
 	g_assert (self->parent);
 
 	html_clue_remove_text_slaves (HTML_CLUE (self->parent));
+	html_engine_search_all_forget (e, self);
 
 	t1              = HTML_TEXT (self);
 	dup             = html_object_dup (self);
-	tt              = t1->text;
 	split_index     = html_text_get_index (t1, offset);
-	t1->text        = g_strndup (tt, split_index);
+	t1->text [split_index] = '\0';
 	t1->text_len    = offset;
 	t1->text_bytes  = split_index;
-	g_free (tt);
+	html_text_changed (t1);
 	html_text_convert_nbsp (t1, TRUE);
 
 	t2              = HTML_TEXT (dup);
@@ -702,6 +777,8 @@ object_split (HTMLObject *self, HTMLEngine *e, HTMLObject *child, gint offset, g
 	t2->text        = html_text_get_text (t2, offset);
 	t2->text_len   -= offset;
 	t2->text_bytes -= split_index;
+	t2->text_size   = 0;
+	html_text_changed (t2);
 	split_attrs (t1, t2, split_index);
 	split_links (t1, t2, offset, split_index);
 	if (!html_text_convert_nbsp (t2, FALSE))
@@ -720,10 +797,8 @@ object_split (HTMLObject *self, HTMLEngine *e, HTMLObject *child, gint offset, g
 	/* printf ("--- before split offset %d dup len %d\n", offset, HTML_TEXT (dup)->text_len);
 	   debug_spell_errors (HTML_TEXT (self)->spell_errors); */
 
-	HTML_TEXT (self)->spell_errors = remove_spell_errors (HTML_TEXT (self)->spell_errors,
-							      offset, HTML_TEXT (dup)->text_len);
-	HTML_TEXT (dup)->spell_errors  = remove_spell_errors (HTML_TEXT (dup)->spell_errors,
-							      0, HTML_TEXT (self)->text_len);
+	remove_spell_errors (HTML_TEXT (self)->spell_errors, offset, HTML_TEXT (dup)->text_len);
+	remove_spell_errors (HTML_TEXT (dup)->spell_errors, 0, HTML_TEXT (self)->text_len);
 	move_spell_errors   (HTML_TEXT (dup)->spell_errors, 0, - HTML_TEXT (self)->text_len);
 
 	/* printf ("--- after split\n");
@@ -1240,12 +1315,12 @@ html_text_prepare_attrs (HTMLText *text, HTMLPainter *painter)
 
 	if (text->links && e) {
 		HTMLColor *link_color;
-		GSList *l;
+		guint i;
 
-		for (l = text->links; l; l = l->next) {
+		for (i = 0; i < text->links->len; i ++) {
 			Link *link;
 
-			link = (Link *) l->data;
+			link = (Link *) g_ptr_array_index (text->links, i);
 
 			if (link->is_visited == FALSE)
 				link_color = html_colorset_get_color (e->settings->color_set, HTMLLinkColor);
@@ -1383,6 +1458,183 @@ html_text_shape_tab (HTMLText *text, PangoGlyphString *glyphs)
 	glyphs->glyphs[0].geometry.width = 48 * PANGO_SCALE;
 }
 
+/* Shaping cache.  Itemizing and shaping depend only on the text, the
+   attributes prepared for it and the pango context, so texts with equal
+   input share one HTMLTextPangoInfo.  The cache holds a reference to the
+   most recently used infos, bounded by HTML_TEXT_SHAPE_CACHE_SIZE, so they
+   survive relayouts and switching between painters. */
+
+#define HTML_TEXT_SHAPE_CACHE_SIZE 512
+
+typedef struct {
+	const gchar *text;
+	gint text_bytes;
+	PangoDirection dir;
+	PangoFontMap *font_map;
+	const PangoFontDescription *font_desc;
+	PangoLanguage *language;
+	GtkHTMLFontStyle font_style;
+	const HTMLFontFace *face;
+	GSList *attrs;
+	guint hash;
+
+	HTMLTextPangoInfo *pi;
+	GList *lru;
+} ShapeKey;
+
+static GHashTable *shape_cache = NULL;
+static GQueue *shape_cache_lru = NULL;
+
+static gboolean
+shape_key_collect_attr (PangoAttribute *attr, gpointer data)
+{
+	GSList **list = (GSList **) data;
+
+	*list = g_slist_prepend (*list, attr);
+
+	return FALSE;
+}
+
+static void
+shape_key_init (ShapeKey *key, HTMLText *text, HTMLPainter *painter, PangoAttrList *attrs)
+{
+	const gchar *s;
+	GSList *l;
+	guint h;
+
+	key->text = text->text;
+	key->text_bytes = text->text_bytes;
+	key->dir = get_pango_base_direction (text);
+	key->font_map = pango_context_get_font_map (painter->pango_context);
+	key->font_desc = pango_context_get_font_description (painter->pango_context);
+	key->language = pango_context_get_language (painter->pango_context);
+	key->font_style = html_text_get_font_style (text);
+	key->face = text->face;
+	key->attrs = NULL;
+	pango_attr_list_filter (attrs, shape_key_collect_attr, &key->attrs);
+	key->pi = NULL;
+	key->lru = NULL;
+
+	h = key->text_bytes;
+	for (s = key->text; s < key->text + key->text_bytes; s ++)
+		h = (h << 5) - h + *s;
+	h ^= key->dir + (key->font_style << 4);
+	h ^= g_direct_hash (key->font_map) ^ g_direct_hash (key->language);
+	if (key->font_desc)
+		h ^= pango_font_description_hash (key->font_desc);
+	for (l = key->attrs; l; l = l->next) {
+		PangoAttribute *attr = (PangoAttribute *) l->data;
+
+		h = (h << 5) - h + (attr->klass->type ^ (attr->start_index << 8) ^ (attr->end_index << 20));
+	}
+	key->hash = h;
+}
+
+static guint
+shape_key_hash (gconstpointer key)
+{
+	return ((const ShapeKey *) key)->hash;
+}
+
+static gboolean
+shape_key_equal (gconstpointer a, gconstpointer b)
+{
+	const ShapeKey *k1 = (const ShapeKey *) a;
+	const ShapeKey *k2 = (const ShapeKey *) b;
+	GSList *l1, *l2;
+
+	if (k1->hash != k2->hash || k1->text_bytes != k2->text_bytes || k1->dir != k2->dir
+	    || k1->font_map != k2->font_map || k1->language != k2->language || k1->font_style != k2->font_style)
+		return FALSE;
+	if (memcmp (k1->text, k2->text, k1->text_bytes))
+		return FALSE;
+	if ((k1->face || k2->face) && (!k1->face || !k2->face || strcmp (k1->face, k2->face)))
+		return FALSE;
+	if ((k1->font_desc || k2->font_desc)
+	    && (!k1->font_desc || !k2->font_desc || !pango_font_description_equal (k1->font_desc, k2->font_desc)))
+		return FALSE;
+
+	for (l1 = k1->attrs, l2 = k2->attrs; l1 && l2; l1 = l1->next, l2 = l2->next) {
+		PangoAttribute *attr1 = (PangoAttribute *) l1->data;
+		PangoAttribute *attr2 = (PangoAttribute *) l2->data;
+
+		if (attr1->start_index != attr2->start_index || attr1->end_index != attr2->end_index
+		    || !pango_attribute_equal (attr1, attr2))
+			return FALSE;
+	}
+
+	return l1 == NULL && l2 == NULL;
+}
+
+static void
+shape_key_free (ShapeKey *key)
+{
+	GSList *l;
+
+	for (l = key->attrs; l; l = l->next)
+		pango_attribute_destroy ((PangoAttribute *) l->data);
+	g_slist_free (key->attrs);
+	g_object_unref (key->font_map);
+	if (key->font_desc)
+		pango_font_description_free ((PangoFontDescription *) key->font_desc);
+	g_free ((gchar *) key->text);
+	g_free ((gchar *) key->face);
+	html_text_pango_info_destroy (key->pi);
+	g_free (key);
+}
+
+static HTMLTextPangoInfo *
+shape_cache_lookup (ShapeKey *key)
+{
+	ShapeKey *cached;
+
+	if (!shape_cache)
+		return NULL;
+
+	cached = g_hash_table_lookup (shape_cache, key);
+	if (!cached)
+		return NULL;
+
+	g_queue_unlink (shape_cache_lru, cached->lru);
+	g_queue_push_head_link (shape_cache_lru, cached->lru);
+
+	return html_text_pango_info_ref (cached->pi);
+}
+
+static void
+shape_cache_insert (ShapeKey *key, HTMLTextPangoInfo *pi)
+{
+	ShapeKey *cached;
+	GSList *l;
+
+	if (!shape_cache) {
+		shape_cache = g_hash_table_new (shape_key_hash, shape_key_equal);
+		shape_cache_lru = g_queue_new ();
+	}
+
+	cached = g_new (ShapeKey, 1);
+	*cached = *key;
+	cached->text = g_strndup (key->text, key->text_bytes);
+	cached->font_map = g_object_ref (key->font_map);
+	cached->font_desc = key->font_desc ? pango_font_description_copy (key->font_desc) : NULL;
+	cached->face = g_strdup (key->face);
+	cached->attrs = g_slist_copy (key->attrs);
+	for (l = cached->attrs; l; l = l->next)
+		l->data = pango_attribute_copy ((PangoAttribute *) l->data);
+	cached->pi = html_text_pango_info_ref (pi);
+
+	g_queue_push_head (shape_cache_lru, cached);
+	cached->lru = shape_cache_lru->head;
+	g_hash_table_insert (shape_cache, cached, cached);
+
+	while (shape_cache_lru->length > HTML_TEXT_SHAPE_CACHE_SIZE) {
+		ShapeKey *old = (ShapeKey *) g_queue_pop_tail (shape_cache_lru);
+
+		g_hash_table_remove (shape_cache, old);
+		shape_key_free (old);
+	}
+}
+
 HTMLTextPangoInfo *
 html_text_get_pango_info (HTMLText *text, HTMLPainter *painter)
 {
@@ -1394,11 +1646,19 @@ html_text_get_pango_info (HTMLText *text, HTMLPainter *painter)
 	if (!text->pi) {
 		GList *items, *cur;
 		PangoAttrList *attrs;
+		ShapeKey key;
 		gint i, offset;
 
 		attrs = html_text_prepare_attrs (text, painter);
-		items = pango_itemize_with_base_dir (painter->pango_context, get_pango_base_direction (text), text->text, 0, text->text_bytes, attrs, NULL);
-		pango_attr_list_unref (attrs);
+		shape_key_init (&key, text, painter, attrs);
+		text->pi = shape_cache_lookup (&key);
+		if (text->pi) {
+			g_slist_free (key.attrs);
+			pango_attr_list_unref (attrs);
+			return text->pi;
+		}
+
+		items = pango_itemize_with_base_dir (painter->pango_context, key.dir, text->text, 0, text->text_bytes, attrs, NULL);
 
 		/* create pango info */
 		text->pi = html_text_pango_info_new (g_list_length (items));
@@ -1457,6 +1717,12 @@ html_text_get_pango_info (HTMLText *text, HTMLPainter *painter)
 		}
 
 		g_list_free (items);
+
+		/* tab widths are adjusted to the line position while fitting, keep them private */
+		if (!memchr (text->text, '\t', text->text_bytes))
+			shape_cache_insert (&key, text->pi);
+		g_slist_free (key.attrs);
+		pango_attr_list_unref (attrs);
 	}
 	return text->pi;
 }
@@ -1758,14 +2024,16 @@ save_link_close (Link *link, HTMLEngineSaveState *state)
 }
 
 static gboolean
-save_text (HTMLText *text, HTMLEngineSaveState *state, guint start_index, guint end_index, GSList **l, gboolean *link_started)
+save_text (HTMLText *text, HTMLEngineSaveState *state, guint start_index, guint end_index, guint *l, gboolean *link_started)
 {
-	if (*l) {
+	guint n_links = text->links ? text->links->len : 0;
+
+	if (*l < n_links) {
 		Link *link;
 
-		link = (Link *) (*l)->data;
+		link = (Link *) g_ptr_array_index (text->links, *l);
 
-		while (*l && ((!*link_started && start_index <= link->start_index && link->start_index < end_index)
+		while (*l < n_links && ((!*link_started && start_index <= link->start_index && link->start_index < end_index)
 			      || (*link_started && link->end_index <= end_index))) {
 			if (!*link_started && start_index <= link->start_index && link->start_index < end_index) {
 				if (!save_text_part (text, state, start_index, link->start_index))
@@ -1779,10 +2047,10 @@ save_text (HTMLText *text, HTMLEngineSaveState *state, guint start_index, guint
 					return FALSE;
 				save_link_close (link, state);
 				*link_started = FALSE;
-				(*l) = (*l)->next;
+				(*l) ++;
 				start_index = link->end_index;
-				if (*l)
-					link = (Link *) (*l)->data;
+				if (*l < n_links)
+					link = (Link *) g_ptr_array_index (text->links, *l);
 			}
 		}
 
@@ -1801,11 +2069,9 @@ save (HTMLObject *self, HTMLEngineSaveState *state)
 	PangoAttrIterator *iter = pango_attr_list_get_iterator (text->attr_list);
 
 	if (iter) {
-		GSList *l, *links = g_slist_reverse (g_slist_copy (text->links));
+		guint l = 0;
 		gboolean link_started = FALSE;
 
-		l = links;
-
 		do {
 			GSList *attrs;
 			gint start_index, end_index;
@@ -1828,7 +2094,6 @@ save (HTMLObject *self, HTMLEngineSaveState *state)
 		} while (pango_attr_iterator_next (iter));
 
 		pango_attr_iterator_destroy (iter);
-		g_slist_free (links);
 	}
 
 	return TRUE;
@@ -2068,12 +2333,12 @@ update_attributes (PangoAttrList *attrs, GSList *changes)
 }
 
 static void
-update_links (GSList *links, GSList *changes)
+update_links (GPtrArray *links, GSList *changes)
 {
-	GSList *cl;
+	guint i;
 
-	for (cl = links; cl; cl = cl->next) {
-		Link *link = (Link *) cl->data;
+	for (i = 0; i < links->len; i ++) {
+		Link *link = (Link *) g_ptr_array_index (links, i);
 		update_index_interval (&link->start_index, &link->end_index, changes);
 	}
 }
@@ -2100,7 +2365,9 @@ html_text_convert_nbsp (HTMLText *text, gboolean free_text)
 		to_free = text->text;
 		text->text = g_malloc (strlen (to_free) + delta + 1);
 		text->text_bytes += delta;
+		text->text_size = 0;
 		convert_nbsp (text->text, to_free);
+		html_text_changed (text);
 		if (free_text)
 			g_free (to_free);
 		if (changes) {
@@ -2118,109 +2385,122 @@ html_text_convert_nbsp (HTMLText *text, gboolean free_text)
 	return FALSE;
 }
 
-static void
-move_spell_errors (GList *spell_errors, guint offset, gint delta)
+/* index of the first spell error starting at or after offset */
+static guint
+spell_errors_bsearch (GArray *spell_errors, guint offset)
 {
-	SpellError *se;
+	guint lo = 0, hi = spell_errors->len;
 
-	if (!delta)
-		return;
+	while (lo < hi) {
+		guint mid = (lo + hi) / 2;
 
-	while (spell_errors) {
-		se = (SpellError *) spell_errors->data;
-		if (se->off >= offset)
-			se->off += delta;
-		spell_errors = spell_errors->next;
+		if (g_array_index (spell_errors, SpellError, mid).off < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+
+	return lo;
 }
 
-static GList *
-remove_one (GList *list, GList *link)
+static void
+move_spell_errors (GArray *spell_errors, guint offset, gint delta)
 {
-	spell_error_destroy ((SpellError *) link->data);
-	list = g_list_remove_link (list, link);
-	g_list_free (link);
+	guint i;
 
-	return list;
+	if (!delta || !spell_errors)
+		return;
+
+	for (i = spell_errors_bsearch (spell_errors, offset); i < spell_errors->len; i ++)
+		g_array_index (spell_errors, SpellError, i).off += delta;
 }
 
-static GList *
-remove_spell_errors (GList *spell_errors, guint offset, guint len)
+/* spell errors are disjoint word ranges, so only the one just before offset
+   may reach into the removed range from the left */
+static void
+remove_spell_errors (GArray *spell_errors, guint offset, guint len)
 {
 	SpellError *se;
-	GList *cur, *cnext;
-
-	cur = spell_errors;
-	while (cur) {
-		cnext = cur->next;
-		se = (SpellError *) cur->data;
-		if (se->off < offset) {
-			if (se->off + se->len > offset) {
-				if (se->off + se->len <= offset + len)
-					se->len = offset - se->off;
-				else
-					se->len -= len;
-				if (se->len < 2)
-					spell_errors = remove_one (spell_errors, cur);
-			}
-		} else if (se->off < offset + len) {
+	guint i, keep;
+
+	if (!spell_errors || !len)
+		return;
+
+	i = spell_errors_bsearch (spell_errors, offset);
+	if (i > 0) {
+		se = &g_array_index (spell_errors, SpellError, i - 1);
+		if (se->off + se->len > offset) {
 			if (se->off + se->len <= offset + len)
-				spell_errors = remove_one (spell_errors, cur);
-			else {
-				se->len -= offset + len - se->off;
-				se->off  = offset + len;
-				if (se->len < 2)
-					spell_errors = remove_one (spell_errors, cur);
+				se->len = offset - se->off;
+			else
+				se->len -= len;
+			if (se->len < 2) {
+				g_array_remove_index (spell_errors, i - 1);
+				i --;
 			}
 		}
-		cur = cnext;
 	}
-	return spell_errors;
-}
 
-static gint
-se_cmp (SpellError *a, SpellError *b)
-{
-	guint o1 = a->off;
-	guint o2 = b->off;
+	for (keep = i; i < spell_errors->len; i ++) {
+		se = &g_array_index (spell_errors, SpellError, i);
+		if (se->off >= offset + len)
+			break;
+		if (se->off + se->len > offset + len) {
+			se->len -= offset + len - se->off;
+			se->off  = offset + len;
+			if (se->len >= 2)
+				g_array_index (spell_errors, SpellError, keep ++) = *se;
+		}
+	}
 
-	return (o1 < o2) ? -1 : (o1 == o2) ? 0 : 1;
+	if (keep < i)
+		g_array_remove_range (spell_errors, keep, i - keep);
 }
 
-static GList *
-merge_spell_errors (GList *se1, GList *se2)
+/* merges two sorted arrays into one, discarding duplicates, both arguments
+   are consumed */
+static GArray *
+merge_spell_errors (GArray *se1, GArray *se2)
 {
-	GList *merged = NULL;
-	GList *link;
-
-	/* Build the merge list in reverse order. */
-	while (se1 != NULL && se2 != NULL) {
-
-		/* Pop the lesser of the two list heads. */
-		if (se_cmp (se1->data, se2->data) < 0) {
-			link = se1;
-			se1 = g_list_remove_link (se1, link);
-		} else {
-			link = se2;
-			se2 = g_list_remove_link (se2, link);
-		}
+	GArray *merged;
+	SpellError *a, *b;
+	guint i = 0, j = 0;
 
-		/* Merge unique items, discard duplicates. */
-		if (merged == NULL || se_cmp (link->data, merged->data) != 0)
-			merged = g_list_concat (link, merged);
-		else {
-			spell_error_destroy (link->data);
-			g_list_free (link);
-		}
+	if (!se2 || !se2->len) {
+		if (se2)
+			g_array_free (se2, TRUE);
+		return se1;
+	}
+	if (!se1 || !se1->len) {
+		if (se1)
+			g_array_free (se1, TRUE);
+		return se2;
 	}
 
-	merged = g_list_reverse (merged);
+	/* the common case, se2 follows se1 like after object merge */
+	if (g_array_index (se1, SpellError, se1->len - 1).off < g_array_index (se2, SpellError, 0).off) {
+		g_array_append_vals (se1, se2->data, se2->len);
+		g_array_free (se2, TRUE);
+		return se1;
+	}
 
-	/* At this point at least one of the two input lists are empty,
-	 * so just append them both to the end of the merge list. */
+	merged = g_array_sized_new (FALSE, FALSE, sizeof (SpellError), se1->len + se2->len);
+	while (i < se1->len || j < se2->len) {
+		a = i < se1->len ? &g_array_index (se1, SpellError, i) : NULL;
+		b = j < se2->len ? &g_array_index (se2, SpellError, j) : NULL;
 
-	merged = g_list_concat (merged, se1);
-	merged = g_list_concat (merged, se2);
+		if (a && (!b || a->off <= b->off)) {
+			i ++;
+			if (b && a->off == b->off)
+				j ++;
+			g_array_append_val (merged, *a);
+		} else {
+			j ++;
+			g_array_append_val (merged, *b);
+		}
+	}
+	g_array_free (se1, TRUE);
+	g_array_free (se2, TRUE);
 
 	return merged;
 }
@@ -2309,6 +2589,7 @@ destroy (HTMLObject *obj)
 	g_free (text->text);
 	g_free (text->face);
 	pango_info_destroy (text);
+	html_text_offsets_invalidate (text);
 	pango_attr_list_unref (text->attr_list);
 	text->attr_list = NULL;
 	if (text->extra_attr_list) {
@@ -2491,19 +2772,28 @@ html_text_get_cursor_base (HTMLObject *self,
 	}
 }
 
-Link *
-html_text_get_link_at_offset (HTMLText *text, gint offset)
+/* index of the link at offset, the later one when two links touch there */
+static gint
+links_index_at_offset (GPtrArray *links, gint offset)
 {
-	GSList *l;
+	guint i;
 
-	for (l = text->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
+	if (!links)
+		return -1;
 
-		if (link->start_offset <= offset && offset <= link->end_offset)
-			return link;
-	}
+	i = links_search (links, offset + 1);
+	if (i > 0 && offset <= ((Link *) g_ptr_array_index (links, i - 1))->end_offset)
+		return i - 1;
 
-	return NULL;
+	return -1;
+}
+
+Link *
+html_text_get_link_at_offset (HTMLText *text, gint offset)
+{
+	gint i = links_index_at_offset (text->links, offset);
+
+	return i >= 0 ? (Link *) g_ptr_array_index (text->links, i) : NULL;
 }
 
 static const gchar *
@@ -2952,6 +3242,8 @@ html_text_init (HTMLText *text,
 	text->text_len = len;
 	text->text = g_memdup (str, text->text_bytes + 1);
 	text->text [text->text_bytes] = '\0';
+	text->text_size = 0;
+	text->stamp = html_text_new_stamp ();
 
 	text->font_style    = font_style;
 	text->face          = NULL;
@@ -2960,6 +3252,7 @@ html_text_init (HTMLText *text,
 	text->select_start  = 0;
 	text->select_length = 0;
 	text->pi            = NULL;
+	text->offsets       = NULL;
 	text->attr_list     = pango_attr_list_new ();
 	text->extra_attr_list = NULL;
 	text->links         = NULL;
@@ -3035,6 +3328,8 @@ html_text_set_text (HTMLText *text, const gchar *new_text)
 					       (gint *)&text->text_len);
 	text->text = g_memdup (new_text, text->text_bytes + 1);
 	text->text [text->text_bytes] = '\0';
+	text->text_size = 0;
+	html_text_changed (text);
 	html_object_change_set (HTML_OBJECT (text), HTML_CHANGE_ALL);
 }
 
@@ -3042,63 +3337,85 @@ html_text_set_text (HTMLText *text, const gchar *new_text)
 
 #include "htmlinterval.h"
 
-static SpellError *
-spell_error_new (guint off, guint len)
-{
-	SpellError *se = g_new (SpellError, 1);
-
-	se->off = off;
-	se->len = len;
-
-	return se;
-}
-
-static void
-spell_error_destroy (SpellError *se)
-{
-	g_free (se);
-}
-
 void
 html_text_spell_errors_clear (HTMLText *text)
 {
-	g_list_foreach (text->spell_errors, (GFunc) spell_error_destroy, NULL);
-	g_list_free    (text->spell_errors);
-	text->spell_errors = NULL;
+	if (text->spell_errors) {
+		g_array_free (text->spell_errors, TRUE);
+		text->spell_errors = NULL;
+	}
 }
 
 void
 html_text_spell_errors_clear_interval (HTMLText *text, HTMLInterval *i)
 {
-	GList *cur, *cnext;
 	SpellError *se;
-	guint offset, len;
+	guint offset, len, first, last;
+
+	if (!text->spell_errors)
+		return;
 
 	offset = html_interval_get_start  (i, HTML_OBJECT (text));
 	len    = html_interval_get_length (i, HTML_OBJECT (text));
-	cur    = text->spell_errors;
 
 	/* printf ("html_text_spell_errors_clear_interval %s %d %d\n", text->text, offset, len); */
 
-	while (cur) {
-		cnext = cur->next;
-		se    = (SpellError *) cur->data;
-		/* test overlap */
-		if (MAX (offset, se->off) <= MIN (se->off + se->len, offset + len)) {
-			text->spell_errors = g_list_remove_link (text->spell_errors, cur);
-			spell_error_destroy (se);
-			g_list_free (cur);
-		}
-		cur = cnext;
+	/* remove the errors overlapping or touching the interval */
+	first = html_text_spell_errors_search (text, offset);
+	for (last = first; last < text->spell_errors->len; last ++) {
+		se = &g_array_index (text->spell_errors, SpellError, last);
+		if (se->off > offset + len)
+			break;
 	}
+
+	if (first < last)
+		g_array_remove_range (text->spell_errors, first, last - first);
 }
 
 void
 html_text_spell_errors_add (HTMLText *text, guint off, guint len)
 {
-	text->spell_errors = merge_spell_errors (
-		text->spell_errors, g_list_prepend (
-		NULL, spell_error_new (off, len)));
+	SpellError se;
+	guint i;
+
+	if (!text->spell_errors)
+		text->spell_errors = g_array_new (FALSE, FALSE, sizeof (SpellError));
+
+	/* errors are mostly found in text order, so this is usually an append */
+	i = spell_errors_bsearch (text->spell_errors, off);
+	if (i < text->spell_errors->len && g_array_index (text->spell_errors, SpellError, i).off == off)
+		return;
+
+	se.off = off;
+	se.len = len;
+	g_array_insert_val (text->spell_errors, i, se);
+}
+
+/**
+ * html_text_spell_errors_search:
+ * @text: a text
+ * @offset: character offset
+ *
+ * Returns index into @text's spell errors of the first error which does not
+ * end before @offset, or the number of errors if there is none.
+ **/
+guint
+html_text_spell_errors_search (HTMLText *text, guint offset)
+{
+	SpellError *se;
+	guint i;
+
+	if (!text->spell_errors)
+		return 0;
+
+	i = spell_errors_bsearch (text->spell_errors, offset);
+	if (i > 0) {
+		se = &g_array_index (text->spell_errors, SpellError, i - 1);
+		if (se->off + se->len >= offset)
+			i --;
+	}
+
+	return i;
 }
 
 guint
@@ -3107,11 +3424,109 @@ html_text_get_bytes (HTMLText *text)
 	return strlen (text->text);
 }
 
+/* Long texts keep the byte index of every HTML_TEXT_OFFSETS_STEP-th
+   character, so html_text_get_text walks at most that many characters.
+   The checkpoints are built on demand and dropped whenever the text
+   changes, see html_text_changed. */
+
+#define HTML_TEXT_OFFSETS_MIN  256
+#define HTML_TEXT_OFFSETS_STEP 64
+
+struct _HTMLTextOffsets {
+	const gchar *text;
+	guint text_bytes;
+
+	gboolean ascii;
+	guint n;
+	guint *index;
+};
+
+/* Stamps are taken from one counter for all texts, so a new text never
+   gets the stamp an earlier one had at the same address. */
+static guint html_text_stamp_counter = 0;
+
+guint
+html_text_new_stamp (void)
+{
+	return ++ html_text_stamp_counter;
+}
+
+/* Must be called whenever the characters of text change, also when
+   they are edited in place. */
+void
+html_text_changed (HTMLText *text)
+{
+	text->stamp = html_text_new_stamp ();
+	html_text_offsets_invalidate (text);
+}
+
+void
+html_text_offsets_invalidate (HTMLText *text)
+{
+	if (text->offsets) {
+		g_free (text->offsets->index);
+		g_free (text->offsets);
+		text->offsets = NULL;
+	}
+}
+
+static HTMLTextOffsets *
+get_offsets (HTMLText *text)
+{
+	HTMLTextOffsets *offsets = text->offsets;
+	const gchar *s, *end;
+	guint i;
+
+	/* text replaced behind our back */
+	if (offsets && (offsets->text != text->text || offsets->text_bytes != text->text_bytes))
+		html_text_offsets_invalidate (text);
+
+	if (text->offsets)
+		return text->offsets;
+
+	offsets = g_new (HTMLTextOffsets, 1);
+	offsets->text = text->text;
+	offsets->text_bytes = text->text_bytes;
+	offsets->ascii = TRUE;
+	offsets->n = 0;
+	offsets->index = NULL;
+
+	end = text->text + text->text_bytes;
+	for (s = text->text; s < end; s ++)
+		if (*s & 0x80) {
+			offsets->ascii = FALSE;
+			break;
+		}
+
+	if (!offsets->ascii) {
+		offsets->index = g_new (guint, text->text_bytes / HTML_TEXT_OFFSETS_STEP + 1);
+		for (s = text->text, i = 0; s < end && *s; s = g_utf8_next_char (s), i ++)
+			if (i % HTML_TEXT_OFFSETS_STEP == 0)
+				offsets->index [offsets->n ++] = s - text->text;
+	}
+
+	text->offsets = offsets;
+
+	return offsets;
+}
+
 gchar *
 html_text_get_text (HTMLText *text, guint offset)
 {
 	gchar *s = text->text;
 
+	if (s && text->text_bytes >= HTML_TEXT_OFFSETS_MIN) {
+		HTMLTextOffsets *offsets = get_offsets (text);
+		guint i;
+
+		if (offsets->ascii)
+			return s + MIN (offset, text->text_bytes);
+
+		i = MIN (offset / HTML_TEXT_OFFSETS_STEP, offsets->n - 1);
+		s += offsets->index [i];
+		offset -= i * HTML_TEXT_OFFSETS_STEP;
+	}
+
 	while (offset-- && s && *s)
 		s = g_utf8_next_char (s);
 
@@ -3138,7 +3553,6 @@ html_text_get_char (HTMLText *text, guint offset)
 struct _HTMLMagicInsertMatch
 {
 	const gchar *regex;
-	regex_t *preg;
 	const gchar *prefix;
 };
 
@@ -3146,112 +3560,133 @@ typedef struct _HTMLMagicInsertMatch HTMLMagicInsertMatch;
 
 static HTMLMagicInsertMatch mim [] = {
 	/* prefixed expressions */
-	{ "(news|telnet|nntp|file|http|ftp|sftp|https|webcal)://([-a-z0-9]+(:[-a-z0-9]+)?@)?[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-a-z0-9_$.+!*(),;:@%&=?/~#']*[^]'.}>\\) ,?!;:\"]?)?", NULL, NULL },
-	{ "(sip|h323|callto):([-_a-z0-9.'\\+]+(:[0-9]{1,5})?(/[-_a-z0-9.']+)?)(@([-_a-z0-9.%=?]+|([0-9]{1,3}.){3}[0-9]{1,3})?)?(:[0-9]{1,5})?", NULL, NULL },
-	{ "mailto:[-_a-z0-9.'\\+]+@[-_a-z0-9.%=?]+", NULL, NULL },
+	{ "(news|telnet|nntp|file|http|ftp|sftp|https|webcal)://([-a-z0-9]+(:[-a-z0-9]+)?@)?[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-a-z0-9_$.+!*(),;:@%&=?/~#']*[^]'.}>\\) ,?!;:\"]?)?", NULL },
+	{ "(sip|h323|callto):([-_a-z0-9.'\\+]+(:[0-9]{1,5})?(/[-_a-z0-9.']+)?)(@([-_a-z0-9.%=?]+|([0-9]{1,3}.){3}[0-9]{1,3})?)?(:[0-9]{1,5})?", NULL },
+	{ "mailto:[-_a-z0-9.'\\+]+@[-_a-z0-9.%=?]+", NULL },
 	/* not prefixed expression */
-	{ "www\\.[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-A-Za-z0-9_$.+!*(),;:@%&=?/~#]*[^]'.}>\\) ,?!;:\"]?)?", NULL, "http://" },
-	{ "ftp\\.[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-A-Za-z0-9_$.+!*(),;:@%&=?/~#]*[^]'.}>\\) ,?!;:\"]?)?", NULL, "ftp://" },
-	{ "[-_a-z0-9.'\\+]+@[-_a-z0-9.%=?]+", NULL, "mailto:" }
+	{ "www\\.[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-A-Za-z0-9_$.+!*(),;:@%&=?/~#]*[^]'.}>\\) ,?!;:\"]?)?", "http://" },
+	{ "ftp\\.[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-A-Za-z0-9_$.+!*(),;:@%&=?/~#]*[^]'.}>\\) ,?!;:\"]?)?", "ftp://" },
+	{ "[-_a-z0-9.'\\+]+@[-_a-z0-9.%=?]+", "mailto:" }
 };
 
+/* all the expressions in one alternation, named groups m0, m1, ... tell
+   which one matched */
+static GRegex *magic_links_regex = NULL;
+
 void
 html_engine_init_magic_links (void)
 {
+	GString *alternation;
 	gint i;
 
-	for (i = 0; i < G_N_ELEMENTS (mim); i++) {
-		mim [i].preg = g_new0 (regex_t, 1);
-		if (regcomp (mim [i].preg, mim [i].regex, REG_EXTENDED | REG_ICASE)) {
-			/* error */
-			g_free (mim [i].preg);
-			mim [i].preg = 0;
-		}
-	}
+	if (magic_links_regex)
+		return;
+
+	alternation = g_string_new (NULL);
+	for (i = 0; i < G_N_ELEMENTS (mim); i++)
+		g_string_append_printf (alternation, "%s(?<m%d>%s)", i ? "|" : "", i, mim [i].regex);
+
+	magic_links_regex = g_regex_new (alternation->str, G_REGEX_CASELESS | G_REGEX_OPTIMIZE, 0, NULL);
+	g_string_free (alternation, TRUE);
 }
 
 static void
-paste_link (HTMLEngine *engine, HTMLText *text, gint so, gint eo, const gchar *prefix)
+paste_link (HTMLEngine *engine, HTMLText *text, gint so, gint eo, gint si, gint ei, const gchar *prefix)
 {
 	gchar *href;
-	gchar *base;
 
-	base = g_strndup (html_text_get_text (text, so), html_text_get_index (text, eo) - html_text_get_index (text, so));
-	href = (prefix) ? g_strconcat (prefix, base, NULL) : g_strdup (base);
-	g_free (base);
+	href = g_strdup_printf ("%s%.*s", prefix ? prefix : "", ei - si, text->text + si);
 
-	html_text_add_link (text, engine, href, NULL, so, eo);
+	html_text_add_link_full (text, engine, href, NULL, si, ei, so, eo);
 	g_free (href);
 }
 
+/* Links everything looking like an address between the character
+   offsets, the scan costs only the length of the range. */
+gboolean
+html_text_magic_links (HTMLText *text, HTMLEngine *engine, guint from, guint to)
+{
+	GMatchInfo *info = NULL;
+	const gchar *str, *end, *pos;
+	gboolean rv = FALSE;
+	guint pos_offset;
+
+	if (!magic_links_regex || from >= to)
+		return FALSE;
+
+	str = html_text_get_text (text, from);
+	end = g_utf8_offset_to_pointer (str, to - from);
+
+	pos = str;
+	pos_offset = from;
+	g_regex_match_full (magic_links_regex, str, end - str, 0, 0, &info, NULL);
+	while (g_match_info_matches (info)) {
+		const gchar *prefix = NULL;
+		gint so, eo, i;
+		guint so_offset, eo_offset;
+
+		g_match_info_fetch_pos (info, 0, &so, &eo);
+		for (i = 0; i < G_N_ELEMENTS (mim); i++) {
+			gchar name [8];
+			gint gs, ge;
+
+			g_snprintf (name, sizeof (name), "m%d", i);
+			if (g_match_info_fetch_named_pos (info, name, &gs, &ge) && gs >= 0) {
+				prefix = mim [i].prefix;
+				break;
+			}
+		}
+
+		/* matches come in order, count the characters from the last one */
+		so_offset = pos_offset + g_utf8_pointer_to_offset (pos, str + so);
+		eo_offset = so_offset + g_utf8_pointer_to_offset (str + so, str + eo);
+		paste_link (engine, text, so_offset, eo_offset, str + so - text->text, str + eo - text->text, prefix);
+		rv = TRUE;
+
+		pos = str + eo;
+		pos_offset = eo_offset;
+		g_match_info_next (info, NULL);
+	}
+	g_match_info_free (info);
+
+	return rv;
+}
+
+/* Called when a word was completed at offset, links it if it looks like
+   an address.  Only the word is scanned. */
 gboolean
 html_text_magic_link (HTMLText *text, HTMLEngine *engine, guint offset)
 {
-	regmatch_t pmatch [2];
-	gint i;
-	gboolean rv = FALSE, exec = TRUE;
+	gboolean rv;
 	gint saved_position;
 	gunichar uc;
-	gchar *str, *cur;
+	gchar *cur;
+	guint start = offset;
 
-	if (!offset)
+	if (!offset || offset > text->text_len)
 		return FALSE;
-	offset--;
 
 	/* printf ("html_text_magic_link\n"); */
 
-	html_undo_level_begin (engine->undo, "Magic link", "Remove magic link");
-	saved_position = engine->cursor->position;
-
-	cur = str = html_text_get_text (text, offset);
-
-	/* check forward to ensure chars are < 0x80, could be removed once we have utf8 regex */
-	while (TRUE) {
-		cur = g_utf8_next_char (cur);
-		if (!*cur)
-			break;
+	/* find the beginning of the word, addresses are plain ASCII */
+	cur = html_text_get_text (text, offset);
+	while (start > 0) {
+		cur = g_utf8_prev_char (cur);
 		uc = g_utf8_get_char (cur);
-		if (uc >= 0x80) {
-			exec = FALSE;
+		if (uc == ' ' || uc == ENTITY_NBSP)
 			break;
-		} else if (uc == ' ' || uc == ENTITY_NBSP) {
-			break;
-		}
-	}
-
-	uc = g_utf8_get_char (str);
-	if (uc >= 0x80)
-		exec = FALSE;
-	while (exec && uc != ' ' && uc != ENTITY_NBSP && offset) {
-		str = g_utf8_prev_char (str);
-		uc = g_utf8_get_char (str);
 		if (uc >= 0x80)
-			exec = FALSE;
-		offset--;
+			return FALSE;
+		start--;
 	}
 
-	if (uc == ' ' || uc == ENTITY_NBSP)
-		str = g_utf8_next_char (str);
+	if (start == offset)
+		return FALSE;
 
-	if (exec) {
-		gboolean done = FALSE;
-		guint32 str_offset = 0, str_length = strlen (str);
-
-		while (!done) {
-			done = TRUE;
-			for (i = 0; i < G_N_ELEMENTS (mim); i++) {
-				if (mim [i].preg && !regexec (mim [i].preg, str + str_offset, 2, pmatch, 0)) {
-					paste_link (engine, text,
-						    g_utf8_pointer_to_offset (text->text, str + str_offset + pmatch [0].rm_so),
-						    g_utf8_pointer_to_offset (text->text, str + str_offset + pmatch [0].rm_eo), mim [i].prefix);
-						rv = TRUE;
-						str_offset += pmatch [0].rm_eo + 1;
-						done = str_offset >= str_length;
-						break;
-				}
-			}
-		}
-	}
+	html_undo_level_begin (engine->undo, "Magic link", "Remove magic link");
+	saved_position = engine->cursor->position;
+
+	rv = html_text_magic_links (text, engine, start, offset);
 
 	html_undo_level_end (engine->undo, engine);
 	html_cursor_jump_to_position_no_spell (engine->cursor, engine, saved_position);
@@ -3270,23 +3705,32 @@ html_text_trail_space_width (HTMLText *text, HTMLPainter *painter)
 		? html_painter_get_space_width (painter, html_text_get_font_style (text), text->face) : 0;
 }
 
+/* Makes room for bytes plus the terminating zero.  The buffer grows by
+   half of the requested size, so repeated appends and merges into the
+   same text, like typing, take amortized constant time. */
+void
+html_text_reserve (HTMLText *text, guint bytes)
+{
+	if (text->text_size < bytes + 1) {
+		text->text_size = bytes + 1 + bytes / 2;
+		text->text = g_realloc (text->text, text->text_size);
+	}
+}
+
 void
 html_text_append (HTMLText *text, const gchar *str, gint len)
 {
-	gchar *to_delete;
 	guint bytes;
 
-	to_delete       = text->text;
 	bytes = html_text_sanitize (&str, &len);
 	text->text_len += len;
-	text->text      = g_malloc (text->text_bytes + bytes + 1);
+	html_text_reserve (text, text->text_bytes + bytes);
 
-	memcpy (text->text, to_delete, text->text_bytes);
 	memcpy (text->text + text->text_bytes, str, bytes);
 	text->text_bytes += bytes;
 	text->text[text->text_bytes] = '\0';
 
-	g_free (to_delete);
+	html_text_changed (text);
 
 	html_object_change_set (HTML_OBJECT (text), HTML_CHANGE_ALL);
 }
@@ -3294,7 +3738,12 @@ html_text_append (HTMLText *text, const gchar *str, gint len)
 void
 html_text_append_link_full (HTMLText *text, gchar *url, gchar *target, gint start_index, gint end_index, gint start_offset, gint end_offset)
 {
-	text->links = g_slist_prepend (text->links, html_link_new (url, target, start_index, end_index, start_offset, end_offset, FALSE));
+	if (!text->links)
+		text->links = g_ptr_array_new ();
+
+	/* the parser appends links in text order, so this is usually an append */
+	links_insert (text->links, links_search (text->links, start_offset + 1),
+		      html_link_new (url, target, start_index, end_index, start_offset, end_offset, FALSE));
 }
 
 static void
@@ -3316,47 +3765,33 @@ html_text_append_link (HTMLText *text, gchar *url, gchar *target, gint start_off
 void
 html_text_add_link_full (HTMLText *text, HTMLEngine *e, gchar *url, gchar *target, gint start_index, gint end_index, gint start_offset, gint end_offset)
 {
-	GSList *l, *prev = NULL;
-	Link *link;
+	Link *prev, *next, *new_link;
+	guint i;
 
 	cut_links_full (text, start_offset, end_offset, start_index, end_index, 0, 0);
 
 	if (text->links == NULL)
 		html_text_append_link_full (text, url, target, start_index, end_index, start_offset, end_offset);
 	else {
-		Link *plink = NULL, *new_link = html_link_new (url, target, start_index, end_index, start_offset, end_offset, FALSE);
-
-		for (l = text->links; new_link && l; l = l->next) {
-			link = (Link *) l->data;
-			if (new_link->start_offset >= link->end_offset) {
-				if (new_link->start_offset == link->end_offset && html_link_equal (link, new_link)) {
-					link->end_offset = end_offset;
-					link->end_index = end_index;
-					html_link_free (new_link);
-					new_link = NULL;
-				} else {
-					l = g_slist_prepend (l, new_link);
-					if (prev)
-						prev->next = l;
-					else
-						text->links = l;
-					link = new_link;
-					new_link = NULL;
-				}
-				if (plink && html_link_equal (plink, link) && plink->start_offset == link->end_offset) {
-					plink->start_offset = link->start_offset;
-					plink->start_index = link->start_index;
-					prev->next = g_slist_remove (prev->next, link);
-					html_link_free (link);
-					link = plink;
-				}
-				plink = link;
-				prev = l;
-			}
+		new_link = html_link_new (url, target, start_index, end_index, start_offset, end_offset, FALSE);
+		i = links_search (text->links, start_offset);
+		prev = i > 0 ? (Link *) g_ptr_array_index (text->links, i - 1) : NULL;
+		next = i < text->links->len ? (Link *) g_ptr_array_index (text->links, i) : NULL;
+
+		/* join with the same link ending where the new one starts or starting where it ends */
+		if (prev && prev->end_offset == start_offset && html_link_equal (prev, new_link)) {
+			prev->end_offset = end_offset;
+			prev->end_index = end_index;
+			html_link_free (new_link);
+			new_link = prev;
+		} else
+			links_insert (text->links, i ++, new_link);
+
+		if (next && next->start_offset == end_offset && html_link_equal (new_link, next)) {
+			new_link->end_offset = next->end_offset;
+			new_link->end_index = next->end_index;
+			links_remove_range (text->links, i, i + 1);
 		}
-
-		if (new_link && prev)
-			prev->next = g_slist_prepend (NULL, new_link);
 	}
 
 	HTML_OBJECT (text)->change |= HTML_CHANGE_RECALC_PI;
@@ -3451,18 +3886,11 @@ html_text_get_link_rectangle (HTMLText *text, HTMLPainter *painter, gint offset,
 gboolean
 html_text_prev_link_offset (HTMLText *text, gint *offset)
 {
-	GSList *l;
+	gint i = links_index_at_offset (text->links, *offset);
 
-	for (l = text->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
-
-		if (link->start_offset <= *offset && *offset <= link->end_offset) {
-			if (l->next) {
-				*offset = ((Link *) l->next->data)->end_offset - 1;
-				return TRUE;
-			}
-			break;
-		}
+	if (i > 0) {
+		*offset = ((Link *) g_ptr_array_index (text->links, i - 1))->end_offset - 1;
+		return TRUE;
 	}
 
 	return FALSE;
@@ -3471,19 +3899,11 @@ html_text_prev_link_offset (HTMLText *text, gint *offset)
 gboolean
 html_text_next_link_offset (HTMLText *text, gint *offset)
 {
-	GSList *l, *prev = NULL;
-
-	for (l = text->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
+	gint i = links_index_at_offset (text->links, *offset);
 
-		if (link->start_offset <= *offset && *offset <= link->end_offset) {
-			if (prev) {
-				*offset = ((Link *) prev->data)->start_offset + 1;
-				return TRUE;
-			}
-			break;
-		}
-		prev = l;
+	if (i >= 0 && (guint) i + 1 < text->links->len) {
+		*offset = ((Link *) g_ptr_array_index (text->links, i + 1))->start_offset + 1;
+		return TRUE;
 	}
 
 	return FALSE;
@@ -3493,7 +3913,7 @@ gboolean
 html_text_first_link_offset (HTMLText *text, gint *offset)
 {
 	if (text->links)
-		*offset = ((Link *) g_slist_last (text->links)->data)->start_offset + 1;
+		*offset = ((Link *) g_ptr_array_index (text->links, 0))->start_offset + 1;
 
 	return text->links != NULL;
 }
@@ -3502,7 +3922,7 @@ gboolean
 html_text_last_link_offset (HTMLText *text, gint *offset)
 {
 	if (text->links)
-		*offset = ((Link *) text->links->data)->end_offset - 1;
+		*offset = ((Link *) g_ptr_array_index (text->links, text->links->len - 1))->end_offset - 1;
 
 	return text->links != NULL;
 }
@@ -57,6 +57,9 @@ struct _HTMLTextPangoInfo {
 	gboolean have_font;
 	GtkHTMLFontStyle font_style;
 	HTMLFontFace *face;
+
+	/* shared between texts with the same shaping input, see html_text_get_pango_info */
+	gint ref_count;
 };
 
 struct _HTMLPangoAttrFontSize {
@@ -76,6 +79,12 @@ struct _HTMLText {
 	/* text length in bytes */
 	guint    text_bytes;
 
+	/* bytes allocated for text, 0 when only text_bytes + 1 are known */
+	guint    text_size;
+
+	/* changes with every edit of text, see html_text_changed */
+	guint    stamp;
+
 	PangoAttrList    *attr_list;
 	PangoAttrList    *extra_attr_list;
 	GtkHTMLFontStyle  font_style;
@@ -85,11 +94,16 @@ struct _HTMLText {
 	guint select_start;
 	guint select_length;
 
-	GList *spell_errors;
+	/* SpellError values sorted by offset, NULL when there are none */
+	GArray *spell_errors;
 
 	HTMLTextPangoInfo *pi;
 
-	GSList *links;
+	/* character offset to byte index checkpoints, see html_text_get_text */
+	HTMLTextOffsets *offsets;
+
+	/* Link pointers sorted by start offset, NULL when there are none */
+	GPtrArray *links;
 	gint focused_link_offset;
 	PangoDirection direction;
 };
@@ -138,6 +152,8 @@ void              html_text_append                       (HTMLText           *te
 							  gint                len);
 void              html_text_set_text                     (HTMLText           *text,
 							  const gchar        *new_text);
+void              html_text_reserve                      (HTMLText           *text,
+							  guint               bytes);
 void              html_text_set_font_face                (HTMLText           *text,
 							  HTMLFontFace       *face);
 gint              html_text_get_nb_width                 (HTMLText           *text,
@@ -150,6 +166,9 @@ gunichar          html_text_get_char                     (HTMLText           *te
 							  guint               offset);
 gchar            *html_text_get_text                     (HTMLText           *text,
 							  guint               offset);
+void              html_text_offsets_invalidate           (HTMLText           *text);
+void              html_text_changed                      (HTMLText           *text);
+guint             html_text_new_stamp                    (void);
 GList            *html_text_get_items                    (HTMLText           *text,
 							  HTMLPainter        *painter);
 void              html_text_spell_errors_clear           (HTMLText           *text);
@@ -158,9 +177,15 @@ void              html_text_spell_errors_clear_interval  (HTMLText           *te
 void              html_text_spell_errors_add             (HTMLText           *text,
 							  guint               off,
 							  guint               len);
+guint             html_text_spell_errors_search          (HTMLText           *text,
+							  guint               offset);
 gboolean          html_text_magic_link                   (HTMLText           *text,
 							  HTMLEngine         *engine,
 							  guint               offset);
+gboolean          html_text_magic_links                  (HTMLText           *text,
+							  HTMLEngine         *engine,
+							  guint               from,
+							  guint               to);
 gint              html_text_trail_space_width            (HTMLText           *text,
 							  HTMLPainter        *painter);
 gboolean          html_text_convert_nbsp                 (HTMLText           *text,
@@ -308,6 +333,7 @@ void      html_link_set_url_and_target  (Link  *link,
  * protected
  */
 HTMLTextPangoInfo *html_text_pango_info_new           (gint                   n);
+HTMLTextPangoInfo *html_text_pango_info_ref           (HTMLTextPangoInfo     *pi);
 void               html_text_pango_info_destroy       (HTMLTextPangoInfo     *pi);
 HTMLTextPangoInfo *html_text_get_pango_info           (HTMLText              *text,
 						       HTMLPainter           *painter);
@@ -31,6 +31,7 @@
 #include "htmlcursor.h"
 #include "htmlcolor.h"
 #include "htmlcolorset.h"
+#include "htmlengine-search.h"
 #include "htmlpainter.h"
 #include "htmlobject.h"
 #include "htmlprinter.h"
@@ -728,6 +729,30 @@ calc_glyph_range_size (HTMLText *text, PangoGlyphItem *glyph_item, gint start_in
 	return FALSE;
 }
 
+/* redraws the glyphs of the byte range in the given colors */
+static void
+draw_glyph_range (HTMLTextSlave *self, HTMLPainter *p, HTMLTextSlaveGlyphItem *gi, gint run_width,
+		  gint tx, gint ty, gint start_index, gint end_index, GdkColor *fg, GdkColor *bg)
+{
+	HTMLObject *obj = HTML_OBJECT (self);
+	HTMLText *text = self->owner;
+	gint start_x, width, asc, height;
+	gint cx, cy, cw, ch;
+
+	if (calc_glyph_range_size (text, &gi->glyph_item, start_index, end_index, &start_x, &width, &asc, &height) && width > 0) {
+		html_painter_get_clip_rectangle (p, &cx, &cy, &cw, &ch);
+		html_painter_set_clip_rectangle (p,
+						 obj->x + tx + html_painter_pango_to_engine (p, run_width + start_x),
+						 obj->y + ty + get_ys (text, p) - html_painter_pango_to_engine (p, asc),
+						 html_painter_pango_to_engine (p, width),
+						 html_painter_pango_to_engine (p, height));
+		html_painter_draw_glyphs (p, obj->x + tx + html_painter_pango_to_engine (p, run_width),
+					  obj->y + ty + get_ys (text, p), gi->glyph_item.item, gi->glyph_item.glyphs,
+					  fg, bg);
+		html_painter_set_clip_rectangle (p, cx, cy, cw, ch);
+	}
+}
+
 static void
 draw_text (HTMLTextSlave *self,
 	   HTMLPainter *p,
@@ -745,7 +770,10 @@ draw_text (HTMLTextSlave *self,
 	gint isect_start, isect_end;
 	gboolean selection;
 	GdkColor selection_fg, selection_bg;
+	GdkColor highlight_fg, highlight_bg;
+	GArray *highlights = NULL;
 	HTMLEngine *e = NULL;
+	guint i;
 
 	obj = HTML_OBJECT (self);
 
@@ -776,12 +804,21 @@ draw_text (HTMLTextSlave *self,
 		}
 	}
 
+	if (e)
+		highlights = html_engine_search_all_get_highlights (e, text);
+	if (highlights) {
+		highlight_fg = html_colorset_get_color_allocated
+			(e->settings->color_set, p, HTMLHighlightTextNFColor)->color;
+		highlight_bg = html_colorset_get_color_allocated
+			(e->settings->color_set, p, HTMLHighlightNFColor)->color;
+	}
+
 	/* printf ("draw_text %d %d %d\n", selection_bg.red, selection_bg.green, selection_bg.blue); */
 
 	run_width = 0;
 	for (cur = html_text_slave_get_glyph_items (self, p); cur; cur = cur->next) {
 		HTMLTextSlaveGlyphItem *gi = (HTMLTextSlaveGlyphItem *) cur->data;
-		GList *cur_se;
+		guint cur_se, n_se;
 		gint cur_width;
 
 		if (e)
@@ -790,33 +827,35 @@ draw_text (HTMLTextSlave *self,
 		cur_width = html_painter_draw_glyphs (p, obj->x + tx + html_painter_pango_to_engine (p, run_width),
 						      obj->y + ty + get_ys (text, p), gi->glyph_item.item, gi->glyph_item.glyphs, NULL, NULL);
 
-		if (selection) {
-			gint start_x, width, asc, height;
-			gint cx, cy, cw, ch;
-
-			if (calc_glyph_range_size (text, &gi->glyph_item, selection_start_index, selection_end_index, &start_x, &width, &asc, &height) && width > 0) {
-				html_painter_get_clip_rectangle (p, &cx, &cy, &cw, &ch);
-/*				printf ("run_width; %d start_x %d index %d\n", run_width, start_x, selection_start_index); */
-				html_painter_set_clip_rectangle (p,
-							obj->x + tx + html_painter_pango_to_engine (p, run_width + start_x),
-							obj->y + ty + get_ys (text, p) - html_painter_pango_to_engine (p, asc),
-							html_painter_pango_to_engine (p, width),
-							html_painter_pango_to_engine (p, height));
-
-				/* printf ("draw selection %d %d %d at %d, %d\n", selection_bg.red, selection_bg.green, selection_bg.blue,
-				   obj->x + tx + run_width, obj->y + ty + get_ys (text, p)); */
-				html_painter_draw_glyphs (p, obj->x + tx + html_painter_pango_to_engine (p, run_width),
-							  obj->y + ty + get_ys (text, p), gi->glyph_item.item, gi->glyph_item.glyphs,
-							  &selection_fg, &selection_bg);
-				html_painter_set_clip_rectangle (p, cx, cy, cw, ch);
+		/* find all matches under the selection */
+		for (i = 0; highlights && i < highlights->len; i++) {
+			HTMLSearchHighlight *h = &g_array_index (highlights, HTMLSearchHighlight, i);
+			guint ma, mi;
+
+			if (h->offset >= self->posStart + self->posLen)
+				break;
+			ma = MAX (h->offset, self->posStart);
+			mi = MIN (MIN (h->offset + h->len, self->posStart + self->posLen), text->text_len);
+
+			if (ma < mi) {
+				gchar *start = html_text_get_text (text, ma);
+				gchar *end = g_utf8_offset_to_pointer (start, mi - ma);
+
+				draw_glyph_range (self, p, gi, run_width, tx, ty, start - text->text, end - text->text,
+						  &highlight_fg, &highlight_bg);
 			}
 		}
 
-		for (cur_se = text->spell_errors; e && cur_se; cur_se = cur_se->next) {
+		if (selection)
+			draw_glyph_range (self, p, gi, run_width, tx, ty, selection_start_index, selection_end_index,
+					  &selection_fg, &selection_bg);
+
+		n_se = text->spell_errors ? text->spell_errors->len : 0;
+		for (cur_se = html_text_spell_errors_search (text, self->posStart); e && cur_se < n_se; cur_se ++) {
 			SpellError *se;
 			guint ma, mi;
 
-			se = (SpellError *) cur_se->data;
+			se = &g_array_index (text->spell_errors, SpellError, cur_se);
 			ma = MAX (se->off, self->posStart);
 			mi = MIN (se->off + se->len, self->posStart + self->posLen);
 
@@ -0,0 +1,319 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* This file is part of the GtkHTML library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+/* Offscreen render cache for documents which are only viewed.  The
+   document is cut into HTML_TILE_SIZE square tiles in document (bin
+   window) coordinates, each rendered once into its own pixmap and copied
+   to the window on later exposes.  Tiles are dropped when the draw queue
+   damages them and in least recently used order when over budget.  */
+
+#include <config.h>
+#include "htmlengine.h"
+#include "htmlgdkpainter.h"
+#include "htmlobject.h"
+#include "htmltilecache.h"
+
+typedef struct {
+	gint col, row;
+	GdkPixmap *pixmap;
+
+	/* link in HTMLTileCache::lru, data points back to the tile */
+	GList lru_link;
+} HTMLTile;
+
+struct _HTMLTileCache {
+	HTMLEngine *engine;
+
+	/* HTMLTile by column and row */
+	GHashTable *tiles;
+	/* most recently used first */
+	GQueue lru;
+
+	gsize budget;
+	gsize pixels;
+
+	GdkGC *gc;
+	guint prefetch_id;
+};
+
+#define TILE_PIXELS (HTML_TILE_SIZE * HTML_TILE_SIZE)
+
+static guint
+tile_hash (gconstpointer key)
+{
+	const HTMLTile *tile = key;
+
+	return (guint) tile->row * 4099 + (guint) tile->col;
+}
+
+static gboolean
+tile_equal (gconstpointer a, gconstpointer b)
+{
+	const HTMLTile *t1 = a, *t2 = b;
+
+	return t1->col == t2->col && t1->row == t2->row;
+}
+
+static void
+tile_free (HTMLTile *tile)
+{
+	if (tile->pixmap)
+		g_object_unref (tile->pixmap);
+	g_free (tile);
+}
+
+static HTMLTile *
+lookup (HTMLTileCache *cache, gint col, gint row)
+{
+	HTMLTile key;
+
+	key.col = col;
+	key.row = row;
+
+	return g_hash_table_lookup (cache->tiles, &key);
+}
+
+static void
+remove_tile (HTMLTileCache *cache, HTMLTile *tile)
+{
+	g_queue_unlink (&cache->lru, &tile->lru_link);
+	g_hash_table_remove (cache->tiles, tile);
+	cache->pixels -= TILE_PIXELS;
+	tile_free (tile);
+}
+
+static void
+touch (HTMLTileCache *cache, HTMLTile *tile)
+{
+	if (cache->lru.head != &tile->lru_link) {
+		g_queue_unlink (&cache->lru, &tile->lru_link);
+		g_queue_push_head_link (&cache->lru, &tile->lru_link);
+	}
+}
+
+static HTMLTile *
+render_tile (HTMLTileCache *cache, gint col, gint row)
+{
+	HTMLEngine *e = cache->engine;
+	HTMLGdkPainter *painter = HTML_GDK_PAINTER (e->painter);
+	HTMLTile *tile;
+	gint x = col * HTML_TILE_SIZE, y = row * HTML_TILE_SIZE;
+
+	while (cache->pixels + TILE_PIXELS > cache->budget && cache->lru.tail)
+		remove_tile (cache, cache->lru.tail->data);
+
+	tile = g_new0 (HTMLTile, 1);
+	tile->col = col;
+	tile->row = row;
+	tile->lru_link.data = tile;
+	tile->pixmap = gdk_pixmap_new (painter->window, HTML_TILE_SIZE, HTML_TILE_SIZE, -1);
+
+	html_gdk_painter_begin_pixmap (painter, tile->pixmap, x, y);
+	html_engine_draw_background (e, x, y, HTML_TILE_SIZE, HTML_TILE_SIZE);
+	if (e->clue) {
+		e->clue->x = html_engine_get_left_border (e);
+		e->clue->y = html_engine_get_top_border (e) + e->clue->ascent;
+		html_object_draw (e->clue, e->painter, x, y, HTML_TILE_SIZE, HTML_TILE_SIZE, 0, 0);
+	}
+	html_gdk_painter_end_pixmap (painter);
+
+	g_hash_table_insert (cache->tiles, tile, tile);
+	g_queue_push_head_link (&cache->lru, &tile->lru_link);
+	cache->pixels += TILE_PIXELS;
+
+	return tile;
+}
+
+static gint
+tile_floor (gint v)
+{
+	return v >= 0 ? v / HTML_TILE_SIZE : - ((- v + HTML_TILE_SIZE - 1) / HTML_TILE_SIZE);
+}
+
+/* Renders one missing tile around the viewport per call, as long as it
+   fits the budget without evicting anything.  */
+static gboolean
+prefetch_idle (HTMLTileCache *cache)
+{
+	HTMLEngine *e = cache->engine;
+	gint c1, r1, c2, r2, col, row;
+
+	/* html_engine_draw_real does not draw in these states either */
+	if (!html_gdk_painter_realized (HTML_GDK_PAINTER (e->painter))
+	    || html_engine_frozen (e) || (e->block && e->opened_streams)
+	    || cache->pixels + TILE_PIXELS > cache->budget) {
+		cache->prefetch_id = 0;
+		return FALSE;
+	}
+
+	c1 = tile_floor (e->x_offset) - 1;
+	r1 = tile_floor (e->y_offset) - 1;
+	c2 = tile_floor (e->x_offset + e->width - 1) + 1;
+	r2 = tile_floor (e->y_offset + e->height - 1) + 1;
+
+	/* the ring of tiles just outside the viewport */
+	for (row = MAX (r1, 0); row <= r2; row++) {
+		for (col = MAX (c1, 0); col <= c2; col++) {
+			if (row > r1 && row < r2 && col > c1 && col < c2)
+				continue;
+			if (col * HTML_TILE_SIZE >= html_engine_get_doc_width (e)
+			    || row * HTML_TILE_SIZE >= html_engine_get_doc_height (e))
+				break;
+			if (!lookup (cache, col, row)) {
+				render_tile (cache, col, row);
+				return TRUE;
+			}
+		}
+	}
+
+	cache->prefetch_id = 0;
+	return FALSE;
+}
+
+HTMLTileCache *
+html_tile_cache_new (HTMLEngine *engine, gsize budget)
+{
+	HTMLTileCache *cache;
+
+	g_return_val_if_fail (engine != NULL, NULL);
+
+	cache = g_new0 (HTMLTileCache, 1);
+	cache->engine = engine;
+	cache->tiles = g_hash_table_new (tile_hash, tile_equal);
+	g_queue_init (&cache->lru);
+	cache->budget = MAX (budget, TILE_PIXELS);
+
+	return cache;
+}
+
+void
+html_tile_cache_destroy (HTMLTileCache *cache)
+{
+	g_return_if_fail (cache != NULL);
+
+	html_tile_cache_clear (cache);
+	g_hash_table_destroy (cache->tiles);
+	g_free (cache);
+}
+
+/**
+ * html_tile_cache_draw:
+ * @cache: a tile cache
+ *
+ * Paints the given window area from cached tiles, rendering the missing
+ * ones first, and schedules prefetch of the tiles around the viewport.
+ **/
+void
+html_tile_cache_draw (HTMLTileCache *cache, gint x1, gint y1, gint x2, gint y2)
+{
+	HTMLGdkPainter *painter;
+	gint col, row;
+
+	g_return_if_fail (cache != NULL);
+
+	painter = HTML_GDK_PAINTER (cache->engine->painter);
+	if (!cache->gc)
+		cache->gc = gdk_gc_new (painter->window);
+
+	for (row = tile_floor (y1); row * HTML_TILE_SIZE < y2; row++) {
+		for (col = tile_floor (x1); col * HTML_TILE_SIZE < x2; col++) {
+			HTMLTile *tile = lookup (cache, col, row);
+			gint tx = col * HTML_TILE_SIZE, ty = row * HTML_TILE_SIZE;
+			gint sx = MAX (x1, tx), sy = MAX (y1, ty);
+
+			if (tile)
+				touch (cache, tile);
+			else
+				tile = render_tile (cache, col, row);
+
+			gdk_draw_drawable (painter->window, cache->gc, tile->pixmap,
+					   sx - tx, sy - ty, sx, sy,
+					   MIN (x2, tx + HTML_TILE_SIZE) - sx,
+					   MIN (y2, ty + HTML_TILE_SIZE) - sy);
+		}
+	}
+
+	if (!cache->prefetch_id)
+		cache->prefetch_id = g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) prefetch_idle, cache, NULL);
+}
+
+void
+html_tile_cache_invalidate (HTMLTileCache *cache, gint x, gint y, gint width, gint height)
+{
+	gint col, row;
+
+	g_return_if_fail (cache != NULL);
+
+	if (width <= 0 || height <= 0 || cache->pixels == 0)
+		return;
+
+	for (row = tile_floor (y); row * HTML_TILE_SIZE < y + height; row++) {
+		for (col = tile_floor (x); col * HTML_TILE_SIZE < x + width; col++) {
+			HTMLTile *tile = lookup (cache, col, row);
+
+			if (tile)
+				remove_tile (cache, tile);
+		}
+	}
+}
+
+void
+html_tile_cache_invalidate_region (HTMLTileCache *cache, GdkRegion *region)
+{
+	GdkRectangle *rects;
+	gint i, n;
+
+	g_return_if_fail (cache != NULL);
+
+	if (cache->pixels == 0)
+		return;
+
+	gdk_region_get_rectangles (region, &rects, &n);
+	for (i = 0; i < n; i++)
+		html_tile_cache_invalidate (cache, rects [i].x, rects [i].y, rects [i].width, rects [i].height);
+	g_free (rects);
+}
+
+void
+html_tile_cache_clear (HTMLTileCache *cache)
+{
+	g_return_if_fail (cache != NULL);
+
+	if (cache->prefetch_id) {
+		g_source_remove (cache->prefetch_id);
+		cache->prefetch_id = 0;
+	}
+
+	while (cache->lru.tail)
+		remove_tile (cache, cache->lru.tail->data);
+
+	/* the GC belongs to the window, which may be going away */
+	if (cache->gc) {
+		g_object_unref (cache->gc);
+		cache->gc = NULL;
+	}
+}
+
+gsize
+html_tile_cache_get_size (HTMLTileCache *cache)
+{
+	g_return_val_if_fail (cache != NULL, 0);
+
+	return cache->pixels;
+}
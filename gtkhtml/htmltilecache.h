@@ -0,0 +1,58 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* This file is part of the GtkHTML library
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _HTMLTILECACHE_H
+#define _HTMLTILECACHE_H
+
+#include <gtk/gtk.h>
+#include "gtk-compat.h"
+#include "htmltypes.h"
+
+/* Rendered documents are cached in square tiles of this size, in document
+   coordinates.  */
+#define HTML_TILE_SIZE 256
+
+/* Default budget, in pixels, of all cached tiles together.  */
+#define HTML_TILE_CACHE_BUDGET (128 * HTML_TILE_SIZE * HTML_TILE_SIZE)
+
+HTMLTileCache *html_tile_cache_new             (HTMLEngine    *engine,
+						gsize          budget);
+void           html_tile_cache_destroy         (HTMLTileCache *cache);
+
+/* Painting.  */
+void           html_tile_cache_draw            (HTMLTileCache *cache,
+						gint           x1,
+						gint           y1,
+						gint           x2,
+						gint           y2);
+
+/* Invalidation.  */
+void           html_tile_cache_invalidate      (HTMLTileCache *cache,
+						gint           x,
+						gint           y,
+						gint           width,
+						gint           height);
+void           html_tile_cache_invalidate_region (HTMLTileCache *cache,
+						  GdkRegion     *region);
+void           html_tile_cache_clear           (HTMLTileCache *cache);
+
+/* Pixels of all cached tiles together.  */
+gsize          html_tile_cache_get_size        (HTMLTileCache *cache);
+
+#endif /* _HTMLTILECACHE_H */
@@ -52,6 +52,8 @@ typedef struct _HTMLClueV HTMLClueV;
 typedef struct _HTMLClueVClass HTMLClueVClass;
 typedef struct _HTMLColor HTMLColor;
 typedef struct _HTMLColorSet HTMLColorSet;
+typedef struct _HTMLCss HTMLCss;
+typedef struct _HTMLCssContext HTMLCssContext;
 typedef struct _HTMLCursor HTMLCursor;
 typedef struct _HTMLCursorRectagle HTMLCursorRectangle;
 typedef struct _HTMLDrawQueue HTMLDrawQueue;
@@ -98,6 +100,7 @@ typedef struct _HTMLPainter HTMLPainter;
 typedef struct _HTMLPainterClass HTMLPainterClass;
 typedef struct _HTMLPangoAttrFontSize HTMLPangoAttrFontSize;
 typedef struct _HTMLPangoProperties HTMLPangoProperties;
+typedef struct _HTMLParserThread HTMLParserThread;
 typedef struct _HTMLPoint HTMLPoint;
 typedef struct _HTMLPrinter HTMLPrinter;
 typedef struct _HTMLPrinterClass HTMLPrinterClass;
@@ -109,6 +112,7 @@ typedef struct _HTMLRuleClass HTMLRuleClass;
 typedef struct _HTMLSelect HTMLSelect;
 typedef struct _HTMLSelectClass HTMLSelectClass;
 typedef struct _HTMLSearch HTMLSearch;
+typedef struct _HTMLSearchAll HTMLSearchAll;
 typedef struct _HTMLSettings HTMLSettings;
 typedef struct _HTMLStack HTMLStack;
 typedef struct _HTMLStringTokenizer HTMLStringTokenizer;
@@ -120,6 +124,7 @@ typedef struct _HTMLTableClass HTMLTableClass;
 typedef struct _HTMLText HTMLText;
 typedef struct _HTMLTextPangoInfoEntry HTMLTextPangoInfoEntry;
 typedef struct _HTMLTextPangoInfo HTMLTextPangoInfo;
+typedef struct _HTMLTextOffsets HTMLTextOffsets;
 typedef struct _HTMLTextArea HTMLTextArea;
 typedef struct _HTMLTextAreaClass HTMLTextAreaClass;
 typedef struct _HTMLTextClass HTMLTextClass;
@@ -128,6 +133,7 @@ typedef struct _HTMLTextInputClass HTMLTextInputClass;
 typedef struct _HTMLTextSlave HTMLTextSlave;
 typedef struct _HTMLTextSlaveClass HTMLTextSlaveClass;
 typedef struct _HTMLTextSlaveGlyphItem HTMLTextSlaveGlyphItem;
+typedef struct _HTMLTileCache HTMLTileCache;
 typedef struct _HTMLTokenizer HTMLTokenizer;
 typedef struct _HTMLTokenizerClass HTMLTokenizerClass;
 typedef struct _HTMLUndo HTMLUndo;
@@ -150,6 +156,9 @@ typedef void     (* HTMLUndoFunc)               (HTMLEngine        *engine,
 						 HTMLUndoDirection  dir,
 						 guint              position_after);
 typedef void     (* HTMLUndoDataDestroyFunc)    (HTMLUndoData      *data);
+typedef gboolean (* HTMLUndoDataMergeFunc)      (HTMLEngine        *engine,
+						 HTMLUndoAction    *action,
+						 HTMLUndoAction    *with);
 
 /* FIXME */
 typedef GtkHTMLSaveReceiverFn HTMLEngineSaveReceiverFn;
@@ -20,6 +20,7 @@
 */
 
 #include <config.h>
+#include <string.h>
 #include "htmlcursor.h"
 #include "htmlengine.h"
 #include "htmlundo.h"
@@ -43,6 +44,9 @@ struct _HTMLUndo {
 	guint     in_redo;
 	gint      step_counter;
 
+	gsize     budget;       /* bytes the undo stack may retain */
+	gpointer  merge_stop;   /* action not to merge into, see html_undo_mark_saved */
+
 	gint      freeze_count; /* Freeze counter for im context */
 };
 
@@ -79,6 +83,60 @@ destroy_action_list (GList *lp)
 		html_undo_action_destroy (HTML_UNDO_ACTION (p->data));
 }
 
+static gsize
+action_size (HTMLUndoAction *action)
+{
+	return sizeof (HTMLUndoAction) + strlen (action->description) + 1 + (action->data ? action->data->size : 0);
+}
+
+static gsize
+action_list_size (GList *lp)
+{
+	gsize size = 0;
+
+	for (; lp; lp = lp->next)
+		size += action_size (HTML_UNDO_ACTION (lp->data));
+
+	return size;
+}
+
+static gboolean
+action_merge (HTMLEngine *engine, HTMLUndoAction *action, HTMLUndoAction *with)
+{
+	return action->data && with->data && action->function == with->function
+		&& action->data->merge && action->data->merge == with->data->merge
+		&& action->data->ref_count == 1 && with->data->ref_count == 1
+		&& (* action->data->merge) (engine, action, with);
+}
+
+/* drops the oldest actions over HTML_UNDO_LIMIT or over the budget,
+   the newest action is always kept */
+static void
+undo_stack_trim (HTMLUndo *undo)
+{
+	GList *cur, *last;
+	gsize size = 0;
+	guint n = 0;
+
+	for (cur = undo->undo.stack; cur; cur = cur->next) {
+		size += action_size (HTML_UNDO_ACTION (cur->data));
+		n ++;
+		if (n > 1 && (n > HTML_UNDO_LIMIT || size > undo->budget))
+			break;
+	}
+
+	if (!cur)
+		return;
+
+	last = cur->prev;
+	last->next = NULL;
+	cur->prev = NULL;
+
+	destroy_action_list (cur);
+	undo->undo.size -= g_list_length (cur);
+	g_list_free (cur);
+}
+
 static void
 destroy_levels_list (GSList *lp)
 {
@@ -95,6 +153,7 @@ html_undo_new (void)
 	HTMLUndo *new_undo;
 
 	new_undo = g_new0 (HTMLUndo, 1);
+	new_undo->budget = HTML_UNDO_BUDGET;
 
 	return new_undo;
 }
@@ -263,19 +322,14 @@ html_undo_add_undo_action  (HTMLUndo *undo, HTMLEngine *engine, HTMLUndoAction *
 		if (undo->in_redo == 0 && undo->redo.size > 0)
 			add_used_and_redo_to_undo (undo, engine);
 
-		if (undo->undo.size >= HTML_UNDO_LIMIT) {
-			HTMLUndoAction *last_action;
-			GList *last;
-
-			last = g_list_last (undo->undo.stack);
-			last_action = (HTMLUndoAction *) last->data;
-
-			undo->undo.stack = g_list_remove_link (undo->undo.stack, last);
-			g_list_free (last);
-
-			html_undo_action_destroy (last_action);
-
-			undo->undo.size--;
+		/* coalesce consecutive edits like typed characters into one step */
+		if (undo->in_redo == 0 && undo->undo_used.stack == NULL && undo->undo.stack
+		    && undo->undo.stack->data != undo->merge_stop
+		    && action_merge (engine, HTML_UNDO_ACTION (undo->undo.stack->data), action)) {
+			html_undo_action_destroy (action);
+			undo_stack_trim (undo);
+			html_engine_emit_undo_changed (engine);
+			return;
 		}
 
 		undo->step_counter ++;
@@ -286,6 +340,9 @@ html_undo_add_undo_action  (HTMLUndo *undo, HTMLEngine *engine, HTMLUndoAction *
 	undo->undo.stack = g_list_prepend (undo->undo.stack, action);
 	undo->undo.size ++;
 
+	if (undo->level == 0)
+		undo_stack_trim (undo);
+
 #ifdef UNDO_DEBUG
 	if (!undo->level) {
 		printf ("ADD UNDO\n");
@@ -361,6 +418,7 @@ struct _HTMLUndoLevel {
 typedef struct _HTMLUndoLevel HTMLUndoLevel;
 
 static void undo_step_action (HTMLEngine *e, HTMLUndoData *data, HTMLUndoDirection dir, guint position_after);
+static gboolean level_merge (HTMLEngine *e, HTMLUndoAction *action, HTMLUndoAction *with);
 static void redo_level_begin (HTMLUndo *undo, const gchar *redo_desription, const gchar *undo_desription);
 static void redo_level_end   (HTMLUndo *undo);
 
@@ -390,6 +448,7 @@ level_new (HTMLUndo *undo, HTMLUndoStack *stack, const gchar *undo_description,
 	stack_copy (stack, &nl->stack);
 
 	nl->data.destroy                 = level_destroy;
+	nl->data.merge                   = level_merge;
 	nl->parent_undo                  = undo;
 	nl->description [HTML_UNDO_UNDO] = g_strdup (undo_description);
 	nl->description [HTML_UNDO_REDO] = g_strdup (redo_description);
@@ -490,6 +549,8 @@ html_undo_level_end (HTMLUndo *undo, HTMLEngine *engine)
 	if (save_undo.size) {
 		HTMLUndoAction *action;
 
+		level->data.size = sizeof (HTMLUndoLevel) + action_list_size (save_undo.stack);
+
 		/* we use position from last undo action on the stack */
 		action = html_undo_action_new (level->description [HTML_UNDO_UNDO],
 					       undo_step_action,
@@ -508,6 +569,30 @@ html_undo_level_end (HTMLUndo *undo, HTMLEngine *engine)
 	g_slist_free (head);
 }
 
+/* levels holding a single action merge when their actions do */
+static gboolean
+level_merge (HTMLEngine *e, HTMLUndoAction *action, HTMLUndoAction *with)
+{
+	HTMLUndoLevel *level = HTML_UNDO_LEVEL (action->data);
+	HTMLUndoLevel *with_level = HTML_UNDO_LEVEL (with->data);
+	HTMLUndoAction *inner;
+
+	if (level->stack.size != 1 || with_level->stack.size != 1
+	    || strcmp (level->description [HTML_UNDO_UNDO], with_level->description [HTML_UNDO_UNDO])
+	    || strcmp (level->description [HTML_UNDO_REDO], with_level->description [HTML_UNDO_REDO]))
+		return FALSE;
+
+	inner = HTML_UNDO_ACTION (level->stack.stack->data);
+	if (!action_merge (e, inner, HTML_UNDO_ACTION (with_level->stack.stack->data)))
+		return FALSE;
+
+	action->position       = inner->position;
+	action->position_after = inner->position_after;
+	level->data.size       = sizeof (HTMLUndoLevel) + action_size (inner);
+
+	return TRUE;
+}
+
 static void
 undo_step_action (HTMLEngine *e, HTMLUndoData *data, HTMLUndoDirection dir, guint position_after)
 {
@@ -556,6 +641,8 @@ html_undo_data_init (HTMLUndoData   *data)
 {
 	data->ref_count = 1;
 	data->destroy   = NULL;
+	data->merge     = NULL;
+	data->size      = 0;
 }
 
 void
@@ -682,3 +769,28 @@ html_undo_get_step_count (HTMLUndo *undo)
 {
 	return undo->step_counter;
 }
+
+/* The step count identifies the state the document was saved in.  Later
+   edits must not merge into the last action, otherwise the count would
+   not change with them. */
+void
+html_undo_mark_saved (HTMLUndo *undo)
+{
+	undo->merge_stop = undo->undo.stack ? undo->undo.stack->data : NULL;
+}
+
+/* bytes retained by the undo steps */
+gsize
+html_undo_get_size (HTMLUndo *undo)
+{
+	return action_list_size (undo->undo.stack) + action_list_size (undo->undo_used.stack)
+		+ action_list_size (undo->redo.stack);
+}
+
+void
+html_undo_set_budget (HTMLUndo *undo, gsize budget)
+{
+	undo->budget = budget;
+	if (undo->level == 0)
+		undo_stack_trim (undo);
+}
@@ -23,6 +23,7 @@
 #define _HTML_UNDO_H
 
 #define HTML_UNDO_LIMIT 1024
+#define HTML_UNDO_BUDGET (4 * 1024 * 1024)
 
 #include "htmlundo-action.h"
 #include "htmlenums.h"
@@ -31,6 +32,11 @@
 struct _HTMLUndoData {
 	HTMLUndoDataDestroyFunc destroy;
 	gint ref_count;
+
+	/* optional, absorbs a following action of the same kind into this one */
+	HTMLUndoDataMergeFunc merge;
+	/* bytes retained by the data, counted against the undo budget */
+	gsize size;
 };
 
 HTMLUndo *html_undo_new              (void);
@@ -57,6 +63,10 @@ void      html_undo_level_begin      (HTMLUndo          *undo,
 void      html_undo_level_end        (HTMLUndo          *undo,
 				      HTMLEngine	*engine);
 gint      html_undo_get_step_count   (HTMLUndo          *undo);
+void      html_undo_mark_saved       (HTMLUndo          *undo);
+gsize     html_undo_get_size         (HTMLUndo          *undo);
+void      html_undo_set_budget       (HTMLUndo          *undo,
+				      gsize              budget);
 void      html_undo_freeze           (HTMLUndo          *undo);
 void      html_undo_thaw             (HTMLUndo          *undo);
 /*
@@ -12,10 +12,13 @@
 #include "htmlengine-edit-movement.h"
 #include "htmlengine-edit-text.h"
 #include "htmlengine-save.h"
+#include "htmlengine-search.h"
 #include "htmlselection.h"
 #include "htmltable.h"
 #include "htmltablecell.h"
 #include "htmltext.h"
+#include "htmltilecache.h"
+#include "htmlundo.h"
 
 typedef struct {
 	const gchar *name;
@@ -31,16 +34,25 @@ static gint test_cursor_left_right_on_lines_boundaries_wo_white (GtkHTML *html);
 static gint test_cursor_around_containers (GtkHTML *html);
 static gint test_cursor_around_image (GtkHTML *html);
 static gint test_cursor_around_anchors (GtkHTML *html);
+static gint test_cursor_jump_to_position (GtkHTML *html);
+static gint test_cursor_jump_into_table_cell (GtkHTML *html);
 
 static gint test_quotes_in_div_block (GtkHTML *html);
 static gint test_quotes_in_table (GtkHTML *html);
 static gint test_capitalize_upcase_lowcase_word (GtkHTML *html);
 static gint test_delete_nested_cluevs_and_undo (GtkHTML *html);
+static gint test_undo_typed_words (GtkHTML *html);
+static gint test_undo_deleted_chars (GtkHTML *html);
+static gint test_undo_budget (GtkHTML *html);
+static gint test_undo_saved_merge (GtkHTML *html);
+static gint test_search_all (GtkHTML *html);
+static gint test_magic_links (GtkHTML *html);
 static gint test_insert_nested_cluevs (GtkHTML *html);
 static gint test_indentation_plain_text (GtkHTML *html);
 static gint test_indentation_plain_text_rtl (GtkHTML *html);
 static gint test_table_cell_parsing (GtkHTML *html);
 static gint test_delete_around_table (GtkHTML *html);
+static gint test_tile_cache_thaw (GtkHTML *html);
 
 static Test tests[] = {
 	{ "cursor movement", NULL },
@@ -53,16 +65,25 @@ static Test tests[] = {
 	{ "around containers", test_cursor_around_containers },
 	{ "around image", test_cursor_around_image },
 	{ "around anchors", test_cursor_around_anchors },
+	{ "jump to position", test_cursor_jump_to_position },
+	{ "jump into table cell", test_cursor_jump_into_table_cell },
 	{ "various fixed bugs", NULL },
 	{ "outer quotes inside div block", test_quotes_in_div_block },
 	{ "outer quotes inside table", test_quotes_in_table },
 	{ "capitalize, upcase/lowcase word", test_capitalize_upcase_lowcase_word },
 	{ "delete across nested cluev's and undo", test_delete_nested_cluevs_and_undo },
+	{ "undo typed words", test_undo_typed_words },
+	{ "undo deleted characters", test_undo_deleted_chars },
+	{ "undo budget", test_undo_budget },
+	{ "undo after save", test_undo_saved_merge },
+	{ "find all", test_search_all },
+	{ "magic links", test_magic_links },
 	{ "insert nested cluev's", test_insert_nested_cluevs },
 	{ "indentation in plain text", test_indentation_plain_text },
 	{ "indentation in plain text (RTL)", test_indentation_plain_text_rtl },
 	{ "table cell parsing", test_table_cell_parsing },
 	{ "delete around table", test_delete_around_table },
+	{ "tile cache after thaw", test_tile_cache_thaw },
 	{ NULL, NULL }
 };
 
@@ -130,6 +151,202 @@ static gint test_delete_nested_cluevs_and_undo (GtkHTML *html)
 	return TRUE;
 }
 
+static gint test_undo_typed_words (GtkHTML *html)
+{
+	const gchar *typed = "ab cd";
+
+	load_editable (html, "");
+
+	for (; *typed; typed ++)
+		html_engine_insert_text (html->engine, typed, 1);
+
+	html_engine_end_of_document (html->engine);
+	if (html->engine->cursor->position != 5)
+		return FALSE;
+
+	html_engine_undo (html->engine);
+	html_engine_end_of_document (html->engine);
+	if (html->engine->cursor->position != 3)
+		return FALSE;
+
+	html_engine_undo (html->engine);
+	html_engine_end_of_document (html->engine);
+	if (html->engine->cursor->position != 0)
+		return FALSE;
+
+	return TRUE;
+}
+
+static void delete_range (GtkHTML *html, gint from, gint to)
+{
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, from);
+	html_engine_set_mark (html->engine);
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, to);
+	html_engine_delete (html->engine);
+}
+
+static gint end_position (GtkHTML *html)
+{
+	html_engine_end_of_document (html->engine);
+
+	return html->engine->cursor->position;
+}
+
+static gint test_undo_deleted_chars (GtkHTML *html)
+{
+	load_editable (html, "abcdef");
+
+	/* backspaces merge into one step */
+	html_engine_end_of_document (html->engine);
+	gtk_html_command (html, "delete-back");
+	gtk_html_command (html, "delete-back");
+	gtk_html_command (html, "delete-back");
+	if (end_position (html) != 3)
+		return FALSE;
+
+	html_engine_undo (html->engine);
+	if (end_position (html) != 6 || html_undo_has_undo_steps (html->engine->undo))
+		return FALSE;
+
+	/* deleted selections do not */
+	delete_range (html, 4, 6);
+	delete_range (html, 2, 4);
+	if (end_position (html) != 2)
+		return FALSE;
+
+	html_engine_undo (html->engine);
+	if (end_position (html) != 4)
+		return FALSE;
+
+	html_engine_undo (html->engine);
+	if (end_position (html) != 6)
+		return FALSE;
+
+	return TRUE;
+}
+
+static gint test_undo_budget (GtkHTML *html)
+{
+	HTMLUndo *undo;
+	gsize size;
+
+	load_editable (html, "abcdefgh");
+	undo = html->engine->undo;
+
+	delete_range (html, 6, 8);
+	delete_range (html, 4, 6);
+	delete_range (html, 2, 4);
+	size = html_undo_get_size (undo);
+
+	/* only the newest step fits */
+	html_undo_set_budget (undo, 1);
+	if (html_undo_get_size (undo) >= size)
+		goto out;
+
+	html_engine_undo (html->engine);
+	if (end_position (html) != 4)
+		goto out;
+
+	html_engine_undo (html->engine);
+	if (end_position (html) != 4)
+		goto out;
+
+	html_undo_set_budget (undo, HTML_UNDO_BUDGET);
+
+	return TRUE;
+out:
+	html_undo_set_budget (undo, HTML_UNDO_BUDGET);
+
+	return FALSE;
+}
+
+static gint test_undo_saved_merge (GtkHTML *html)
+{
+	load_editable (html, "");
+
+	html_engine_insert_text (html->engine, "a", 1);
+	html_engine_insert_text (html->engine, "b", 1);
+	html_engine_saved (html->engine);
+	if (!html_engine_is_saved (html->engine))
+		return FALSE;
+
+	/* would merge into the typed word */
+	html_engine_insert_text (html->engine, "c", 1);
+	if (html_engine_is_saved (html->engine))
+		return FALSE;
+
+	html_engine_undo (html->engine);
+	if (!html_engine_is_saved (html->engine) || end_position (html) != 2)
+		return FALSE;
+
+	return TRUE;
+}
+
+static void search_all_wait (HTMLEngine *e)
+{
+	while (e->thaw_idle_id || !html_engine_search_all_done (e))
+		g_main_context_iteration (NULL, TRUE);
+}
+
+static gint test_search_all (GtkHTML *html)
+{
+	const HTMLSearchMatch *match;
+
+	load_editable (html, "abc x abc<br>abcabc");
+
+	html_engine_search_all (html->engine, "abc", FALSE, FALSE, FALSE);
+	search_all_wait (html->engine);
+	if (html_engine_search_all_get_count (html->engine) != 4)
+		return FALSE;
+
+	match = html_engine_search_all_get_match (html->engine, 1);
+	if (!match || match->start_pos != 6 || match->stop_pos != 9)
+		return FALSE;
+
+	/* the edited flow is searched again */
+	html_engine_beginning_of_document (html->engine);
+	html_engine_insert_text (html->engine, "abc", 3);
+	search_all_wait (html->engine);
+	if (html_engine_search_all_get_count (html->engine) != 5)
+		return FALSE;
+
+	html_engine_search_all_clear (html->engine);
+
+	return html_engine_search_all_get_count (html->engine) == 0;
+}
+
+static gint test_magic_links (GtkHTML *html)
+{
+	const gchar *typed = "see www.gnome.org ";
+	Link *link;
+
+	gtk_html_set_magic_links (html, TRUE);
+
+	/* typed, the word is linked when the space follows it */
+	load_editable (html, "");
+	for (; *typed; typed ++)
+		html_engine_insert_text (html->engine, typed, 1);
+	html_engine_beginning_of_document (html->engine);
+	if (!HTML_IS_TEXT (html->engine->cursor->object)
+	    || !HTML_TEXT (html->engine->cursor->object)->links)
+		return FALSE;
+	link = g_ptr_array_index (HTML_TEXT (html->engine->cursor->object)->links, 0);
+	if (strcmp (link->url, "http://www.gnome.org") || link->start_offset != 4 || link->end_offset != 17)
+		return FALSE;
+
+	/* pasted */
+	load_editable (html, "");
+	html_engine_insert_text (html->engine, "mail me@example.com or ftp.gnome.org", -1);
+	html_engine_beginning_of_document (html->engine);
+	if (!HTML_IS_TEXT (html->engine->cursor->object)
+	    || !HTML_TEXT (html->engine->cursor->object)->links
+	    || HTML_TEXT (html->engine->cursor->object)->links->len != 2)
+		return FALSE;
+	link = g_ptr_array_index (HTML_TEXT (html->engine->cursor->object)->links, 0);
+
+	return !strcmp (link->url, "mailto:me@example.com");
+}
+
 static gint test_insert_nested_cluevs (GtkHTML *html)
 {
 	load_editable (html, "text");
@@ -239,6 +456,53 @@ static gint test_cursor_around_image (GtkHTML *html)
 	return TRUE;
 }
 
+static gint test_cursor_jump_to_position (GtkHTML *html)
+{
+	load_editable (html, "abc<p>def<p>ghi");
+
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 9);
+	if (html->engine->cursor->position != 9 || html->engine->cursor->offset != 1
+	    || html_cursor_get_current_char (html->engine->cursor) != 'h')
+		return FALSE;
+
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 5);
+	if (html->engine->cursor->position != 5 || html->engine->cursor->offset != 1
+	    || html_cursor_get_current_char (html->engine->cursor) != 'e')
+		return FALSE;
+
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 0);
+	if (html->engine->cursor->position != 0 || html->engine->cursor->offset != 0
+	    || html_cursor_get_current_char (html->engine->cursor) != 'a')
+		return FALSE;
+
+	return TRUE;
+}
+
+static gint test_cursor_jump_into_table_cell (GtkHTML *html)
+{
+	load_editable (html, "ab<table><tr><td>cd</td><td>ef</td></tr></table>gh");
+
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 8);
+	if (html->engine->cursor->position != 8 || html->engine->cursor->offset != 1
+	    || html_cursor_get_current_char (html->engine->cursor) != 'f'
+	    || !HTML_IS_TABLE_CELL (html->engine->cursor->object->parent->parent))
+		return FALSE;
+
+	html_engine_end_of_document (html->engine);
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 5);
+	if (html->engine->cursor->position != 5 || html->engine->cursor->offset != 1
+	    || html_cursor_get_current_char (html->engine->cursor) != 'd'
+	    || !HTML_IS_TABLE_CELL (html->engine->cursor->object->parent->parent))
+		return FALSE;
+
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 12);
+	if (html->engine->cursor->position != 12 || html->engine->cursor->offset != 1
+	    || html_cursor_get_current_char (html->engine->cursor) != 'h')
+		return FALSE;
+
+	return TRUE;
+}
+
 static gint test_cursor_around_anchors (GtkHTML *html)
 {
 	load_editable (html, "<pre>a<a name=anchor>b");
@@ -723,6 +987,46 @@ test_table_cell_parsing (GtkHTML *html)
 	return TRUE;
 }
 
+static gint
+test_tile_cache_thaw (GtkHTML *html)
+{
+	HTMLEngine *e = html->engine;
+	gint rv = FALSE;
+
+	/* tiles need a window to be rendered to */
+	gtk_widget_show_all (gtk_widget_get_toplevel (GTK_WIDGET (html)));
+	gtk_html_set_editable (html, FALSE);
+	gtk_html_load_from_string (html, "<p>abc</p>", -1);
+	gtk_html_set_tile_cache (html, TRUE);
+	while (gtk_events_pending ())
+		gtk_main_iteration ();
+
+	html_tile_cache_draw (e->tile_cache, 0, 0, 1, 1);
+	if (html_tile_cache_get_size (e->tile_cache) == 0)
+		goto out;
+
+	/* nothing changed, the tile stays */
+	html_engine_freeze (e);
+	html_engine_thaw (e);
+	html_engine_thaw_idle_flush (e);
+	if (html_tile_cache_get_size (e->tile_cache) == 0)
+		goto out;
+
+	/* draws queued while frozen drop it */
+	html_engine_freeze (e);
+	html_engine_draw (e, 0, 0, 1, 1);
+	html_engine_thaw (e);
+	html_engine_thaw_idle_flush (e);
+	if (html_tile_cache_get_size (e->tile_cache) != 0)
+		goto out;
+
+	rv = TRUE;
+out:
+	gtk_html_set_tile_cache (html, FALSE);
+
+	return rv;
+}
+
 gint main (gint argc, gchar *argv[])
 {
 	GtkWidget *win, *sw, *html_widget;